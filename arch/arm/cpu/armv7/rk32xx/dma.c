@@ -1683,4 +1683,202 @@ int rk_pl330_dmac_deinit(int dmac_id)
 }
 
 
+#ifdef CONFIG_RK_DMA_MEMCPY
+/*
+ * Memory to memory copies on a dmac channel, for the big moves at boot
+ * (kernel, ramdisk). The copy runs while the cpu goes on with the boot,
+ * dma_wait() has to be called before the destination is used. bootm
+ * runs with interrupts off, so dma_wait() polls the dmac itself.
+ *
+ * The channel moves 16 x 64-bit bursts and a burst must not cross a 4K
+ * page, so only the 128 byte aligned middle of a copy goes to the dmac,
+ * head and tail are copied by the cpu. Copies the dmac can't take are
+ * done right away with memmove.
+ */
+#define RK_DMA_MEMCPY_CHN	DMACH_DMAC2_MEMTOMEM
+#define RK_DMA_MEMCPY_BURST	(8 * 16)
+#define RK_DMA_MEMCPY_CHUNK	(1 << 20)
+#define RK_DMA_MEMCPY_MAX	8
+#define RK_DMA_MEMCPY_TIMEOUT	1000	/* ms without progress */
+
+#ifndef CONFIG_RK_DMA_MEMCPY_MIN
+#define CONFIG_RK_DMA_MEMCPY_MIN	(256 << 10)
+#endif
+
+struct rk_dma_memcpy {
+	void		*dst;
+	const void	*src;
+	size_t		len;
+};
+
+static struct rk_dma_client rk_dma_memcpy_client = {
+	.name = "rk-dma-memcpy",
+};
+
+static int rk_dma_memcpy_chn = -1;	/* -1: not requested, -2: unavailable */
+static struct rk_dma_memcpy rk_dma_memcpy_q[RK_DMA_MEMCPY_MAX];
+static int rk_dma_memcpy_num;
+static volatile int rk_dma_memcpy_pending;
+static volatile int rk_dma_memcpy_err;
+
+static void rk_dma_memcpy_done(void *token, int size,
+		enum rk_dma_buffresult result)
+{
+	if (result != RK_RES_OK)
+		rk_dma_memcpy_err = 1;
+	if (rk_dma_memcpy_pending > 0)
+		rk_dma_memcpy_pending--;
+}
+
+static int rk_dma_memcpy_get_chn(void)
+{
+	if (rk_dma_memcpy_chn != -1)
+		return rk_dma_memcpy_chn;
+
+	rk_dma_memcpy_chn = -2;
+	if (rk_dma_request(RK_DMA_MEMCPY_CHN, &rk_dma_memcpy_client, NULL) < 0)
+		return rk_dma_memcpy_chn;
+
+	rk_dma_config(RK_DMA_MEMCPY_CHN, 8, 16);
+	rk_dma_set_buffdone_fn(RK_DMA_MEMCPY_CHN, rk_dma_memcpy_done);
+	rk_dma_memcpy_chn = RK_DMA_MEMCPY_CHN;
+
+	return rk_dma_memcpy_chn;
+}
+
+/* run the dmac event handler by hand, it is what the irq would do */
+static void rk_dma_memcpy_poll(void)
+{
+	struct rk_pl330_chan *ch = id_to_chan(RK_DMA_MEMCPY_CHN);
+	int flag;
+
+	if (!ch || !ch->dmac)
+		return;
+
+	flag = disable_interrupts();
+	pl330_update(ch->dmac->pi);
+	if (flag)
+		enable_interrupts();
+}
+
+/* the dmac irq takes the count down, change it with the irq masked */
+static void rk_dma_memcpy_pending_add(int n)
+{
+	int flag;
+
+	flag = disable_interrupts();
+	rk_dma_memcpy_pending += n;
+	if (flag)
+		enable_interrupts();
+}
+
+static bool rk_dma_memcpy_overlap(const void *a, size_t alen,
+		const void *b, size_t blen)
+{
+	return ((ulong)a < (ulong)b + blen) && ((ulong)b < (ulong)a + alen);
+}
+
+void dma_memcpy_async(void *dst, const void *src, size_t len)
+{
+	struct rk_dma_memcpy *q;
+	size_t head, body, off, n;
+	int i;
+
+	if (len < CONFIG_RK_DMA_MEMCPY_MIN
+			|| (((ulong)dst ^ (ulong)src) & (RK_DMA_MEMCPY_BURST - 1))
+			|| rk_dma_memcpy_overlap(dst, len, src, len)
+			|| rk_dma_memcpy_get_chn() < 0) {
+		memmove(dst, src, len);
+		return;
+	}
+
+	/* a copy must not race with one already queued */
+	for (i = 0; i < rk_dma_memcpy_num; i++) {
+		q = &rk_dma_memcpy_q[i];
+		if (rk_dma_memcpy_overlap(dst, len, q->dst, q->len)
+				|| rk_dma_memcpy_overlap(dst, len, q->src, q->len)
+				|| rk_dma_memcpy_overlap(src, len, q->dst, q->len))
+			break;
+	}
+	if (i < rk_dma_memcpy_num || rk_dma_memcpy_num == RK_DMA_MEMCPY_MAX)
+		dma_wait();
+
+	head = -(ulong)dst & (RK_DMA_MEMCPY_BURST - 1);
+	body = (len - head) & ~(RK_DMA_MEMCPY_BURST - 1);
+	memcpy(dst, src, head);
+	memcpy(dst + head + body, src + head + body, len - head - body);
+
+	/* source out to memory, no dirty line left over the destination */
+	flush_dcache_range((ulong)src + head, (ulong)src + head + body);
+	flush_dcache_range((ulong)dst + head, (ulong)dst + head + body);
+
+	q = &rk_dma_memcpy_q[rk_dma_memcpy_num++];
+	q->dst = dst + head;
+	q->src = src + head;
+	q->len = body;
+
+	for (off = 0; off < body; off += n) {
+		n = min_t(size_t, body - off, RK_DMA_MEMCPY_CHUNK);
+		rk_dma_devconfig(RK_DMA_MEMCPY_CHN, RK_DMASRC_MEMTOMEM,
+				(ulong)q->src + off);
+		/*
+		 * counted before the enqueue: on a running channel the chunk
+		 * may be done before rk_dma_enqueue() returns
+		 */
+		rk_dma_memcpy_pending_add(1);
+		if (rk_dma_enqueue(RK_DMA_MEMCPY_CHN, NULL,
+				(dma_addr_t)(ulong)q->dst + off, n) < 0) {
+			rk_dma_memcpy_pending_add(-1);
+			rk_dma_memcpy_err = 1;
+			break;
+		}
+	}
+	rk_dma_ctrl(RK_DMA_MEMCPY_CHN, RK_DMAOP_START);
+}
+
+int dma_wait(void)
+{
+	struct rk_dma_memcpy *q;
+	ulong start = get_timer(0);
+	int pending = rk_dma_memcpy_pending;
+	int i, flag;
+
+	if (rk_dma_memcpy_num == 0)
+		return 0;
+
+	while (rk_dma_memcpy_pending) {
+		rk_dma_memcpy_poll();
+		if (rk_dma_memcpy_pending != pending) {
+			pending = rk_dma_memcpy_pending;
+			start = get_timer(0);
+		} else if (get_timer(start) > RK_DMA_MEMCPY_TIMEOUT) {
+			rk_dma_ctrl(RK_DMA_MEMCPY_CHN, RK_DMAOP_STOP);
+			rk_dma_ctrl(RK_DMA_MEMCPY_CHN, RK_DMAOP_FLUSH);
+			flag = disable_interrupts();
+			rk_dma_memcpy_pending = 0;
+			if (flag)
+				enable_interrupts();
+			rk_dma_memcpy_err = 1;
+		}
+	}
+
+	for (i = 0; i < rk_dma_memcpy_num; i++) {
+		q = &rk_dma_memcpy_q[i];
+		/* drop whatever was speculated in while the dmac wrote */
+		invalidate_dcache_range((ulong)q->dst, (ulong)q->dst + q->len);
+		if (rk_dma_memcpy_err)
+			memcpy(q->dst, q->src, q->len);
+	}
+
+	if (rk_dma_memcpy_err) {
+		rk_dma_dev_err("dma memcpy failed, copied by cpu");
+		rk_dma_memcpy_err = 0;
+	}
+	rk_dma_memcpy_num = 0;
+
+	return 0;
+}
+#endif /* CONFIG_RK_DMA_MEMCPY */
+
+
 #endif /* CONFIG_RK_DMAC */
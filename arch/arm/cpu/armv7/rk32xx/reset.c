@@ -57,12 +57,12 @@ void reset_cpu(ulong ignored)
 	disable_interrupts();
 	FW_NandDeInit();
 
-#ifndef CONFIG_SYS_L2CACHE_OFF
-	v7_outer_cache_disable();
-#endif
 #ifndef CONFIG_SYS_DCACHE_OFF
 	flush_dcache_all();
 #endif
+#ifndef CONFIG_SYS_L2CACHE_OFF
+	v7_outer_cache_disable();
+#endif
 #ifndef CONFIG_SYS_ICACHE_OFF
 	invalidate_icache_all();
 #endif
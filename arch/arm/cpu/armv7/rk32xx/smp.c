@@ -0,0 +1,273 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <common.h>
+#include <malloc.h>
+#include <linux/sizes.h>
+#include <asm/io.h>
+#include <asm/system.h>
+#include <asm/arch/rkplat.h>
+#include <rk_smp.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * The cortex-a7 secondary cores of rk3036/rk312x wait in the bootrom
+ * after their reset: once 0xDEADBEAF is at imem + 4 they jump to the
+ * address at imem + 8, that is rk_smp_entry, which turns on the mmu and
+ * caches as cpu0 has them and runs rk_smp_worker().
+ */
+#define RK_SMP_MAGIC		0xDEADBEAF
+#define RK_SMP_MAILBOX_MAGIC	(RKIO_IMEM_PHYS + 4)
+#define RK_SMP_MAILBOX_ENTRY	(RKIO_IMEM_PHYS + 8)
+
+/* core soft resets in softrst con0 */
+#if defined(CONFIG_RKCHIP_RK3036)
+#define RK_SMP_CORE_SRST(cpu)	(cpu)
+#else
+#define RK_SMP_CORE_SRST(cpu)	(4 + (cpu))
+#endif
+
+#define RK_SMP_CORES		4
+#define RK_SMP_STACK_SIZE	SZ_16K
+#define RK_SMP_TIMEOUT		10	/* ms for a core to come up or park */
+
+#define ACTLR_SMP		(1 << 6)
+
+enum {
+	RK_SMP_OFF = 0,
+	RK_SMP_ON,
+	RK_SMP_PARK,
+};
+
+struct rk_smp_core {
+	struct rk_smp_job *volatile job;	/* set by cpu0, cleared by the core */
+	volatile int state;
+
+	/* written by the core with its dcache off, so on a line of its own */
+	volatile u32 off __aligned(ARCH_DMA_MINALIGN);
+} __aligned(ARCH_DMA_MINALIGN);
+
+/* read by rk_smp_entry with the mmu off, keep in sync with smp_entry.S */
+struct rk_smp_boot {
+	u32 ttbr0;
+	u32 dacr;
+	u32 sctlr;
+	u32 vbar;
+	u32 gd;
+	u32 sp[RK_SMP_CORES];
+} __aligned(ARCH_DMA_MINALIGN);
+
+struct rk_smp_boot rk_smp_boot;
+static struct rk_smp_core rk_smp_cores[RK_SMP_CORES];
+static int rk_smp_ncores = 1;
+static bool rk_smp_started;
+
+extern void rk_smp_entry(void);
+extern void rk_smp_cpu_off(volatile u32 *off);
+
+#define rk_smp_mb()	__asm__ __volatile__ ("dmb" : : : "memory")
+#define rk_smp_sev()	__asm__ __volatile__ ("dsb\n\tsev" : : : "memory")
+#define rk_smp_wfe()	__asm__ __volatile__ ("wfe" : : : "memory")
+
+/*
+ * The workers share dram with cpu0 through the caches: the sections have
+ * to be shareable for the a7 to keep them coherent between the cores.
+ * The cache policy is the one of the weak version in cache-cp15.c.
+ */
+void dram_bank_mmu_setup(int bank)
+{
+	bd_t *bd = gd->bd;
+	int i;
+
+	for (i = bd->bi_dram[bank].start >> 20;
+	     i < (bd->bi_dram[bank].start >> 20) + (bd->bi_dram[bank].size >> 20);
+	     i++) {
+#if defined(CONFIG_SYS_ARM_CACHE_WRITETHROUGH)
+		set_section_dcache(i, DCACHE_WRITETHROUGH | RK_SMP_SECT_SHARED);
+#elif defined(CONFIG_SYS_ARM_CACHE_WRITEALLOC)
+		set_section_dcache(i, DCACHE_WRITEALLOC | RK_SMP_SECT_SHARED);
+#else
+		set_section_dcache(i, DCACHE_WRITEBACK | RK_SMP_SECT_SHARED);
+#endif
+	}
+}
+
+static inline u32 rk_smp_get_actlr(void)
+{
+	u32 val;
+
+	asm volatile("mrc p15, 0, %0, c1, c0, 1" : "=r" (val));
+	return val;
+}
+
+/* number of cores of the cluster, from the a7 L2CTLR */
+static inline int rk_smp_get_ncores(void)
+{
+	u32 val;
+
+	asm volatile("mrc p15, 1, %0, c9, c0, 2" : "=r" (val));
+	return ((val >> 24) & 0x3) + 1;
+}
+
+static void rk_smp_cpu_reset(int cpu, bool assert)
+{
+	u32 bit = RK_SMP_CORE_SRST(cpu);
+
+	cru_writel((1 << (bit + 16)) | ((assert ? 1 : 0) << bit), CRU_SOFTRSTS_CON(0));
+}
+
+void rk_smp_worker(int cpu)
+{
+	struct rk_smp_core *core = &rk_smp_cores[cpu];
+	struct rk_smp_job *job;
+
+	core->state = RK_SMP_ON;
+	rk_smp_sev();
+
+	for (;;) {
+		job = core->job;
+		if (job != NULL) {
+			job->fn(job->arg);
+			rk_smp_mb();
+			core->job = NULL;
+			job->busy = 0;
+			rk_smp_sev();
+			continue;
+		}
+		if (core->state == RK_SMP_PARK)
+			break;
+		rk_smp_wfe();
+	}
+
+	rk_smp_cpu_off(&core->off);
+}
+
+int rk_smp_init(void)
+{
+	ulong start;
+	void *stack;
+	int cpu, n;
+
+	if (rk_smp_started)
+		return 0;
+	rk_smp_started = true;
+
+	/* the workers only see cpu0's data through coherent caches */
+	if (!dcache_status() || !(rk_smp_get_actlr() & ACTLR_SMP)) {
+		printf("smp: no coherency, secondary cores stay off\n");
+		return -1;
+	}
+
+	n = min(rk_smp_get_ncores(), RK_SMP_CORES);
+	if (n < 2)
+		return 0;
+
+	asm volatile("mrc p15, 0, %0, c2, c0, 0" : "=r" (rk_smp_boot.ttbr0));
+	asm volatile("mrc p15, 0, %0, c3, c0, 0" : "=r" (rk_smp_boot.dacr));
+	asm volatile("mrc p15, 0, %0, c12, c0, 0" : "=r" (rk_smp_boot.vbar));
+	rk_smp_boot.sctlr = get_cr();
+	rk_smp_boot.gd = (u32)gd;
+	for (cpu = 1; cpu < n; cpu++) {
+		stack = memalign(ARCH_DMA_MINALIGN, RK_SMP_STACK_SIZE);
+		if (stack == NULL)
+			return -1;
+		rk_smp_boot.sp[cpu] = (u32)stack + RK_SMP_STACK_SIZE;
+	}
+	flush_dcache_range((ulong)&rk_smp_boot,
+			   (ulong)&rk_smp_boot + roundup(sizeof(rk_smp_boot), ARCH_DMA_MINALIGN));
+
+	for (cpu = 1; cpu < n; cpu++) {
+		rk_smp_cpu_reset(cpu, true);
+		udelay(10);
+		rk_smp_cpu_reset(cpu, false);
+	}
+	/* let the cores get to the bootrom wfe */
+	mdelay(1);
+
+	writel((u32)rk_smp_entry, RK_SMP_MAILBOX_ENTRY);
+	writel(RK_SMP_MAGIC, RK_SMP_MAILBOX_MAGIC);
+	rk_smp_sev();
+
+	start = get_timer(0);
+	for (cpu = 1; cpu < n; cpu++) {
+		while (rk_smp_cores[cpu].state != RK_SMP_ON && get_timer(start) < RK_SMP_TIMEOUT)
+			;
+		if (rk_smp_cores[cpu].state != RK_SMP_ON) {
+			printf("smp: cpu%d did not come up\n", cpu);
+			rk_smp_cpu_reset(cpu, true);
+			continue;
+		}
+		rk_smp_ncores = cpu + 1;
+	}
+	debug("smp: %d cores\n", rk_smp_ncores);
+
+	return 0;
+}
+
+void rk_smp_submit(struct rk_smp_job *job)
+{
+	struct rk_smp_core *core;
+	int cpu;
+
+	/* the cores only come up for the boots that have work for them */
+	rk_smp_init();
+
+	job->busy = 1;
+	for (cpu = 1; cpu < rk_smp_ncores; cpu++) {
+		core = &rk_smp_cores[cpu];
+		if (core->state == RK_SMP_ON && core->job == NULL) {
+			rk_smp_mb();
+			core->job = job;
+			rk_smp_sev();
+			return;
+		}
+	}
+
+	/* every core is busy or off */
+	job->fn(job->arg);
+	job->busy = 0;
+}
+
+void rk_smp_wait(struct rk_smp_job *job)
+{
+	while (job->busy)
+		rk_smp_wfe();
+	rk_smp_mb();
+}
+
+void rk_smp_park(void)
+{
+	struct rk_smp_core *core;
+	ulong start;
+	int cpu;
+
+	for (cpu = 1; cpu < rk_smp_ncores; cpu++) {
+		core = &rk_smp_cores[cpu];
+		if (core->state == RK_SMP_OFF)
+			continue;
+
+		while (core->job != NULL)
+			rk_smp_wfe();
+		core->state = RK_SMP_PARK;
+		rk_smp_sev();
+
+		/* the core cleans its dcache before it writes off */
+		start = get_timer(0);
+		do {
+			invalidate_dcache_range((ulong)&core->off,
+						(ulong)&core->off + ARCH_DMA_MINALIGN);
+		} while (!core->off && get_timer(start) < RK_SMP_TIMEOUT);
+		if (!core->off)
+			printf("smp: cpu%d did not park\n", cpu);
+
+		rk_smp_cpu_reset(cpu, true);
+		core->state = RK_SMP_OFF;
+	}
+	rk_smp_ncores = 1;
+
+	/* the kernel releases the cores through the mailbox again */
+	writel(0, RK_SMP_MAILBOX_MAGIC);
+}
@@ -0,0 +1,94 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <common.h>
+#include <rk_task.h>
+
+/*
+ * The rk timer runs without a tick interrupt, so nothing preempts: due
+ * steps run whenever the boot code yields, and the timer only tells
+ * when a step is due. Tasks are kept in wake time order.
+ */
+
+static LIST_HEAD(rk_task_list);
+static int rk_task_running;
+
+/* wrap safe: timer_get_boot_us() wraps with ulong, at 2^32 us */
+static inline bool rk_task_due(struct rk_task *task, ulong now)
+{
+	return (long)(now - task->wake_us) >= 0;
+}
+
+static void rk_task_queue(struct rk_task *task, ulong us)
+{
+	struct rk_task *t;
+
+	task->wake_us = timer_get_boot_us() + us;
+	list_for_each_entry(t, &rk_task_list, list) {
+		if ((long)(t->wake_us - task->wake_us) > 0)
+			break;
+	}
+	list_add_tail(&task->list, &t->list);
+}
+
+/* run one step of task, requeue it unless it is done */
+static void rk_task_run(struct rk_task *task)
+{
+	ulong us;
+
+	rk_task_running++;
+	us = task->step(task);
+	rk_task_running--;
+
+	if (us)
+		rk_task_queue(task, us);
+	else
+		debug("task %s done at %luus\n", task->name, timer_get_boot_us());
+}
+
+void rk_task_start(struct rk_task *task)
+{
+	INIT_LIST_HEAD(&task->list);
+	task->state = 0;
+	rk_task_run(task);
+}
+
+void rk_task_yield(void)
+{
+	struct rk_task *task;
+
+	/* steps must not nest: one may yield inside a driver it calls */
+	if (rk_task_running)
+		return;
+
+	while (!list_empty(&rk_task_list)) {
+		task = list_first_entry(&rk_task_list, struct rk_task, list);
+		if (!rk_task_due(task, timer_get_boot_us()))
+			break;
+		list_del_init(&task->list);
+		rk_task_run(task);
+	}
+}
+
+void rk_task_mdelay(ulong msec)
+{
+	ulong end = timer_get_boot_us() + msec * 1000;
+
+	while ((long)(timer_get_boot_us() - end) < 0)
+		rk_task_yield();
+}
+
+void rk_task_wait(struct rk_task *task)
+{
+	/* a task that was never started has a zeroed list */
+	while (task->list.next && !list_empty(&task->list))
+		rk_task_yield();
+}
+
+void rk_task_wait_all(void)
+{
+	while (!list_empty(&rk_task_list))
+		rk_task_yield();
+}
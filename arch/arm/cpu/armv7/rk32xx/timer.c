@@ -93,12 +93,16 @@ static inline unsigned long long usec_to_tcount(unsigned long long usec)
 static inline unsigned long get_current_timer_value(void)
 {
 	unsigned long now = rk_timer_get_curr_count();
+	unsigned long last = gd->arch.tbl;
 
 	if (gd->arch.lastinc >= now) {
 		gd->arch.tbl -= (gd->arch.lastinc - now);
 	} else {/* count down timer underflow */
 		gd->arch.tbl -= (TIMER_LOAD_VAL + gd->arch.lastinc - now);
 	}
+	/* borrow out of tbl, tbu:tbl is the 64 bit count */
+	if (gd->arch.tbl > last)
+		gd->arch.tbu--;
 	gd->arch.lastinc = now;
 
 	return gd->arch.tbl;
@@ -120,6 +124,7 @@ void reset_timer_masked(void)
 	/* init the gd->arch.lastinc and gd->arch.tbl value */
 	gd->arch.lastinc = rk_timer_get_curr_count();	/* Monotonic decrementing timer */
 	gd->arch.tbl = 0;	/* Last decremneter snapshot, start "advancing" time stamp from 0 */
+	gd->arch.tbu = 0;
 }
 
 
@@ -170,6 +175,26 @@ void __udelay(unsigned long usec)
 }
 
 
+/*
+ * usec since timer_init(), for bootstage. Taken from the 64 bit tbu:tbl
+ * count, so the result only wraps at 2^32 us (~71 min).
+ */
+ulong timer_get_boot_us(void)
+{
+	unsigned long long tcount;
+
+	/* not counting yet */
+	if (gd->arch.lastinc == 0)
+		return 0;
+
+	tcount = get_current_timer_value();
+	tcount = 0 - (((unsigned long long)gd->arch.tbu << 32) | tcount);
+	do_div(tcount, TIMER_FREQ / 1000000);
+
+	return (ulong)tcount;
+}
+
+
 unsigned long get_timer_masked(void)
 {
 	return tcount_to_tick(get_current_timer_value());
@@ -1511,6 +1511,8 @@ int pl330_submit_req(void *ch_id, struct pl330_req *r)
 	thrd->lstenq = idx;
 	thrd->req[idx].mc_len = _setup_req(0, thrd, idx, &xs);
 	thrd->req[idx].r = r;
+	/* the dmac fetches the microcode from memory */
+	flush_cache((unsigned long)thrd->req[idx].mc_cpu, thrd->req[idx].mc_len);
 
 	ret = 0;
 
@@ -181,6 +181,29 @@ void __udelay(unsigned long usec)
 }
 
 
+/*
+ * usec since timer_init(), for bootstage. tbl is 64 bit here, the result
+ * only wraps with ulong.
+ */
+ulong timer_get_boot_us(void)
+{
+	uint64_t tcount;
+
+	/* not counting yet */
+	if (gd->arch.lastinc == 0)
+		return 0;
+
+#ifdef CONFIG_RKTIMER_INCREMENTER
+	tcount = get_current_timer_value();
+#else
+	tcount = 0 - get_current_timer_value();
+#endif
+	do_div(tcount, TIMER_FREQ / 1000000);
+
+	return (ulong)tcount;
+}
+
+
 ulong get_timer_masked(void)
 {
 	return tcount_to_tick(get_current_timer_value());
@@ -18,6 +18,8 @@
 #include <u-boot/zlib.h>
 #include <asm/byteorder.h>
 #include <libfdt.h>
+#include <dma_memcpy.h>
+#include <rk_smp.h>
 #include <fdt_support.h>
 #include <asm/bootm.h>
 #include <asm/secure.h>
@@ -83,6 +85,9 @@ static void announce_and_cleanup(int fake)
 #ifdef CONFIG_USB_DEVICE
 	udc_disconnect();
 #endif
+	/* ramdisk copy from boot_ramdisk_high() */
+	dma_wait();
+	rk_smp_park();
 	cleanup_before_linux();
 }
 
@@ -0,0 +1,93 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <linux/compiler.h>
+
+/*
+ * memcpy for armv8, built with -mgeneral-regs-only: 64 bytes per loop in
+ * eight x registers, which the compiler turns into ldp/stp pairs, with the
+ * source prefetched a few lines ahead. Only aligned 64-bit accesses are
+ * made, so it is also safe on device memory before the mmu is up. Each
+ * block is loaded before it is stored, so a forward copy to a lower,
+ * overlapping address is fine (memmove relies on it).
+ */
+
+#define MEMCPY_PREFETCH		256
+
+void *memcpy(void *dest, const void *src, size_t count)
+{
+	u8 *d = dest;
+	const u8 *s = src;
+
+	if (d == s)
+		return dest;
+
+	if (count >= 64) {
+		const u64 *sw;
+		u64 *dw;
+		unsigned int shift;
+
+		while ((unsigned long)d & 7) {
+			*d++ = *s++;
+			count--;
+		}
+
+		dw = (u64 *)d;
+		shift = ((unsigned long)s & 7) * 8;
+		if (shift == 0) {
+			sw = (const u64 *)s;
+			for (; count >= 64; count -= 64) {
+				u64 a = sw[0], b = sw[1], c = sw[2], e = sw[3];
+				u64 f = sw[4], g = sw[5], h = sw[6], i = sw[7];
+
+				__builtin_prefetch(sw + MEMCPY_PREFETCH / 8);
+				dw[0] = a; dw[1] = b; dw[2] = c; dw[3] = e;
+				dw[4] = f; dw[5] = g; dw[6] = h; dw[7] = i;
+				sw += 8;
+				dw += 8;
+			}
+			for (; count >= 8; count -= 8)
+				*dw++ = *sw++;
+		} else {
+			/*
+			 * source and destination are not co-aligned: read
+			 * aligned words and merge neighbours (little endian).
+			 * The last word read is the one holding the final
+			 * source byte, it never crosses into another page.
+			 */
+			u64 lo, hi;
+
+			sw = (const u64 *)((unsigned long)s & ~7UL);
+			lo = *sw++;
+			for (; count >= 32; count -= 32) {
+				u64 a = sw[0], b = sw[1], c = sw[2], e = sw[3];
+
+				__builtin_prefetch(sw + MEMCPY_PREFETCH / 8);
+				dw[0] = (lo >> shift) | (a << (64 - shift));
+				dw[1] = (a >> shift) | (b << (64 - shift));
+				dw[2] = (b >> shift) | (c << (64 - shift));
+				dw[3] = (c >> shift) | (e << (64 - shift));
+				lo = e;
+				sw += 4;
+				dw += 4;
+			}
+			for (; count >= 8; count -= 8) {
+				hi = *sw++;
+				*dw++ = (lo >> shift) | (hi << (64 - shift));
+				lo = hi;
+			}
+			sw--;
+		}
+		d = (u8 *)dw;
+		s = (const u8 *)sw + (shift / 8);
+	}
+
+	while (count--)
+		*d++ = *s++;
+
+	return dest;
+}
@@ -0,0 +1,51 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <linux/compiler.h>
+
+/*
+ * memmove on top of the arch memcpy, which copies forward and loads ahead
+ * of its stores: that is safe unless dest starts inside src, so only that
+ * case takes the backward loop here.
+ */
+void *memmove(void *dest, const void *src, size_t count)
+{
+	unsigned long d = (unsigned long)dest;
+	unsigned long s = (unsigned long)src;
+
+	/* dest below src, or no overlap at all */
+	if (d - s >= count)
+		return memcpy(dest, src, count);
+
+	d += count;
+	s += count;
+	if (((d ^ s) & (sizeof(long) - 1)) == 0) {
+		while (count && (d & (sizeof(long) - 1))) {
+			*(u8 *)--d = *(const u8 *)--s;
+			count--;
+		}
+		for (; count >= 4 * sizeof(long); count -= 4 * sizeof(long)) {
+			const unsigned long *sw = (const unsigned long *)s - 4;
+			unsigned long *dw = (unsigned long *)d - 4;
+			unsigned long a = sw[3], b = sw[2], c = sw[1], e = sw[0];
+
+			dw[3] = a; dw[2] = b; dw[1] = c; dw[0] = e;
+			d -= 4 * sizeof(long);
+			s -= 4 * sizeof(long);
+		}
+		for (; count >= sizeof(long); count -= sizeof(long)) {
+			d -= sizeof(long);
+			s -= sizeof(long);
+			*(unsigned long *)d = *(const unsigned long *)s;
+		}
+	}
+
+	while (count--)
+		*(u8 *)--d = *(const u8 *)--s;
+
+	return dest;
+}
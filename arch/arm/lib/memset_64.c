@@ -0,0 +1,44 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <linux/compiler.h>
+
+/*
+ * memset for armv8: aligned 64-bit stores, 64 bytes per loop, so the
+ * framebuffer and bss clears go out as stp pairs.
+ */
+void *memset(void *s, int c, size_t count)
+{
+	u8 *d = s;
+	u64 v, *dw;
+
+	if (count >= 64) {
+		while ((unsigned long)d & 7) {
+			*d++ = c;
+			count--;
+		}
+
+		v = (u8)c;
+		v |= v << 8;
+		v |= v << 16;
+		v |= v << 32;
+		dw = (u64 *)d;
+		for (; count >= 64; count -= 64) {
+			dw[0] = v; dw[1] = v; dw[2] = v; dw[3] = v;
+			dw[4] = v; dw[5] = v; dw[6] = v; dw[7] = v;
+			dw += 8;
+		}
+		for (; count >= 8; count -= 8)
+			*dw++ = v;
+		d = (u8 *)dw;
+	}
+
+	while (count--)
+		*d++ = c;
+
+	return s;
+}
@@ -16,6 +16,42 @@ static	uint16   *RSK_KEY;
 extern void P_RC4(unsigned char * buf, unsigned short len);
 
 
+/*
+ * Boot image hash stream.
+ *
+ * rk_load_image_from_storage() hands every chunk of kernel/ramdisk/second to
+ * the hash as soon as it has been read, so the digest is ready when the load
+ * finishes and the image check does not walk the whole image a second time.
+ * With the crypto engine, the hash dma of one chunk runs while the next chunk
+ * is read from storage.
+ */
+#define BOOTIMG_HASH_IDLE	0
+#define BOOTIMG_HASH_RUNNING	1
+#define BOOTIMG_HASH_DONE	2
+
+static struct {
+	uint32 state;
+	uint32 section;
+	rk_boot_img_hdr *hdr;
+#ifndef SECUREBOOT_CRYPTO_EN
+	SHA_CTX ctx;
+#endif
+	uint32 digest[8];
+} gBootImageHash;
+
+
+/* take the digest streamed for this header, NULL if the image has to be hashed from ram */
+static uint8 *SecureBootImageHashResult(rk_boot_img_hdr *boothdr)
+{
+	if ((gBootImageHash.state != BOOTIMG_HASH_DONE) || (gBootImageHash.hdr != boothdr)) {
+		return NULL;
+	}
+
+	gBootImageHash.state = BOOTIMG_HASH_IDLE;
+	return (uint8 *)gBootImageHash.digest;
+}
+
+
 static bool SecureNSModeVerifyLoader(RK28BOOT_HEAD *hdr)
 {
 #define RSA_KEY_OFFSET 0x10//according to dumped data, the key is here.
@@ -229,6 +265,19 @@ static bool SecureNSModeBootImageShaCheck(rk_boot_img_hdr *boothdr)
 }
 
 
+static bool SecureNSModeBootImageDigestCheck(rk_boot_img_hdr *boothdr)
+{
+	uint8 *sha = SecureBootImageHashResult(boothdr);
+
+	/* digest already computed while the image was loaded */
+	if (sha != NULL) {
+		return !memcmp(boothdr->id, sha, SHA_DIGEST_SIZE);
+	}
+
+	return SecureNSModeBootImageShaCheck(boothdr);
+}
+
+
 static bool SecureNSModeVerifyBootImageSign(rk_boot_img_hdr* boothdr)
 {
 	/* verify boot/recovery image */
@@ -301,7 +350,7 @@ static bool SecureNSModeBootImageCheck(rk_boot_img_hdr *hdr, int unlocked)
 	/* if sha checking boot image, it will take time */
 #if defined(CONFIG_BOOTRK_OTA_IMAGE_CHECK) || defined(SECUREBOOT_CRYPTO_EN)
 	/* check image sha, make sure image is ok. */
-	if (!SecureNSModeBootImageShaCheck(boothdr)) {
+	if (!SecureNSModeBootImageDigestCheck(boothdr)) {
 		printf("boot/recovery image sha mismatch!\n");
 		return false;
 	}
@@ -801,32 +850,39 @@ static bool SecureRKModeVerifyBootImage(rk_boot_img_hdr *boothdr)
 }
 #endif
 
-	size = boothdr->kernel_size + sizeof(boothdr->kernel_size) \
-		+ boothdr->ramdisk_size + sizeof(boothdr->ramdisk_size) \
-		+ boothdr->second_size + sizeof(boothdr->second_size) \
-		+ sizeof(boothdr->tags_addr) + sizeof(boothdr->page_size) \
-		+ sizeof(boothdr->unused) + sizeof(boothdr->name) + sizeof(boothdr->cmdline);
-
-	CryptoRSAInit((uint32*)(boothdr->rsaHash), pkeyHead->RSA_N, pkeyHead->RSA_E, pkeyHead->RSA_C);
-	CryptoSHAInit(size, 160);
-
-	/* Android image. */
-	CryptoSHAStart((uint32 *)(unsigned long)boothdr->kernel_addr, boothdr->kernel_size);
-	CryptoSHAStart((uint32 *)&boothdr->kernel_size, sizeof(boothdr->kernel_size));
-	CryptoSHAStart((uint32 *)(unsigned long)boothdr->ramdisk_addr, boothdr->ramdisk_size);
-	CryptoSHAStart((uint32 *)&boothdr->ramdisk_size, sizeof(boothdr->ramdisk_size));
-	CryptoSHAStart((uint32 *)(unsigned long)boothdr->second_addr, boothdr->second_size);
-	CryptoSHAStart((uint32 *)&boothdr->second_size, sizeof(boothdr->second_size));
-
-	/* only rockchip's image add. */
-	CryptoSHAStart((uint32 *)&boothdr->tags_addr, sizeof(boothdr->tags_addr));
-	CryptoSHAStart((uint32 *)&boothdr->page_size, sizeof(boothdr->page_size));
-	CryptoSHAStart((uint32 *)&boothdr->unused, sizeof(boothdr->unused));
-	CryptoSHAStart((uint32 *)&boothdr->name, sizeof(boothdr->name));
-	CryptoSHAStart((uint32 *)&boothdr->cmdline, sizeof(boothdr->cmdline));
-
-	CryptoSHAEnd(hwDataHash);
-	CryptoRSAEnd(rsaResult);
+	dataHash = SecureBootImageHashResult(boothdr);
+	if (dataHash != NULL) {
+		/* sha streamed while loading, rsa started by SecureModeBootImageHashBegin */
+		memcpy(hwDataHash, dataHash, sizeof(hwDataHash));
+		CryptoRSAEnd(rsaResult);
+	} else {
+		size = boothdr->kernel_size + sizeof(boothdr->kernel_size) \
+			+ boothdr->ramdisk_size + sizeof(boothdr->ramdisk_size) \
+			+ boothdr->second_size + sizeof(boothdr->second_size) \
+			+ sizeof(boothdr->tags_addr) + sizeof(boothdr->page_size) \
+			+ sizeof(boothdr->unused) + sizeof(boothdr->name) + sizeof(boothdr->cmdline);
+
+		CryptoRSAInit((uint32*)(boothdr->rsaHash), pkeyHead->RSA_N, pkeyHead->RSA_E, pkeyHead->RSA_C);
+		CryptoSHAInit(size, 160);
+
+		/* Android image. */
+		CryptoSHAStart((uint32 *)(unsigned long)boothdr->kernel_addr, boothdr->kernel_size);
+		CryptoSHAStart((uint32 *)&boothdr->kernel_size, sizeof(boothdr->kernel_size));
+		CryptoSHAStart((uint32 *)(unsigned long)boothdr->ramdisk_addr, boothdr->ramdisk_size);
+		CryptoSHAStart((uint32 *)&boothdr->ramdisk_size, sizeof(boothdr->ramdisk_size));
+		CryptoSHAStart((uint32 *)(unsigned long)boothdr->second_addr, boothdr->second_size);
+		CryptoSHAStart((uint32 *)&boothdr->second_size, sizeof(boothdr->second_size));
+
+		/* only rockchip's image add. */
+		CryptoSHAStart((uint32 *)&boothdr->tags_addr, sizeof(boothdr->tags_addr));
+		CryptoSHAStart((uint32 *)&boothdr->page_size, sizeof(boothdr->page_size));
+		CryptoSHAStart((uint32 *)&boothdr->unused, sizeof(boothdr->unused));
+		CryptoSHAStart((uint32 *)&boothdr->name, sizeof(boothdr->name));
+		CryptoSHAStart((uint32 *)&boothdr->cmdline, sizeof(boothdr->cmdline));
+
+		CryptoSHAEnd(hwDataHash);
+		CryptoRSAEnd(rsaResult);
+	}
 
 	dataHash = (uint8 *)hwDataHash;
 
@@ -1040,6 +1096,129 @@ static uint32 SecureRKModeInit(void)
 #endif /* SECUREBOOT_CRYPTO_EN */
 
 
+static void SecureBootImageHashData(void *data, uint32 len)
+{
+#ifndef SECUREBOOT_CRYPTO_EN
+	SHA_update(&gBootImageHash.ctx, data, len);
+#else
+	CryptoSHAStart((uint32 *)data, len);
+#endif
+}
+
+
+/*
+ * start hashing a boot image which is about to be loaded, return false if
+ * the image check will not need its sha and the loader can skip the updates.
+ */
+bool SecureModeBootImageHashBegin(rk_boot_img_hdr *boothdr)
+{
+#ifdef SECUREBOOT_CRYPTO_EN
+	uint32 size;
+	BOOT_HEADER *pkeyHead = (BOOT_HEADER *)g_rsa_key_buf;
+#endif
+
+	gBootImageHash.state = BOOTIMG_HASH_IDLE;
+
+#ifdef SECUREBOOT_CRYPTO_EN
+	/* rk mode only verify signed image */
+	if ((SecureMode == SBOOT_MODE_RK) && (boothdr->signTag != SECURE_BOOT_SIGN_TAG)) {
+		return false;
+	}
+#elif !defined(CONFIG_BOOTRK_OTA_IMAGE_CHECK)
+	/* no sha check of boot image without crypto or ota check */
+	return false;
+#endif
+
+	gBootImageHash.hdr = boothdr;
+	gBootImageHash.section = 0;
+
+#ifndef SECUREBOOT_CRYPTO_EN
+	SHA_init(&gBootImageHash.ctx);
+#else
+	size = boothdr->kernel_size + sizeof(boothdr->kernel_size) \
+		+ boothdr->ramdisk_size + sizeof(boothdr->ramdisk_size) \
+		+ boothdr->second_size + sizeof(boothdr->second_size) \
+		+ sizeof(boothdr->tags_addr) + sizeof(boothdr->page_size) \
+		+ sizeof(boothdr->unused) + sizeof(boothdr->name) + sizeof(boothdr->cmdline);
+
+	/* rsa flushes the hash engine, so it has to be started first, it runs during the load */
+	if (SecureMode == SBOOT_MODE_RK) {
+		CryptoRSAInit((uint32*)(boothdr->rsaHash), pkeyHead->RSA_N, pkeyHead->RSA_E, pkeyHead->RSA_C);
+	}
+	CryptoSHAInit(size, 160);
+#endif
+
+	gBootImageHash.state = BOOTIMG_HASH_RUNNING;
+
+	return true;
+}
+
+
+/* hash a chunk of kernel/ramdisk/second, chunks must come in image order */
+void SecureModeBootImageHashUpdate(void *data, uint32 len)
+{
+	if (gBootImageHash.state == BOOTIMG_HASH_RUNNING) {
+		SecureBootImageHashData(data, len);
+	}
+}
+
+
+/* kernel/ramdisk/second data done, its size follows it in the hash */
+void SecureModeBootImageHashNext(void)
+{
+	rk_boot_img_hdr *boothdr = gBootImageHash.hdr;
+
+	if (gBootImageHash.state != BOOTIMG_HASH_RUNNING) {
+		return;
+	}
+
+	switch (gBootImageHash.section++) {
+	case 0:
+		SecureBootImageHashData(&boothdr->kernel_size, sizeof(boothdr->kernel_size));
+		break;
+	case 1:
+		SecureBootImageHashData(&boothdr->ramdisk_size, sizeof(boothdr->ramdisk_size));
+		break;
+	case 2:
+		SecureBootImageHashData(&boothdr->second_size, sizeof(boothdr->second_size));
+		break;
+	default:
+		break;
+	}
+}
+
+
+void SecureModeBootImageHashEnd(void)
+{
+	rk_boot_img_hdr *boothdr = gBootImageHash.hdr;
+
+	if (gBootImageHash.state != BOOTIMG_HASH_RUNNING) {
+		return;
+	}
+
+	/* not a complete image, the check hashes it from ram */
+	if (gBootImageHash.section != 3) {
+		gBootImageHash.state = BOOTIMG_HASH_IDLE;
+		return;
+	}
+
+	/* rockchip's image add information. */
+	SecureBootImageHashData(&boothdr->tags_addr, sizeof(boothdr->tags_addr));
+	SecureBootImageHashData(&boothdr->page_size, sizeof(boothdr->page_size));
+	SecureBootImageHashData(&boothdr->unused, sizeof(boothdr->unused));
+	SecureBootImageHashData(&boothdr->name, sizeof(boothdr->name));
+	SecureBootImageHashData(&boothdr->cmdline, sizeof(boothdr->cmdline));
+
+#ifndef SECUREBOOT_CRYPTO_EN
+	memcpy(gBootImageHash.digest, SHA_final(&gBootImageHash.ctx), SHA_DIGEST_SIZE);
+#else
+	CryptoSHAEnd(gBootImageHash.digest);
+#endif
+
+	gBootImageHash.state = BOOTIMG_HASH_DONE;
+}
+
+
 bool SecureModeVerifyLoader(RK28BOOT_HEAD *hdr)
 {
 #ifdef SECUREBOOT_CRYPTO_EN
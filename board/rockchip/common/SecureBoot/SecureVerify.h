@@ -13,6 +13,10 @@ bool SecureModeVerifyLoader(RK28BOOT_HEAD *hdr);
 bool SecureModeVerifyUbootImage(second_loader_hdr *pHead);
 bool SecureModeVerifyBootImage(rk_boot_img_hdr *pHead);
 bool SecureModeBootImageCheck(rk_boot_img_hdr *hdr, int unlocked);
+bool SecureModeBootImageHashBegin(rk_boot_img_hdr *boothdr);
+void SecureModeBootImageHashUpdate(void *data, uint32 len);
+void SecureModeBootImageHashNext(void);
+void SecureModeBootImageHashEnd(void);
 bool SecureModeRSAKeyCheck(uint8 *pKey);
 void SecureModeLockLoader(void);
 uint32 SecureModeInit(void);
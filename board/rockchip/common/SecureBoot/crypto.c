@@ -6,6 +6,9 @@
  */
 #include "../config.h"
 #include "SecureBoot.h"
+#include <hw_sha.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
 
 #ifdef SECUREBOOT_CRYPTO_EN
 
@@ -170,6 +173,12 @@ int32 CryptoRSAStart(uint32 *AddrM, uint32 *AddrN, uint32 *AddrE, uint32 *AddrC)
 }
 
 
+int32 CryptoRSAPoll(void)
+{
+	return (CryptoReg->CRYPTO_CTRL & 0x10) ? CRYPTO_JOB_BUSY : CRYPTO_JOB_DONE;
+}
+
+
 int32 CryptoRSAEnd(uint32 *result)
 {
 	int32 i;
@@ -220,6 +229,231 @@ int32 CryptoRSAVerify(BOOT_HEADER *pHead, uint32 SigOffset)
 	return OK;
 }
 
+/*
+ * Hash jobs.
+ *
+ * A job hashes a message of known length handed in as several segments.
+ * Segments are queued in a ring, the hash dma of the next one is started
+ * from the crypto irq as soon as the previous one is done, or from
+ * CryptoHashJobPoll() when there is no irq. The cpu is free while the
+ * engine reads the data. There is one engine, so one job at a time, and
+ * the CryptoSHA* calls above must not be used while a job is running.
+ */
+static CRYPTO_HASH_JOB *gCryptoHashJob = NULL;
+
+#if defined(CONFIG_USE_IRQ) && defined(IRQ_CRYPTO)
+#define CRYPTO_HASH_IRQ
+#endif
+
+/* retire the finished segment and start the next queued one */
+static void CryptoHashKick(CRYPTO_HASH_JOB *job)
+{
+	CRYPTO_HASH_SEG *seg;
+
+	if (job->Busy) {
+		if (CryptoReg->CRYPTO_CTRL & 0x08)
+			return;
+		job->Tail = (job->Tail + 1) % CRYPTO_HASH_SEGS;
+		job->Busy = 0;
+	}
+
+	if (job->Tail == job->Head)
+		return;
+
+	seg = &job->Seg[job->Tail];
+	job->Busy = 1;
+	CryptoReg->CRYPTO_INTSTS = (0x1<<4);
+	CryptoReg->CRYPTO_HRDMAS = (uint32)(unsigned long)seg->Data;
+	CryptoReg->CRYPTO_HRDMAL = ((seg->Len+3)>>2);
+	CryptoReg->CRYPTO_CTRL = (0x8<<16 | 0x8);
+}
+
+#ifdef CRYPTO_HASH_IRQ
+static void CryptoHashIsr(void *arg)
+{
+	if (CryptoReg->CRYPTO_INTSTS & (0x1<<4)) {
+		CryptoReg->CRYPTO_INTSTS = (0x1<<4);
+		if (gCryptoHashJob != NULL)
+			CryptoHashKick(gCryptoHashJob);
+	}
+}
+#endif
+
+
+int32 CryptoHashJobStart(CRYPTO_HASH_JOB *job, uint32 MsgLen, int hash_bits)
+{
+	/* an empty message never sets the hash done bit */
+	if ((gCryptoHashJob != NULL) || (MsgLen == 0))
+		return ERROR;
+
+	memset(job, 0, sizeof(CRYPTO_HASH_JOB));
+	job->MsgLen = MsgLen;
+	gCryptoHashJob = job;
+
+	CryptoSHAInit(MsgLen, hash_bits);
+#ifdef CRYPTO_HASH_IRQ
+	CryptoReg->CRYPTO_INTSTS = (0x1<<4);
+	CryptoReg->CRYPTO_INTENA |= (0x1<<4);
+#endif
+
+	return OK;
+}
+
+
+/*
+ * Queue a segment, the engine reads it after this returns, so it has to stay
+ * untouched until the job ends. All but the last segment must be whole words.
+ */
+int32 CryptoHashJobSubmit(CRYPTO_HASH_JOB *job, const void *data, uint32 len)
+{
+	uint32 next;
+	int flag;
+
+	if (len == 0)
+		return OK;
+	if (((unsigned long)data & 3) || (job->Submitted + len > job->MsgLen)
+			|| ((len & 3) && (job->Submitted + len != job->MsgLen)))
+		return ERROR;
+
+	flush_cache((unsigned long)data, len);
+
+	next = (job->Head + 1) % CRYPTO_HASH_SEGS;
+	while (next == job->Tail)
+		CryptoHashJobPoll(job);
+
+	job->Seg[job->Head].Data = (uint32 *)data;
+	job->Seg[job->Head].Len = len;
+	job->Submitted += len;
+	job->Head = next;
+
+	/* with the dma running, the irq or the next poll picks it up */
+	flag = disable_interrupts();
+	if (!job->Busy)
+		CryptoHashKick(job);
+	if (flag)
+		enable_interrupts();
+
+	return OK;
+}
+
+
+int32 CryptoHashJobPoll(CRYPTO_HASH_JOB *job)
+{
+#ifndef CRYPTO_HASH_IRQ
+	CryptoHashKick(job);
+#else
+	int flag;
+
+	/* irq may be masked by the caller, else it must not kick the job too */
+	flag = disable_interrupts();
+	if (job->Busy && !(CryptoReg->CRYPTO_CTRL & 0x08))
+		CryptoHashIsr(NULL);
+	if (flag)
+		enable_interrupts();
+#endif
+
+	if (job->Busy || (job->Tail != job->Head) || (job->Submitted != job->MsgLen))
+		return CRYPTO_JOB_BUSY;
+
+	return CryptoReg->CRYPTO_HASH_STS ? CRYPTO_JOB_DONE : CRYPTO_JOB_BUSY;
+}
+
+
+/* segments queued and not yet read by the engine, the running one included */
+uint32 CryptoHashJobPending(CRYPTO_HASH_JOB *job)
+{
+	CryptoHashJobPoll(job);
+
+	return (job->Head + CRYPTO_HASH_SEGS - job->Tail) % CRYPTO_HASH_SEGS;
+}
+
+
+int32 CryptoHashJobEnd(CRYPTO_HASH_JOB *job, uint32 *result)
+{
+	int32 i;
+
+	if (job->Submitted != job->MsgLen) {
+		CryptoHashJobAbort(job);
+		return ERROR;
+	}
+
+	while (CryptoHashJobPoll(job) == CRYPTO_JOB_BUSY)
+		;
+
+	for (i = 0; i < 8; i++)
+		*result++ = CryptoReg->CRYPTO_HASH_DOUT[i];
+
+	CryptoHashJobAbort(job);
+	return OK;
+}
+
+
+void CryptoHashJobAbort(CRYPTO_HASH_JOB *job)
+{
+	if (gCryptoHashJob != job)
+		return;
+
+	while (CryptoReg->CRYPTO_CTRL & 0x08);
+#ifdef CRYPTO_HASH_IRQ
+	CryptoReg->CRYPTO_INTENA &= ~(0x1<<4);
+#endif
+	CryptoReg->CRYPTO_INTSTS = (0x1<<4);
+	gCryptoHashJob = NULL;
+}
+
+
+/*
+ * Hash a buffer on the engine in chunk_size segments for hw_sha1/hw_sha256.
+ * ERROR when the engine can't take it: an empty or unaligned buffer, the
+ * hash dma reads whole words from a word address, or a job in progress.
+ */
+static int32 CryptoHashBuffer(const uchar *in_addr, uint buflen, uchar *out_addr,
+		uint chunk_size, int hash_bits, uint digest_size)
+{
+	CRYPTO_HASH_JOB job;
+	uint32 result[8];
+	uint32 len;
+
+	chunk_size &= ~3;
+	if (chunk_size == 0)
+		chunk_size = CHUNKSZ_SHA1;
+
+	if (((unsigned long)in_addr & 3) || (CryptoHashJobStart(&job, buflen, hash_bits) != OK))
+		return ERROR;
+
+	while (buflen) {
+		len = min(buflen, chunk_size);
+		if (CryptoHashJobSubmit(&job, in_addr, len) != OK) {
+			CryptoHashJobAbort(&job);
+			return ERROR;
+		}
+		in_addr += len;
+		buflen -= len;
+		WATCHDOG_RESET();
+	}
+
+	if (CryptoHashJobEnd(&job, result) != OK)
+		return ERROR;
+	memcpy(out_addr, result, digest_size);
+
+	return OK;
+}
+
+
+void hw_sha1(const uchar *in_addr, uint buflen, uchar *out_addr, uint chunk_size)
+{
+	if (CryptoHashBuffer(in_addr, buflen, out_addr, chunk_size, 160, SHA_DIGEST_SIZE) != OK)
+		sha1_csum_wd(in_addr, buflen, out_addr, chunk_size);
+}
+
+
+void hw_sha256(const uchar *in_addr, uint buflen, uchar *out_addr, uint chunk_size)
+{
+	if (CryptoHashBuffer(in_addr, buflen, out_addr, chunk_size, 256, 32) != OK)
+		sha256_csum_wd(in_addr, buflen, out_addr, chunk_size);
+}
+
+
 /* define for check crypto hardware ok */
 #undef CRYPTO_HW_CHECK
 
@@ -277,6 +511,10 @@ static void CryptoHWCheckOK(void)
 void CryptoInit(void)
 {
 	rkclk_set_crypto_clk(CRYPTO_MAX_FREQ);
+#ifdef CRYPTO_HASH_IRQ
+	irq_install_handler(IRQ_CRYPTO, CryptoHashIsr, NULL);
+	irq_handler_enable(IRQ_CRYPTO);
+#endif
 #ifdef CRYPTO_HW_CHECK
 	CryptoHWCheckOK();
 #endif
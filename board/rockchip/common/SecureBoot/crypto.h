@@ -10,6 +10,25 @@
 
 #include "SecureBoot.h"
 
+#define CRYPTO_JOB_DONE		0
+#define CRYPTO_JOB_BUSY		1
+
+#define CRYPTO_HASH_SEGS	16
+
+typedef struct tagCRYPTO_HASH_SEG {
+	uint32 *Data;
+	uint32 Len;		/* bytes */
+} CRYPTO_HASH_SEG;
+
+typedef struct tagCRYPTO_HASH_JOB {
+	uint32 MsgLen;		/* bytes of the whole message */
+	uint32 Submitted;	/* bytes queued so far */
+	volatile uint32 Head;	/* next free segment */
+	volatile uint32 Tail;	/* segment in or waiting for dma */
+	volatile uint32 Busy;	/* hash dma of Seg[Tail] running */
+	CRYPTO_HASH_SEG Seg[CRYPTO_HASH_SEGS];
+} CRYPTO_HASH_JOB;
+
 extern int32 CryptoSHAInit(uint32 MsgLen, int hash_bits);
 extern int32 CryptoSHAStart(uint32 *data, uint32 DataLen);
 extern int32 CryptoSHAEnd(uint32 *result);
@@ -18,7 +37,15 @@ extern int32 CryptoRSAEnd(uint32 *result);
 extern int32 CryptoRSAInit(uint32 *AddrM, uint32 *AddrN, uint32 *AddrE, uint32 *AddrC);
 extern int32 CryptoRSAStart(uint32 *AddrM, uint32 *AddrN, uint32 *AddrE, uint32 *AddrC);
 extern int32 CryptoRSACheck(void);
+extern int32 CryptoRSAPoll(void);
 extern int32 CryptoRSAVerify(BOOT_HEADER *pHead, uint32 SigOffset);
 extern void CryptoInit(void);
 
+extern int32 CryptoHashJobStart(CRYPTO_HASH_JOB *job, uint32 MsgLen, int hash_bits);
+extern int32 CryptoHashJobSubmit(CRYPTO_HASH_JOB *job, const void *data, uint32 len);
+extern int32 CryptoHashJobPoll(CRYPTO_HASH_JOB *job);
+extern uint32 CryptoHashJobPending(CRYPTO_HASH_JOB *job);
+extern int32 CryptoHashJobEnd(CRYPTO_HASH_JOB *job, uint32 *result);
+extern void CryptoHashJobAbort(CRYPTO_HASH_JOB *job);
+
 #endif /* _CRYPTO_H */
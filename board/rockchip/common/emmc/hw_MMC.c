@@ -62,6 +62,41 @@ uint8 EMMC_MIDTbl[]=
 
 static uint8 _MMC_MID = 0;
 
+#if defined(CONFIG_RK_EMMC_HS200)
+/* tuning block pattern the card returns for CMD21 */
+static const uint8 _MMC_TuningBlk4Bit[64] =
+{
+    0xff, 0x0f, 0xff, 0x00, 0xff, 0xcc, 0xc3, 0xcc,
+    0xc3, 0x3c, 0xcc, 0xff, 0xfe, 0xff, 0xfe, 0xef,
+    0xff, 0xdf, 0xff, 0xdd, 0xff, 0xfb, 0xff, 0xfb,
+    0xbf, 0xff, 0x7f, 0xff, 0x77, 0xf7, 0xbd, 0xef,
+    0xff, 0xf0, 0xff, 0xf0, 0x0f, 0xfc, 0xcc, 0x3c,
+    0xcc, 0x33, 0xcc, 0xcf, 0xff, 0xef, 0xff, 0xee,
+    0xff, 0xfd, 0xff, 0xfd, 0xdf, 0xff, 0xbf, 0xff,
+    0xbb, 0xff, 0xf7, 0xff, 0xf7, 0x7f, 0x7b, 0xde,
+};
+
+static const uint8 _MMC_TuningBlk8Bit[128] =
+{
+    0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00, 0x00,
+    0xff, 0xff, 0xcc, 0xcc, 0xcc, 0x33, 0xcc, 0xcc,
+    0xcc, 0x33, 0x33, 0xcc, 0xcc, 0xcc, 0xff, 0xff,
+    0xff, 0xee, 0xff, 0xff, 0xff, 0xee, 0xee, 0xff,
+    0xff, 0xff, 0xdd, 0xff, 0xff, 0xff, 0xdd, 0xdd,
+    0xff, 0xff, 0xff, 0xbb, 0xff, 0xff, 0xff, 0xbb,
+    0xbb, 0xff, 0xff, 0xff, 0x77, 0xff, 0xff, 0xff,
+    0x77, 0x77, 0xff, 0x77, 0xbb, 0xdd, 0xee, 0xff,
+    0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00,
+    0x00, 0xff, 0xff, 0xcc, 0xcc, 0xcc, 0x33, 0xcc,
+    0xcc, 0xcc, 0x33, 0x33, 0xcc, 0xcc, 0xcc, 0xff,
+    0xff, 0xff, 0xee, 0xff, 0xff, 0xff, 0xee, 0xee,
+    0xff, 0xff, 0xff, 0xdd, 0xff, 0xff, 0xff, 0xdd,
+    0xdd, 0xff, 0xff, 0xff, 0xbb, 0xff, 0xff, 0xff,
+    0xbb, 0xbb, 0xff, 0xff, 0xff, 0x77, 0xff, 0xff,
+    0xff, 0x77, 0x77, 0xff, 0x77, 0xbb, 0xdd, 0xee,
+};
+#endif
+
 uint8 MMC_GetMID(void)
 {
     uint8 i;
@@ -354,6 +389,10 @@ static void _MMC_SwitchFunction(pSDM_CARD_INFO_T pCard)
         {
             pCard->capability = value;
         }
+        pCard->devType = pDataBuf[196];
+        pCard->relWrSecC = pDataBuf[222];
+        pCard->relWrEn = (pDataBuf[166] >> 2) & 0x1;
+        pCard->maxPackedWr = (pDataBuf[192] >= 6) ? pDataBuf[500] : 0;  //packed commands from eMMC 4.5
 		if(pCard->bootSize == 0)
         {
             pCard->bootSize = 1024;
@@ -567,6 +606,7 @@ static void _MMC_SwitchFunction(pSDM_CARD_INFO_T pCard)
             break;
         }
         pCard->workMode |= SDM_WIDE_BUS_MODE;
+        pCard->busWidth = wide;
         break;
     }while(1);
     return;
@@ -575,6 +615,240 @@ static void _MMC_SwitchFunction(pSDM_CARD_INFO_T pCard)
 
 
 
+#if defined(CONFIG_RK_EMMC_HS200)
+/****************************************************************/
+//_MMC_TuningPhase: sample read data at phase and check the CMD21
+//tuning block comes back intact
+/****************************************************************/
+static int32 _MMC_TuningPhase(pSDM_CARD_INFO_T pCard, uint32 phase)
+{
+    const uint8 *pPattern;
+    uint32       len;
+    uint32       status = 0;
+    int32        ret;
+
+    if (pCard->busWidth == BUS_WIDTH_8_BIT)
+    {
+        pPattern = _MMC_TuningBlk8Bit;
+        len = sizeof(_MMC_TuningBlk8Bit);
+    }
+    else
+    {
+        pPattern = _MMC_TuningBlk4Bit;
+        len = sizeof(_MMC_TuningBlk4Bit);
+    }
+
+    SDPAM_SetSamplePhase(pCard->cardId, phase);
+    memset(uncachebuf, 0, len);
+    ret = SDC_BusRequest(pCard->cardId,
+                         (MMC4_SEND_TUNING_BLOCK | SD_READ_OP | SD_RSP_R1 | WAIT_PREV),
+                         0,
+                         &status,
+                         len,
+                         len,
+                         uncachebuf);
+    if ((SDC_SUCCESS != ret) || memcmp(uncachebuf, pPattern, len))
+    {
+        return SDM_DATA_CRC_ERROR;
+    }
+
+    return SDM_SUCCESS;
+}
+
+/****************************************************************/
+//_MMC_ExecuteTuning: try every sample phase and settle in the middle
+//of the longest run of phases that read the tuning block correctly
+/****************************************************************/
+static int32 _MMC_ExecuteTuning(pSDM_CARD_INFO_T pCard, uint32 *pPhase)
+{
+    uint32 phase;
+    uint32 start = 0, len = 0;
+    uint32 bestStart = 0, bestLen = 0;
+
+    for (phase = 0; phase < SDPAM_SAMPLE_PHASES; phase++)
+    {
+        if (SDM_SUCCESS == _MMC_TuningPhase(pCard, phase))
+        {
+            if (len == 0)
+            {
+                start = phase;
+            }
+            len++;
+            if (len > bestLen)
+            {
+                bestStart = start;
+                bestLen = len;
+            }
+        }
+        else
+        {
+            len = 0;
+        }
+    }
+    eMMC_printk(3, "%s: window %d + %d\n", __FUNCTION__, bestStart, bestLen);
+    if (bestLen == 0)
+    {
+        return SDM_DATA_CRC_ERROR;
+    }
+
+    *pPhase = bestStart + (bestLen >> 1);
+    return _MMC_TuningPhase(pCard, *pPhase);
+}
+
+/****************************************************************/
+//_MMC_SwitchHS200: HS_TIMING to HS200 and raise the clock, a known
+//sample phase is only checked once, otherwise the phases are swept.
+//on failure the card goes back to high speed SDR
+/****************************************************************/
+static int32 _MMC_SwitchHS200(pSDM_CARD_INFO_T pCard, uint32 *pPhase)
+{
+    uint32 status = 0;
+    uint32 phase = *pPhase;
+    int32  ret;
+
+    ret = SDC_SendCommand(pCard->cardId, \
+                         (MMC4_SWITCH_FUNC | SD_NODATA_OP | SD_RSP_R1B | WAIT_PREV), \
+                         ((0x3 << 24) | (185 << 16) | (0x2 << 8)), \
+                         &status);
+    if ((SDC_SUCCESS != ret) || (status & (0x1 << 7)))
+    {
+        return SDM_SWITCH_ERROR;
+    }
+
+    SDPAM_SetDrvPhase(pCard->cardId, 180);
+    ret = SDC_UpdateCardFreq(pCard->cardId, MMC_HS200_FPP_FREQ);
+    if (SDC_SUCCESS == ret)
+    {
+        ret = SDC_SendCommand(pCard->cardId, (SD_SEND_STATUS | SD_NODATA_OP | SD_RSP_R1 | NO_WAIT_PREV), (pCard->rca << 16), &status);
+        if ((SDC_SUCCESS == ret) && (status & (0x1 << 7)))
+        {
+            ret = SDM_SWITCH_ERROR;
+        }
+    }
+    if (SDC_SUCCESS == ret)
+    {
+        if ((phase >= SDPAM_SAMPLE_PHASES) || (SDM_SUCCESS != _MMC_TuningPhase(pCard, phase)))
+        {
+            ret = _MMC_ExecuteTuning(pCard, &phase);
+        }
+    }
+    if (SDC_SUCCESS == ret)
+    {
+        *pPhase = phase;
+        pCard->tran_speed = MMC_HS200_FPP_FREQ;
+        pCard->workMode |= SDM_HS200_MODE;
+        return SDM_SUCCESS;
+    }
+
+    //back to high speed, commands still work on the slower clock
+    SDPAM_SetSamplePhase(pCard->cardId, 0);
+    SDPAM_SetDrvPhase(pCard->cardId, 0);
+    SDC_UpdateCardFreq(pCard->cardId, pCard->tran_speed);
+    SDC_SendCommand(pCard->cardId, \
+                    (MMC4_SWITCH_FUNC | SD_NODATA_OP | SD_RSP_R1B | WAIT_PREV), \
+                    ((0x3 << 24) | (185 << 16) | (0x1 << 8)), \
+                    &status);
+    return ret;
+}
+#endif
+
+#if defined(CONFIG_RK_EMMC_DDR52)
+/****************************************************************/
+//_MMC_SwitchDDR52: BUS_WIDTH to the DDR width of the current bus and
+//read EXT_CSD back over the DDR bus, on failure stay in SDR
+/****************************************************************/
+static int32 _MMC_SwitchDDR52(pSDM_CARD_INFO_T pCard)
+{
+    uint32 status = 0;
+    uint32 value = (pCard->busWidth == BUS_WIDTH_8_BIT) ? 0x6 : 0x5;
+    uint8 *pDataBuf = (uint8 *)uncachebuf;
+    int32  ret;
+
+    ret = SDC_SendCommand(pCard->cardId, \
+                         (MMC4_SWITCH_FUNC | SD_NODATA_OP | SD_RSP_R1B | WAIT_PREV), \
+                         ((0x3 << 24) | (183 << 16) | (value << 8)), \
+                         &status);
+    if ((SDC_SUCCESS != ret) || (status & (0x1 << 7)))
+    {
+        return SDM_SWITCH_ERROR;
+    }
+
+    SDC_SetDDRMode(pCard->cardId, TRUE);
+    SDPAM_SetDrvPhase(pCard->cardId, 90);
+    pDataBuf[183] = 0;
+    ret = SDC_BusRequest(pCard->cardId, 
+                         (MMC4_SEND_EXT_CSD | SD_READ_OP | SD_RSP_R1 | WAIT_PREV), 
+                         0, 
+                         &status, 
+                         512, 
+                         512, 
+                         uncachebuf);
+    if ((SDC_SUCCESS == ret) && (pDataBuf[183] == value))
+    {
+        pCard->workMode |= SDM_DDR_MODE;
+        return SDM_SUCCESS;
+    }
+
+    SDC_SetDDRMode(pCard->cardId, FALSE);
+    SDPAM_SetDrvPhase(pCard->cardId, 0);
+    SDC_SendCommand(pCard->cardId, \
+                    (MMC4_SWITCH_FUNC | SD_NODATA_OP | SD_RSP_R1B | WAIT_PREV), \
+                    ((0x3 << 24) | (183 << 16) | ((value - 0x4) << 8)), \
+                    &status);
+    return SDM_SWITCH_ERROR;
+}
+#endif
+
+/****************************************************************/
+//MMC_SwitchTiming: move a registered eMMC from high speed SDR to the
+//fastest bus timing both sides support, HS200 first, then DDR52.
+//pTiming: out SDM_TIMING_xxx the card is left in
+//pPhase:  in the sample phase found on an earlier boot or
+//         SDM_PHASE_UNTUNED, out the phase in use
+/****************************************************************/
+int32  MMC_SwitchTiming(void *pCardInfo, uint32 *pTiming, uint32 *pPhase)
+{
+    pSDM_CARD_INFO_T pCard = (pSDM_CARD_INFO_T)pCardInfo;
+    int32            ret = SDM_FUNC_NOT_SUPPORT;
+
+    *pTiming = SDM_TIMING_HS;
+    if (!(pCard->type & (MMC | eMMC2G))
+        || (pCard->specVer < MMC_SPEC_VER_40)
+        || !(pCard->workMode & SDM_HIGH_SPEED_MODE)
+        || !(pCard->workMode & SDM_WIDE_BUS_MODE)
+        || (pCard->workMode & (SDM_HS200_MODE | SDM_DDR_MODE)))
+    {
+        return ret;
+    }
+
+#if defined(CONFIG_RK_EMMC_HS200)
+    if ((pCard->devType & (0x1 << 4))    //HS200 at 1.8V I/O
+        && SDPAM_IsIo1V8(pCard->cardId))
+    {
+        ret = _MMC_SwitchHS200(pCard, pPhase);
+        if (SDM_SUCCESS == ret)
+        {
+            *pTiming = SDM_TIMING_HS200;
+            return ret;
+        }
+    }
+#endif
+#if defined(CONFIG_RK_EMMC_DDR52)
+    if ((pCard->devType & (0x1 << 2)) && (pCard->tran_speed == MMCHS_52_FPP_FREQ))    //DDR52 at 1.8V or 3V I/O
+    {
+        ret = _MMC_SwitchDDR52(pCard);
+        if (SDM_SUCCESS == ret)
+        {
+            *pTiming = SDM_TIMING_DDR52;
+            return ret;
+        }
+    }
+#endif
+
+    return ret;
+}
+
+
 /****************************************************************/
 //:MMC_AccessBootPartition
 //:Access boot partition or user area
@@ -22,6 +22,7 @@ int32  MMC_SwitchBoot(void *pCardInfo, uint32 enable, uint32 partition);
 int32  MMC_AccessBootPartition(void *pCardInfo, uint32 partition);
 int32  MMC_SetBootBusWidth(void *pCardInfo, uint32 enable, HOST_BUS_WIDTH_E width);
 uint8 MMC_GetMID(void);
+int32  MMC_SwitchTiming(void *pCardInfo, uint32 *pTiming, uint32 *pPhase);
 
 #endif //end of #ifndef _MMCP_API_H
 
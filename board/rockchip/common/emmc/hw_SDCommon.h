@@ -171,6 +171,7 @@ $Log: hw_SDCommon.h,v $
 #define MMC4_SEND_EXT_CSD       SD_CMD8
 #define MMC4_BUSTEST_R          SD_CMD14
 #define MMC4_BUSTEST_W          SD_CMD19
+#define MMC4_SEND_TUNING_BLOCK  SD_CMD21    //HS200 tuning block, MMC4.5
 
 #define COMMAND_CLASS_7         (0x1 << 7)  //Command Class 7:lock card
 
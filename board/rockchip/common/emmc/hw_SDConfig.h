@@ -72,6 +72,13 @@ $Log: hw_SDConfig.h,v $
 
 #endif /* CONFIG_RK_MMC_DMA */
 
+/* reads the IDMAC moves while the cpu goes on, ended by the controller interrupt */
+#if (EN_SDC_INTERAL_DMA) && defined(CONFIG_USE_IRQ)
+#define EN_SDC_ASYNC          (1)
+#else
+#define EN_SDC_ASYNC          (0)
+#endif
+
 
 #define EN_SD_PRINTF          (0)      //ǷSDڲϢӡ1:ӡ0:رմӡ
 #define DEBOUNCE_TIME         (25)     //βʱ,λms
@@ -88,6 +95,7 @@ $Log: hw_SDConfig.h,v $
 #else
 #define MMCHS_52_FPP_FREQ     (40000)  //ģʽ֧52MHS-MMCڸģʽµĹƵʣλKHzЭ涨52MHz
 #endif
+#define MMC_HS200_FPP_FREQ    (150000) //HS200 working freq, KHz, spec max 200MHz
 
 #if(!EN_SD_PRINTF)
 #define SDOAM_Printf(...)
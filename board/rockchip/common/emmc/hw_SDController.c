@@ -159,6 +159,8 @@ static int32 _ChangeFreq(SDMMC_PORT_E nSDCPort, uint32 freqKHz)
     int32           timeOut = 0;
     int32           ret = SDC_SUCCESS;
     uint32          secondFreq;
+    uint32          clkInKHz = freqKHz;
+    uint32          ddr8 = FALSE;
 
     if (freqKHz == 0)//ƵʲΪ0ֳΪ0
     {
@@ -172,8 +174,19 @@ static int32 _ChangeFreq(SDMMC_PORT_E nSDCPort, uint32 freqKHz)
     }
 
 
+    //DDR 8bit needs cclk_in at twice the card clock, cclk_in is divided by 2 inside
+    if ((pReg->SDMMC_UHS_REG & UHS_DDR_MODE) && (pReg->SDMMC_CTYPE & BUS_8_BIT))
+    {
+        ddr8 = TRUE;
+        clkInKHz = freqKHz << 1;
+    }
+    //HS200 runs above 52MHz, cclk_in follows the card clock there
+    if (clkInKHz < MMCHS_52_FPP_FREQ)
+    {
+        clkInKHz = MMCHS_52_FPP_FREQ;
+    }
     //ȱ֤SDMMCcclk_in52MHzüĴܷɵ
-    suitMmcClkDiv = ahbFreq/MMCHS_52_FPP_FREQ + ( ((ahbFreq%MMCHS_52_FPP_FREQ)>0) ? 1: 0 );
+    suitMmcClkDiv = ahbFreq/clkInKHz + ( ((ahbFreq%clkInKHz)>0) ? 1: 0 );
     if(freqKHz < 12000) //Ƶ, 湩clkͲ̫,Ȼcmdݵhold time
     {
         suitMmcClkDiv = ahbFreq/freqKHz;
@@ -191,6 +204,10 @@ static int32 _ChangeFreq(SDMMC_PORT_E nSDCPort, uint32 freqKHz)
     {
         suitCclkInDiv++;  //1Ƶ֤ż
     }
+    if (ddr8 && (suitCclkInDiv < 2))
+    {
+        suitCclkInDiv = 2;
+    }
     Assert((suitCclkInDiv <= 510), "_ChangeFreq:no find suitable value\n", ahbFreq);
     if(suitCclkInDiv > 510)
     {
@@ -426,6 +443,7 @@ static int32 _WaitCardBusy(SDMMC_PORT_E       nSDCPort)
 static void _SDC0DMACallback(void)
 {
     gSDCInfo[SDC0].intInfo.transLen = gSDCInfo[SDC0].intInfo.desLen;
+    SDPAM_InvalidateCache(gSDCInfo[SDC0].intInfo.pBuf, gSDCInfo[SDC0].intInfo.desLen << 2);
 }
 
 /****************************************************************/
@@ -439,6 +457,7 @@ static void _SDC0DMACallback(void)
 static void _SDC1DMACallback(void)
 {
     gSDCInfo[SDC1].intInfo.transLen = gSDCInfo[SDC1].intInfo.desLen;
+    SDPAM_InvalidateCache(gSDCInfo[SDC1].intInfo.pBuf, gSDCInfo[SDC1].intInfo.desLen << 2);
 }
 #endif
 /****************************************************************/
@@ -452,6 +471,7 @@ static void _SDC1DMACallback(void)
 static void _SDC2DMACallback(void)
 {
     gSDCInfo[SDC2].intInfo.transLen = gSDCInfo[SDC2].intInfo.desLen;
+    SDPAM_InvalidateCache(gSDCInfo[SDC2].intInfo.pBuf, gSDCInfo[SDC2].intInfo.desLen << 2);
 }
 
 /****************************************************************/
@@ -565,6 +585,7 @@ static int32 _PrepareForReadData(SDMMC_PORT_E         nSDCPort, void *pDataBuf,
         gSDCInfo[nSDCPort].intInfo.desLen = (dataLen >> 2);
         gSDCInfo[nSDCPort].intInfo.transLen = 0;
         gSDCInfo[nSDCPort].intInfo.pBuf = (uint32 *)pDataBuf;
+        SDPAM_FlushCache(pDataBuf, dataLen);
         if(!SDPAM_DMAStart(nSDCPort, (uint32)pDataBuf, (uint32)pSDCFIFOADDR(nSDCPort), (dataLen >> 2), 0, cb))
         {
             Assert(0, "_PrepareForReadData:DMA busy\n", 0);
@@ -669,6 +690,10 @@ static int32 _ReadRemainData(SDMMC_PORT_E         nSDCPort, uint32 originalLen,
     return SDC_SUCCESS;
 }
 
+#if (EN_SDC_ASYNC)
+static void _AsyncIST(SDMMC_PORT_E nSDCPort);
+#endif
+
 /****************************************************************/
 //:_SDCISTHandle
 //:SDMMC controllerжϷ
@@ -691,6 +716,13 @@ static void _SDCISTHandle(SDMMC_PORT_E nSDCPort)
 #endif
     //eMMC_printk(5,"%s, %s  %d, ====irq callback===========\n",__FUNCTION__, __FILE__,__LINE__);
 
+#if (EN_SDC_ASYNC)
+    if (gSDCInfo[nSDCPort].async.state == SDC_ASYNC_RUNNING)
+    {
+        _AsyncIST(nSDCPort);
+        return;
+    }
+#endif
     value = pReg->SDMMC_MINTSTS;
 #if EN_SD_DMA
     if (value & (RXDR_INT | TXDR_INT))
@@ -1201,7 +1233,7 @@ int32 SDC_ResetController(int32 cardId)
 
     pReg->SDMMC_INTMASK = value;
 
-#if (EN_SD_INT || EN_SD_DATA_TRAN_INT)
+#if (EN_SD_INT || EN_SD_DATA_TRAN_INT || EN_SDC_ASYNC)
 #if(SD_CARD_Support)
     if(nSDCPort == SDC0)
     {
@@ -1217,8 +1249,11 @@ int32 SDC_ResetController(int32 cardId)
 	SDPAM_INTCRegISR(nSDCPort, _SDC2IST);	//eMMC controller	
     }
     SDPAM_INTCEnableIRQ(nSDCPort);
+#if (EN_SD_INT || EN_SD_DATA_TRAN_INT)
     pReg->SDMMC_CTRL = ENABLE_INT;
 #endif
+    //async reads turn ENABLE_INT on for their own time only
+#endif
 
     return SDC_SUCCESS;
 }
@@ -1313,6 +1348,54 @@ int32 SDC_WaitCardBusy(int32 cardId)
     return _WaitCardBusy(nSDCPort);
 }
 
+/****************************************************************/
+//SDC_SetDataSG: data of the following requests on cardId is moved from/to
+//the pieces in pSG instead of the request buffer, NULL goes back to plain
+//buffers. each piece must be 4 bytes aligned and a multiple of 512 bytes
+/****************************************************************/
+int32 SDC_SetDataSG(int32 cardId, pSDC_SG_T pSG, uint32 count)
+{
+#if (EN_SDC_INTERAL_DMA)
+    pSDC_INFO_T     pSDC= &gSDCInfo[(SDMMC_PORT_E)cardId];
+    uint32          i;
+
+    for (i=0; pSG && (i<count); i++)
+    {
+        if ((pSG[i].len == 0) || (pSG[i].len & 0x1FF) || ((uint32)(unsigned long)pSG[i].pBuf & 0x3))
+        {
+            return SDC_PARAM_ERROR;
+        }
+    }
+    pSDC->pSG = (pSG && count) ? pSG : NULL;
+    pSDC->SGCount = pSDC->pSG ? count : 0;
+    return SDC_SUCCESS;
+#else
+    return pSG ? SDC_PARAM_ERROR : SDC_SUCCESS;
+#endif
+}
+
+/****************************************************************/
+//SDC_SetDDRMode: switch the data lines of cardId between SDR and DDR,
+//the card clock is derived again before the next request
+/****************************************************************/
+int32 SDC_SetDDRMode(int32 cardId, uint32 enable)
+{
+    SDMMC_PORT_E nSDCPort = (SDMMC_PORT_E)cardId;
+    pSDC_REG_T   pReg = pSDCReg(nSDCPort);
+
+    if (enable)
+    {
+        pReg->SDMMC_UHS_REG |= UHS_DDR_MODE;
+    }
+    else
+    {
+        pReg->SDMMC_UHS_REG &= ~UHS_DDR_MODE;
+    }
+    gSDCInfo[nSDCPort].updateCardFreq = TRUE;
+
+    return SDC_SUCCESS;
+}
+
 #if (EN_SDC_INTERAL_DMA)
 static int32 SDC_StartCmd(pSDC_REG_T        pReg, uint32 cmd)
 {
@@ -1331,36 +1414,225 @@ static int32 SDC_StartCmd(pSDC_REG_T        pReg, uint32 cmd)
 }
 
 
-static int32 SDC_SetIDMADesc(SDMMC_PORT_E SDCPort, uint32 buffer, uint32  BufSize)
+/* where one IDMAC request is in its data buffers */
+typedef struct TagIDMA_CURSOR
+{
+    pSDC_SG_T   pSG;            //current piece
+    uint32      offset;         //offset in the current piece
+    uint32      remain;         //bytes not queued to the IDMAC yet
+    uint32      first;          //next descriptor is the first one of the request
+}IDMA_CURSOR_T;
+
+#if (EN_SDC_ASYNC)
+#define SDC_ASYNC_ERR_INT   (RTO_INT | DCRC_INT | DRTO_INT | SBE_INT | EBE_INT)
+
+static IDMA_CURSOR_T gIDMAAsyncCur[SDC_MAX];   //where the isr goes on with an async read
+#endif
+
+/****************************************************************/
+//SDC_SetIDMADesc: queue the data at pCur on descriptors [start, start + count),
+//the descriptors are chained as a ring. return the number of descriptors used
+/****************************************************************/
+static uint32 SDC_SetIDMADesc(SDMMC_PORT_E SDCPort, IDMA_CURSOR_T *pCur, uint32 start, uint32 count)
 {
     pSDC_INFO_T     pSDC= &gSDCInfo[SDCPort];
-    pSDC_REG_T      pReg = pSDC->pReg;
-    PSDMMC_DMA_DESC pDesc = (PSDMMC_DMA_DESC)&pSDC->IDMADesc[0];
+    PSDMMC_DMA_DESC pDesc = &pSDC->IDMADesc[start];
     uint32 i, size;
 
-    pReg->SDMMC_DBADDR = (uint32)(unsigned long)pDesc;
-    for (i=0; i<MAX_DESC_NUM_IDMAC; i++, pDesc++)
+    for (i=0; (i<count) && pCur->remain; i++, pDesc++)
     {
-        size = MIN(MAX_BUFF_SIZE_IDMAC, BufSize);    
+        size = MIN(MAX_BUFF_SIZE_IDMAC, pCur->pSG->len - pCur->offset);
+        size = MIN(size, pCur->remain);
         pDesc->desc1 = ((size << DescBuf1SizeShift) & DescBuf1SizMsk);
-        pDesc->desc2 =  (uint32)buffer;
-        pDesc->desc0 = DescSecAddrChained | DescOwnByDma | ((i==0)? DescFirstDesc : 0)| DescDisInt;
+        pDesc->desc2 = (uint32)(unsigned long)pCur->pSG->pBuf + pCur->offset;
+        pDesc->desc3 = (uint32)(unsigned long)&pSDC->IDMADesc[(start + i + 1) % MAX_DESC_NUM_IDMAC];
 
-        BufSize -= size;
-        if (0 == BufSize)
-            break;
-        buffer += size;
-        pDesc->desc3 = (uint32)(unsigned long)(pDesc+1);
+        pCur->remain -= size;
+        pCur->offset += size;
+        if (pCur->offset == pCur->pSG->len)
+        {
+            pCur->pSG++;
+            pCur->offset = 0;
+        }
+
+        //own bit last, the IDMAC may be waiting on this descriptor
+        pDesc->desc0 = DescSecAddrChained | DescOwnByDma
+                       | (pCur->first ? DescFirstDesc : 0)
+                       | (pCur->remain ? DescDisInt : DescLastDesc);
+        pCur->first = 0;
+    }
+
+    SDPAM_FlushCache((void*)&pSDC->IDMADesc[start], count*sizeof(SDMMC_DMA_DESC));
+
+    return i;
+}
+
+/****************************************************************/
+//SDC_RefillIDMA: once the IDMAC is done with the half of the ring to refill,
+//queue the next data on it and restart the IDMAC if it ran out of descriptors.
+//return the half to refill next
+/****************************************************************/
+static uint32 SDC_RefillIDMA(SDMMC_PORT_E nSDCPort, IDMA_CURSOR_T *pCur, uint32 refill)
+{
+    pSDC_REG_T      pReg = pSDCReg(nSDCPort);
+    pSDC_INFO_T     pSDC= &gSDCInfo[nSDCPort];
+    uint32          half = MAX_DESC_NUM_IDMAC / 2;
+    PSDMMC_DMA_DESC pLast = &pSDC->IDMADesc[refill * half + half - 1];
+
+    //the IDMAC clears the own bit of a descriptor when it is done with it
+    SDPAM_InvalidateCache((uint8 *)(pLast + 1) - ARCH_DMA_MINALIGN, ARCH_DMA_MINALIGN);
+    if (pLast->desc0 & DescOwnByDma)
+    {
+        return refill;
     }
 
-    pDesc->desc0 |= DescLastDesc;
-    pDesc->desc0 &= ~DescDisInt;
+    SDC_SetIDMADesc(nSDCPort, pCur, refill * half, half);
+    if (pReg->SDMMC_IDSTS & IDMAC_DU)
+    {
+        pReg->SDMMC_IDSTS = IDMAC_DU | IDMAC_AI;
+        pReg->SDMMC_PLDMND = 1;
+    }
 
-    SDPAM_FlushCache((void*)&pSDC->IDMADesc[0], (i + 1)*sizeof(SDMMC_DMA_DESC));
+    return refill ^ 1;
+}
 
-    return 0;
+#if (EN_SDC_ASYNC)
+/****************************************************************/
+//_AsyncArm: the read about to go out on nSDCPort carries on without the cpu,
+//the controller interrupt refills the ring and ends the read
+/****************************************************************/
+static void _AsyncArm(SDMMC_PORT_E nSDCPort, IDMA_CURSOR_T *pCur, uint32 DataLen)
+{
+    pSDC_REG_T      pReg = pSDCReg(nSDCPort);
+    pSDC_ASYNC_T    pAsync = &gSDCInfo[nSDCPort].async;
+
+    gIDMAAsyncCur[nSDCPort] = *pCur;
+    pAsync->dataLen = DataLen;
+    pAsync->ret = SDC_SUCCESS;
+    pAsync->timeout = DataLen / 1024 + 500;    //1MB/s at least
+    pAsync->start = get_timer(0);
+    pAsync->state = SDC_ASYNC_RUNNING;
+
+    pAsync->intMask = pReg->SDMMC_INTMASK;
+    pReg->SDMMC_RINISTS = DTO_INT | SDC_ASYNC_ERR_INT;
+    pReg->SDMMC_INTMASK = DTO_INT | SDC_ASYNC_ERR_INT;
+    pReg->SDMMC_IDINTEN = IDMAC_DU | IDMAC_FBE | IDMAC_AI;
+    pReg->SDMMC_CTRL |= ENABLE_INT;
 }
 
+/****************************************************************/
+//_AsyncEnd: the async read on nSDCPort is over, give the controller back to
+//the polled requests and keep the result for SDC_BusRequestWait()
+/****************************************************************/
+static void _AsyncEnd(SDMMC_PORT_E nSDCPort, int32 ret)
+{
+    pSDC_REG_T      pReg = pSDCReg(nSDCPort);
+    pSDC_ASYNC_T    pAsync = &gSDCInfo[nSDCPort].async;
+    uint32          value = pReg->SDMMC_RINISTS;
+
+    if (ret == SDC_SUCCESS)
+    {
+        if (value & RTO_INT)
+        {
+            ret = SDC_RESP_TIMEOUT;
+        }
+        else if (value & SBE_INT)
+        {
+            ret = SDC_START_BIT_ERROR;
+        }
+        else if (value & EBE_INT)
+        {
+            ret = SDC_END_BIT_ERROR;
+        }
+        else if (value & DRTO_INT)
+        {
+            ret = SDC_DATA_READ_TIMEOUT;
+        }
+        else if (value & DCRC_INT)
+        {
+            ret = SDC_DATA_CRC_ERROR;
+        }
+        else if (pReg->SDMMC_IDSTS & IDMAC_FBE)
+        {
+            ret = SDC_SDC_ERROR;
+        }
+    }
+
+    pReg->SDMMC_CTRL &= ~ENABLE_INT;
+    pReg->SDMMC_IDINTEN = 0;
+    pReg->SDMMC_INTMASK = pAsync->intMask;
+    pReg->SDMMC_RINISTS = 0xFFFFFFFF;
+    pReg->SDMMC_IDSTS = IDMAC_EN_INT_ALL;
+
+    pReg->SDMMC_CTRL &= ~CTRL_USE_IDMAC;
+    pReg->SDMMC_BMOD &= ~BMOD_DE;
+    //drop the lines fetched speculatively while the IDMAC was writing
+    SDPAM_InvalidateCache(pAsync->sg.pBuf, pAsync->dataLen);
+
+    pAsync->ret = ret;
+    pAsync->state = SDC_ASYNC_DONE;
+}
+
+/****************************************************************/
+//_AsyncIST: controller interrupt while an async read runs
+/****************************************************************/
+static void _AsyncIST(SDMMC_PORT_E nSDCPort)
+{
+    pSDC_REG_T      pReg = pSDCReg(nSDCPort);
+    IDMA_CURSOR_T  *pCur = &gIDMAAsyncCur[nSDCPort];
+
+    //the IDMAC ran out of descriptors, so it is done with the whole ring:
+    //queue the next data on it from the start and let it go on
+    if (pReg->SDMMC_IDSTS & IDMAC_DU)
+    {
+        if (pCur->remain)
+        {
+            SDC_SetIDMADesc(nSDCPort, pCur, 0, MAX_DESC_NUM_IDMAC);
+        }
+        pReg->SDMMC_IDSTS = IDMAC_DU | IDMAC_AI;
+        pReg->SDMMC_PLDMND = 1;
+    }
+
+    if ((pReg->SDMMC_RINISTS & (DTO_INT | SDC_ASYNC_ERR_INT)) || (pReg->SDMMC_IDSTS & IDMAC_FBE))
+    {
+        _AsyncEnd(nSDCPort, SDC_SUCCESS);
+    }
+}
+
+/****************************************************************/
+//_AsyncFinish: wait until the async read on nSDCPort, if any, is over.
+//a read past its timeout is stopped here
+/****************************************************************/
+static void _AsyncFinish(SDMMC_PORT_E nSDCPort)
+{
+    pSDC_REG_T      pReg = pSDCReg(nSDCPort);
+    pSDC_ASYNC_T    pAsync = &gSDCInfo[nSDCPort].async;
+    int             flag;
+
+    while (pAsync->state == SDC_ASYNC_RUNNING)
+    {
+        if (get_timer(pAsync->start) < pAsync->timeout)
+        {
+            continue;
+        }
+
+        //the isr may end it meanwhile
+        flag = disable_interrupts();
+        if (pAsync->state == SDC_ASYNC_RUNNING)
+        {
+            eMMC_printk(3, "SDC async read timeout, %d bytes not queued\n", gIDMAAsyncCur[nSDCPort].remain);
+            pReg->SDMMC_BMOD |= BMOD_SWR;
+            SDC_ResetFIFO(pReg);
+            _AsyncEnd(nSDCPort, SDC_DATA_READ_TIMEOUT);
+        }
+        if (flag)
+        {
+            enable_interrupts();
+        }
+    }
+}
+#endif
+
 static int32 SDC_RequestIDMA(SDMMC_PORT_E nSDCPort,
                         uint32  cmd,
                         uint32  CmdArg,
@@ -1369,15 +1641,57 @@ static int32 SDC_RequestIDMA(SDMMC_PORT_E nSDCPort,
 {
     pSDC_REG_T      pReg = pSDCReg(nSDCPort);
     pSDC_INFO_T     pSDC= &gSDCInfo[nSDCPort];
-    uint32          timeout  = DataLen*500; //һ512Ҫ250ms 
+    uint32          timeout;
     volatile uint32 value;
+    SDC_SG_T        sg;
+    pSDC_SG_T       pSG;
+    uint32          SGCount;
+    IDMA_CURSOR_T   cur;
+    uint32          refill = 0;
+    uint32          i, len = 0;
+
+    //500us per byte, saturated for multi-MB requests
+    timeout = (DataLen < 0xFFFFFFFF / 500) ? DataLen*500 : 0xFFFFFFFF;
 
-    if((cmd & SD_OP_MASK) == SD_WRITE_OP) {
-        SDPAM_FlushCache(pDataBuf, DataLen);
-    } else {
-	SDPAM_InvalidateCache(pDataBuf, DataLen);
+    if (pSDC->pSG)
+    {
+        pSG = pSDC->pSG;
+        SGCount = pSDC->SGCount;
+    }
+    else
+    {
+        sg.pBuf = pDataBuf;
+        sg.len = DataLen;
+        pSG = &sg;
+        SGCount = 1;
     }
-    SDC_SetIDMADesc(nSDCPort,(uint32)(unsigned long)pDataBuf, DataLen);
+#if (EN_SDC_ASYNC)
+    if (pSDC->bAsync)
+    {
+        //the isr goes on with the buffer once this returns
+        pSDC->async.sg = sg;
+        pSG = &pSDC->async.sg;
+    }
+#endif
+    //clean for reads too: a dirty line evicted while the IDMAC writes
+    //would land on top of the data read
+    for (i=0; i<SGCount; i++)
+    {
+        SDPAM_FlushCache(pSG[i].pBuf, pSG[i].len);
+        len += pSG[i].len;
+    }
+    if (len < DataLen)
+    {
+        return SDC_PARAM_ERROR;
+    }
+
+    cur.pSG = pSG;
+    cur.offset = 0;
+    cur.remain = DataLen;
+    cur.first = 1;
+    pReg->SDMMC_DBADDR = (uint32)(unsigned long)&pSDC->IDMADesc[0];
+    SDC_SetIDMADesc(nSDCPort, &cur, 0, MAX_DESC_NUM_IDMAC);
+    pReg->SDMMC_IDSTS = IDMAC_EN_INT_ALL;
 
     pReg->SDMMC_CTRL |= CTRL_USE_IDMAC;
     pReg->SDMMC_BMOD |= (BMOD_DE | BMOD_FB);
@@ -1385,14 +1699,37 @@ static int32 SDC_RequestIDMA(SDMMC_PORT_E nSDCPort,
     pSDC->ErrorStat = SDC_SUCCESS;
     //pSDC->IDMAOn = 1;
 
+#if (EN_SDC_ASYNC)
+    if (pSDC->bAsync)
+    {
+        _AsyncArm(nSDCPort, &cur, DataLen);
+    }
+#endif
     pReg->SDMMC_CMDARG = CmdArg;
     if (SDC_SUCCESS != SDC_StartCmd(pReg, (cmd & ~(RSP_BUSY)) | START_CMD | USE_HOLD_REG))
     {
+#if (EN_SDC_ASYNC)
+        if (pSDC->bAsync)
+        {
+            _AsyncEnd(nSDCPort, SDC_SDC_ERROR);
+            pSDC->async.state = SDC_ASYNC_IDLE;
+        }
+#endif
         return SDC_SDC_ERROR;
     }
+#if (EN_SDC_ASYNC)
+    if (pSDC->bAsync)
+    {
+        return SDC_SUCCESS;
+    }
+#endif
 
     do
     {
+        if (cur.remain)
+        {
+            refill = SDC_RefillIDMA(nSDCPort, &cur, refill);
+        }
         SDOAM_Delay(1);
         if((--timeout) == 0 || pSDC->ErrorStat != SDC_SUCCESS) 
             break;
@@ -1427,10 +1764,19 @@ static int32 SDC_RequestIDMA(SDMMC_PORT_E nSDCPort,
     }
 
     pReg->SDMMC_RINISTS = 0xFFFFFFFF;
+    pReg->SDMMC_IDSTS = IDMAC_EN_INT_ALL;
 
     pReg->SDMMC_CTRL &= ~CTRL_USE_IDMAC;
 	pReg->SDMMC_BMOD &= ~BMOD_DE;
     //pSDC->IDMAOn = 0;
+    if ((cmd & SD_OP_MASK) != SD_WRITE_OP)
+    {
+        //drop the lines fetched speculatively while the IDMAC was writing
+        for (i=0; i<SGCount; i++)
+        {
+            SDPAM_InvalidateCache(pSG[i].pBuf, pSG[i].len);
+        }
+    }
     if((cmd & SD_OP_MASK) == SD_WRITE_OP && (pSDC->ErrorStat == SDC_SUCCESS))
     {
         pSDC->ErrorStat = _WaitCardBusy(nSDCPort);
@@ -1487,6 +1833,10 @@ int32 SDC_BusRequest(int32 cardId,
 #endif
     pFunc           cb;
 
+#if (EN_SDC_ASYNC)
+    //the controller is the async read's until it is over
+    _AsyncFinish(nSDCPort);
+#endif
     //eMMC_printk(4, "SDC_BusRequest 111%s  %d\n", __FILE__,__LINE__);
     
     //PRINT_E( "EMMC CMD=%d arg = 0x%x len=0x%x\n",cmd&0x3f,cmdArg,dataLen);
@@ -1554,7 +1904,7 @@ int32 SDC_BusRequest(int32 cardId,
         pReg->SDMMC_BLKSIZ = blockSize;
         pReg->SDMMC_BYTCNT = dataLen;  //ĴĳһҪΪҪĳȣÿSDMMC32bit
 		#if(EN_SDC_INTERAL_DMA == 1)
-		if ((dataLen <= MAX_DATA_SIZE_IDMAC) && (dataLen >= 512))
+		if (((dataLen <= MAX_DATA_SIZE_IDMAC) && (dataLen >= 512)) || gSDCInfo[nSDCPort].pSG)
 		{
 			return SDC_RequestIDMA(nSDCPort, cmd, cmdArg, pDataBuf, dataLen);
 		}
@@ -1981,5 +2331,58 @@ int32 SDC_BusRequest(int32 cardId,
     return ret;
 }
 
+/****************************************************************/
+//SDC_BusRequestAsync: start reading dataLen bytes into pDataBuf on cardId
+//and return once the command is out. the IDMAC moves the data meanwhile and
+//the controller interrupt ends the read, SDC_BusRequestWait() gives its
+//result. any other request on cardId waits for the read to be over first
+/****************************************************************/
+int32 SDC_BusRequestAsync(int32 cardId,
+                             uint32 cmd,
+                             uint32 cmdArg,
+                             uint32  dataLen,
+                             void   *pDataBuf)
+{
+#if (EN_SDC_ASYNC)
+    pSDC_INFO_T     pSDC = &gSDCInfo[(SDMMC_PORT_E)cardId];
+    uint32          response[4];
+    int32           ret;
+
+    if (((cmd & SD_OP_MASK) != SD_READ_OP) || (dataLen < 512) || (dataLen > MAX_DATA_SIZE_IDMAC)
+        || pSDC->pSG || ((uint32)(unsigned long)pDataBuf & 0x3))
+    {
+        return SDC_PARAM_ERROR;
+    }
+
+    pSDC->bAsync = TRUE;
+    ret = SDC_BusRequest(cardId, cmd, cmdArg, response, 512, dataLen, pDataBuf);
+    pSDC->bAsync = FALSE;
+    return ret;
+#else
+    return SDC_PARAM_ERROR;
+#endif
+}
+
+/****************************************************************/
+//SDC_BusRequestWait: wait for the read SDC_BusRequestAsync() started on
+//cardId, return its result
+/****************************************************************/
+int32 SDC_BusRequestWait(int32 cardId)
+{
+#if (EN_SDC_ASYNC)
+    pSDC_ASYNC_T    pAsync = &gSDCInfo[(SDMMC_PORT_E)cardId].async;
+
+    _AsyncFinish((SDMMC_PORT_E)cardId);
+    if (pAsync->state != SDC_ASYNC_DONE)
+    {
+        return SDC_PARAM_ERROR;
+    }
+    pAsync->state = SDC_ASYNC_IDLE;
+    return pAsync->ret;
+#else
+    return SDC_PARAM_ERROR;
+#endif
+}
+
 #endif  //end of #ifdef DRIVERS_SDMMC
 
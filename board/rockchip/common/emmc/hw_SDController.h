@@ -66,6 +66,9 @@ $Log: hw_SDController.h,v $
 #define BUS_4_BIT         (0x1)
 #define BUS_8_BIT         (0x10000)
 
+/* UHS Register */
+#define UHS_DDR_MODE      (1 << 16)    //DDR mode for card 0
+
 /* interrupt mask bit */
 #define SDIO_INT          (1 << 24)    //SDIO interrupt
 #define BDONE_INT          (1 << 16)   //busy Done interrupt
@@ -153,9 +156,15 @@ typedef enum SDMMC_PORT_Enum
     SDC_MAX
 }SDMMC_PORT_E;
 
+/*
+ * descriptors are used as a chained ring, one half is refilled while the
+ * IDMAC works on the other, so one request is not limited by the ring size.
+ * buffer1 size field is 13 bits wide, 8192 does not fit in it.
+ * one request is limited by the 16 bit block count of CMD23.
+ */
 #define MAX_DESC_NUM_IDMAC     128
-#define MAX_BUFF_SIZE_IDMAC    8192
-#define MAX_DATA_SIZE_IDMAC    (MAX_DESC_NUM_IDMAC*MAX_BUFF_SIZE_IDMAC)
+#define MAX_BUFF_SIZE_IDMAC    4096
+#define MAX_DATA_SIZE_IDMAC    (0xFFFF << 9)
 
 #define CTRL_USE_IDMAC	       0x02000000  
 #define CTRL_IDMAC_RESET       0x00000004    
@@ -306,6 +315,24 @@ typedef struct TagSDC_INT_INFO
                                        //û4ֽڶ룬ҲΪuint32ָ룬ÿFIFO4ֽڶġ
 }SDC_INT_INFO_T;
 
+#if(EN_SDC_ASYNC)
+#define SDC_ASYNC_IDLE          (0)
+#define SDC_ASYNC_RUNNING       (1)     //the IDMAC moves the data, the isr ends the read
+#define SDC_ASYNC_DONE          (2)     //ret is kept for SDC_BusRequestWait()
+
+/* read left running by SDC_BusRequestAsync() */
+typedef struct TagSDC_ASYNC
+{
+    volatile uint32   state;
+    volatile int32    ret;
+    SDC_SG_T          sg;             //buffer of the read, the IDMAC cursor points in it
+    uint32            dataLen;
+    uint32            intMask;        //INTMASK to put back once the read is over
+    ulong             start;          //get_timer() when the command went out
+    ulong             timeout;        //ms
+}SDC_ASYNC_T, *pSDC_ASYNC_T;
+#endif
+
 /* SDMMC Host Controller Information */
 typedef struct TagSDC_INFO
 {
@@ -321,7 +348,13 @@ typedef struct TagSDC_INFO
     pFunc             pSdioCb;        //SDIOжϵĻص
 #if(EN_SDC_INTERAL_DMA)    
     uint32            ErrorStat;      
-    SDMMC_DMA_DESC    IDMADesc[MAX_DESC_NUM_IDMAC];
+    pSDC_SG_T         pSG;            //scatter-gather list for the next data requests, NULL for a plain buffer
+    uint32            SGCount;
+    SDMMC_DMA_DESC    IDMADesc[MAX_DESC_NUM_IDMAC] __attribute__((aligned(ARCH_DMA_MINALIGN)));
+#endif
+#if(EN_SDC_ASYNC)
+    uint32            bAsync;         //SDC_RequestIDMA() returns once the command is out
+    SDC_ASYNC_T       async;
 #endif	
 }SDC_INFO_T,*pSDC_INFO_T;
 
@@ -357,17 +357,18 @@ static int32 _SDMMC_Read(int32 cardId, uint32 dataAddr, uint32 blockCount, void
 }
 
 /****************************************************************/
-//:_SDMMC_Write
+//:_SDMMC_WriteEx
 //:SD\MMCддСλblock(512ֽ)
 //˵:cardId       ҪĿ
 //         dataAddr     Ҫдʼblockַ
 //         blockCount   Ҫдٸblock
 //         pBuf         Ҫдݴŵbufferַ
+//         cmd23Arg   flags of the CMD23 before a multiple block write, SDM_CMD23_RELIABLE/SDM_CMD23_PACKED
 //ֵ:
 //ȫֱ:
 //ע:
 /****************************************************************/
-static int32 _SDMMC_Write(int32 cardId, uint32 dataAddr, uint32 blockCount, void *pBuf)
+static int32 _SDMMC_WriteEx(int32 cardId, uint32 dataAddr, uint32 blockCount, void *pBuf, uint32 cmd23Arg)
 {
     int32            ret = SDM_SUCCESS;
     int32            handleRet = SDM_SUCCESS;  //ķֵ
@@ -376,7 +377,7 @@ static int32 _SDMMC_Write(int32 cardId, uint32 dataAddr, uint32 blockCount, void
 
     while (repeatCount < SDM_CMD_RESENT_COUNT)
     {
-        if (blockCount == 1)
+        if ((blockCount == 1) && (cmd23Arg == 0))
         {
             ret = SDC_WriteBlockData(cardId, 
                                      (SD_WRITE_BLOCK | SD_WRITE_OP | SD_RSP_R1 | WAIT_PREV), 
@@ -387,13 +388,28 @@ static int32 _SDMMC_Write(int32 cardId, uint32 dataAddr, uint32 blockCount, void
         }
         else
         {
+            uint32 PreDefined = 0;
+            if ((gSDMDriver[cardId].cardInfo.type & eMMC2G) && gSDMDriver[cardId].cardInfo.bootSize && (blockCount <= 0xFFFF))
+            {
+                ret = SDC_BusRequest(cardId, (SD_SET_BLOCK_COUNT | SD_NODATA_OP | SD_RSP_R1 | WAIT_PREV), (cmd23Arg | blockCount), &status, 0, 0, NULL);
+                if (ret == SDC_SUCCESS)
+                {
+                    PreDefined = 1;
+                }
+            }
+            if (cmd23Arg && (PreDefined == 0))
+            {
+                //a reliable or packed write means nothing without its CMD23
+                ret = SDM_FUNC_NOT_SUPPORT;
+                break;
+            }
             ret = SDC_WriteBlockData(cardId, 
                                      (SD_WRITE_MULTIPLE_BLOCK | SD_WRITE_OP | SD_RSP_R1 | WAIT_PREV), 
                                      dataAddr, 
                                      &status, 
                                      (blockCount << 9), 
                                      pBuf);
-            if (ret == SDC_SUCCESS)
+            if (ret == SDC_SUCCESS && PreDefined == 0)
             {
                 ret = SDC_SendCommand(cardId, (SD_STOP_TRANSMISSION | SD_NODATA_OP | SD_RSP_R1B | STOP_CMD | NO_WAIT_PREV), 0, &status);
                 if (ret == SDC_RESP_TIMEOUT)
@@ -518,6 +534,11 @@ static int32 _SDMMC_Write(int32 cardId, uint32 dataAddr, uint32 blockCount, void
     }
 }
 
+static int32 _SDMMC_Write(int32 cardId, uint32 dataAddr, uint32 blockCount, void *pBuf)
+{
+    return _SDMMC_WriteEx(cardId, dataAddr, blockCount, pBuf, 0);
+}
+
 /****************************************************************/
 //:_RegisterFunction
 //:ݲͬע᲻ͬĺ
@@ -1125,17 +1146,65 @@ int32 SDM_Read(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf)
 }
 
 /****************************************************************/
-//:SDM_Write
+//SDM_ReadAsync: start SDM_Read on the eMMC and return once the read command
+//is out, SDM_ReadWait() gives the result. SDM_FUNC_NOT_SUPPORT for what only
+//the polled read does: other cards, no IDMAC interrupt, more than one IDMAC
+//request. the caller does SDM_Read then
+/****************************************************************/
+int32 SDM_ReadAsync(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf)
+{
+#if (EN_SDC_ASYNC)
+    SDM_PORT_INFO_T *pSDMDriver = &gSDMDriver[SDC2];
+    uint32           status = 0;
+    int32            ret;
+
+    //CMD23 gives the length, nothing is left to send once the data is in
+    if ((cardId != SDC2) || !pSDMDriver->bOpen
+        || !((pSDMDriver->cardInfo.type & eMMC2G) && pSDMDriver->cardInfo.bootSize)
+        || (blockCount < 2) || (blockCount > (MAX_DATA_SIZE_IDMAC >> 9)))
+    {
+        return SDM_FUNC_NOT_SUPPORT;
+    }
+    if ((blockNum + blockCount) > (pSDMDriver->cardInfo.capability))
+    {
+        return SDM_PARAM_ERROR;
+    }
+
+    SDOAM_RequestMutex(pSDMDriver->mutex);
+    ret = SDC_BusRequest(cardId, (SD_SET_BLOCK_COUNT | SD_NODATA_OP | SD_RSP_R1 | WAIT_PREV), blockCount, &status, 0, 0, NULL);
+    if (ret == SDC_SUCCESS)
+    {
+        ret = SDC_BusRequestAsync(cardId, (SD_READ_MULTIPLE_BLOCK | SD_READ_OP | SD_RSP_R1 | WAIT_PREV), blockNum, (blockCount << 9), pBuf);
+    }
+    SDOAM_ReleaseMutex(pSDMDriver->mutex);
+
+    return ret;
+#else
+    return SDM_FUNC_NOT_SUPPORT;
+#endif
+}
+
+/****************************************************************/
+//SDM_ReadWait: wait for the read SDM_ReadAsync() started, return its result
+/****************************************************************/
+int32 SDM_ReadWait(int32 cardId)
+{
+    return SDC_BusRequestWait(cardId);
+}
+
+/****************************************************************/
+//:_SDM_Write
 //:cardIdָĿддСλblock(512ֽ)
 //˵:cardId       ҪĿ
 //         blockNum     Ҫдʼblock
 //         blockCount   Ҫдٸblock
 //         pBuf         ҪдݴŵbufferַҪַ4ֽڶ
+//         cmd23Arg   flags of the CMD23 before each write, SDM_CMD23_RELIABLE
 //ֵ:
 //ȫֱ:gSDMDriver[i]
 //ע:pBufַҪַ4ֽڶ
 /****************************************************************/
-int32 SDM_Write(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf)
+static int32 _SDM_Write(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf, uint32 cmd23Arg)
 {
     SDM_PORT_INFO_T *pSDMDriver;
     uint32           port;
@@ -1171,6 +1240,11 @@ int32 SDM_Write(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf)
         return SDM_CARD_WRITE_PROT;
     }
 
+    if (!((pSDMDriver->cardInfo.type & eMMC2G) && pSDMDriver->cardInfo.bootSize && pSDMDriver->cardInfo.relWrSecC))
+    {
+        cmd23Arg &= ~SDM_CMD23_RELIABLE;  //no CMD23 or no reliable write, write it the plain way
+    }
+
     if((pSDMDriver->cardInfo.type) & (SDHC | eMMC2G))
     {
         mul = 0;  //SDHCַblock(512)ΪλģЭַbyteΪλ
@@ -1183,27 +1257,48 @@ int32 SDM_Write(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf)
     SDOAM_RequestMutex(pSDMDriver->mutex);
     if (pSDMDriver->bOpen)
     {
-        #if EN_SDC_INTERAL_DMA
         int i;
         int mod;
         char * pu8buf = pBuf;
+        #if EN_SDC_INTERAL_DMA
 		mod = (MAX_DATA_SIZE_IDMAC >> 9);
+        #else
+        mod = blockCount;
+        #endif
+        if ((cmd23Arg & SDM_CMD23_RELIABLE) && !pSDMDriver->cardInfo.relWrEn)
+        {
+            //legacy reliable write: whole REL_WR_SEC_C units, else block by block
+            if ((blockNum % pSDMDriver->cardInfo.relWrSecC) || (blockCount % pSDMDriver->cardInfo.relWrSecC))
+            {
+                mod = 1;
+            }
+            else
+            {
+                mod -= (mod % pSDMDriver->cardInfo.relWrSecC);
+            }
+        }
         for(i=0;i<blockCount;i+=mod)
         {
 			if(blockCount - i < mod)
 			{
 				mod = blockCount - i;
 			}
-            ret = (pSDMDriver->cardInfo.fun.write)(cardId, ((blockNum+i) << mul), mod, pu8buf+i*512);
+            if (cmd23Arg)
+            {
+                ret = _SDMMC_WriteEx(cardId, ((blockNum+i) << mul), mod, pu8buf+i*512, cmd23Arg);
+            }
+            else
+            {
+                ret = (pSDMDriver->cardInfo.fun.write)(cardId, ((blockNum+i) << mul), mod, pu8buf+i*512);
+            }
             if(ret != SDM_SUCCESS)
             {
+                #if EN_SDC_INTERAL_DMA
                 SDM_Close(cardId);
+                #endif
                 break;
             }        
         }
-        #else
-        ret = (pSDMDriver->cardInfo.fun.write)(cardId, (blockNum << mul), blockCount, pBuf);
-        #endif
     }
     else
     {
@@ -1219,6 +1314,143 @@ int32 SDM_Write(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf)
     return ret;
 }
 
+int32 SDM_Write(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf)
+{
+    return _SDM_Write(cardId, blockNum, blockCount, pBuf, 0);
+}
+
+/****************************************************************/
+//SDM_WriteReliable: SDM_Write as an eMMC reliable write, the old data
+//stays if the power fails half way. A plain write on cards without it
+/****************************************************************/
+int32 SDM_WriteReliable(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf)
+{
+    return _SDM_Write(cardId, blockNum, blockCount, pBuf, SDM_CMD23_RELIABLE);
+}
+
+#if EN_SDC_INTERAL_DMA
+static uint32 gSDMPackedBuf[128] __attribute__((aligned(ARCH_DMA_MINALIGN)));  //header, the data goes by scatter-gather
+#else
+static uint32 gSDMPackedBuf[SDM_PACKED_BLOCKS << 7] __attribute__((aligned(ARCH_DMA_MINALIGN)));  //header and data
+#endif
+
+/****************************************************************/
+//_SDM_WritePacked: the count writes of pWrite in one eMMC packed write
+//command, blocks is their block count plus one for the header
+/****************************************************************/
+static int32 _SDM_WritePacked(int32 cardId, pSDM_PACKED_T pWrite, uint32 count, uint32 blocks)
+{
+    SDM_PORT_INFO_T *pSDMDriver = &gSDMDriver[cardId];
+    uint32          *pHdr = gSDMPackedBuf;
+    int32            ret;
+    uint32           i;
+#if EN_SDC_INTERAL_DMA
+    SDC_SG_T         SG[SDM_PACKED_MAX + 1];
+#else
+    uint8           *pData = (uint8 *)gSDMPackedBuf + 512;
+#endif
+
+    SDOAM_Memset(pHdr, 0, 512);
+    pHdr[0] = (count << 16) | (0x2 << 8) | 0x1;  //entries, write, header version 1
+    for (i=0; i<count; i++)
+    {
+        pHdr[(i+1)*2] = pWrite[i].blockCount;    //CMD23 and CMD25 argument of each write
+        pHdr[(i+1)*2+1] = pWrite[i].blockNum;
+#if EN_SDC_INTERAL_DMA
+        SG[i+1].pBuf = pWrite[i].pBuf;
+        SG[i+1].len = pWrite[i].blockCount << 9;
+#else
+        SDOAM_Memcpy(pData, pWrite[i].pBuf, pWrite[i].blockCount << 9);
+        pData += pWrite[i].blockCount << 9;
+#endif
+    }
+
+    SDOAM_RequestMutex(pSDMDriver->mutex);
+    if (pSDMDriver->bOpen)
+    {
+#if EN_SDC_INTERAL_DMA
+        SG[0].pBuf = pHdr;
+        SG[0].len = 512;
+        ret = SDC_SetDataSG(cardId, SG, count + 1);
+        if (ret == SDC_SUCCESS)
+        {
+            ret = _SDMMC_WriteEx(cardId, pWrite[0].blockNum, blocks, pHdr, SDM_CMD23_PACKED);
+            SDC_SetDataSG(cardId, NULL, 0);
+        }
+#else
+        ret = _SDMMC_WriteEx(cardId, pWrite[0].blockNum, blocks, pHdr, SDM_CMD23_PACKED);
+#endif
+    }
+    else
+    {
+        ret = SDM_CARD_CLOSED;
+    }
+    SDOAM_ReleaseMutex(pSDMDriver->mutex);
+
+    return ret;
+}
+
+/****************************************************************/
+//SDM_WritePacked: the count writes of pWrite, small ones batched into
+//eMMC 4.5 packed write commands so the card takes them in one go. Cards
+//without packed commands, and batches that fail, get them one by one
+/****************************************************************/
+int32 SDM_WritePacked(int32 cardId, pSDM_PACKED_T pWrite, uint32 count)
+{
+    SDM_PORT_INFO_T *pSDMDriver;
+    uint32           port;
+    uint32           i, j, n;
+    uint32           blocks;
+    int32            ret = SDM_SUCCESS;
+
+    if(SDC2 == cardId)
+    {
+        port = SDC2;
+    }
+    else
+    {
+        if ((!SDC_IsCardIdValid(cardId)) || (!_IsCardRegistered(cardId, &port)))
+        {
+            return SDM_PARAM_ERROR;
+        }
+    }
+    pSDMDriver = &gSDMDriver[port];
+
+    for (i=0; i<count; i+=n)
+    {
+        //as many writes as one packed command takes
+        blocks = 1;
+        for (n=0; (i+n < count) && (n < SDM_PACKED_MAX) && (n < pSDMDriver->cardInfo.maxPackedWr); n++)
+        {
+            if ((pWrite[i+n].blockCount == 0)
+                || ((pWrite[i+n].blockNum + pWrite[i+n].blockCount) > pSDMDriver->cardInfo.capability)
+                || ((blocks + pWrite[i+n].blockCount) > SDM_PACKED_BLOCKS))
+            {
+                break;
+            }
+            blocks += pWrite[i+n].blockCount;
+        }
+        if ((n >= 2) && !pSDMDriver->cardInfo.WriteProt
+            && (pSDMDriver->cardInfo.type & eMMC2G) && pSDMDriver->cardInfo.bootSize
+            && (_SDM_WritePacked(port, &pWrite[i], n, blocks) == SDM_SUCCESS))
+        {
+            continue;
+        }
+
+        n = (n == 0) ? 1 : n;
+        for (j=0; j<n; j++)
+        {
+            ret = SDM_Write(cardId, pWrite[i+j].blockNum, pWrite[i+j].blockCount, pWrite[i+j].pBuf);
+            if (ret != SDM_SUCCESS)
+            {
+                return ret;
+            }
+        }
+    }
+
+    return ret;
+}
+
 /****************************************************************/
 //:SDM_IOCtrl
 //:IOƺ
@@ -1438,6 +1670,12 @@ int32 SDM_IOCtrl(uint32 cmd, void *param)
             ret = _AccessBootPartition(cardId, pTmp[1]);
             SDOAM_ReleaseMutex(gSDMDriver[port].mutex);
             break;    
+
+        case SDM_IOCTR_SET_TIMING:            //param[1]: timing out, param[2]: sample phase in/out
+            SDOAM_RequestMutex(gSDMDriver[port].mutex);
+            ret = MMC_SwitchTiming(&gSDMDriver[port].cardInfo, &pTmp[1], &pTmp[2]);
+            SDOAM_ReleaseMutex(gSDMDriver[port].mutex);
+            break;
             
         default:
             ret = SDM_PARAM_ERROR;
@@ -36,6 +36,12 @@ no message
 #define SDM_INVALID_CARDID    (-1)           //ЧcardId
 #define SDM_WIDE_BUS_MODE     (1 << 0)       //for debug
 #define SDM_HIGH_SPEED_MODE   (1 << 1)       //for debug 
+#define SDM_DDR_MODE          (1 << 2)       //eMMC DDR52
+#define SDM_HS200_MODE        (1 << 3)       //eMMC HS200
+
+/* CMD23 argument flags of an eMMC write */
+#define SDM_CMD23_RELIABLE    (0x1U << 31)   //reliable write request
+#define SDM_CMD23_PACKED      (0x1U << 30)   //packed command, the first block is the header
 
 /*
 #if ((SD_FPP_FREQ/1000) < (FREQ_HCLK_MAX/8))
@@ -133,6 +139,11 @@ typedef struct TagSDM_CARD_INFO
     // eMMC Boot information
     /*************************************************************/
     uint32           bootSize;         //boot partition size,λsector(512B)
+    uint8            devType;          //EXT_CSD DEVICE_TYPE, supported bus timings
+    HOST_BUS_WIDTH_E busWidth;         //data bus width in use
+    uint8            relWrSecC;        //EXT_CSD REL_WR_SEC_C, 0: no reliable write
+    uint8            relWrEn;          //EXT_CSD WR_REL_PARAM EN_REL_WR, reliable writes of any size and address
+    uint8            maxPackedWr;      //EXT_CSD MAX_PACKED_WRITES, 0: no packed commands
 }SDM_CARD_INFO_T,*pSDM_CARD_INFO_T;
 
 /* SDM Port Information */
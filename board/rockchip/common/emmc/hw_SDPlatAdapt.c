@@ -41,7 +41,10 @@ void   SDPAM_FlushCache(void *adr, uint32 size)
 /****************************************************************/
 void   SDPAM_CleanCache(void *adr, uint32 size)
 {
-
+#if (EN_SD_DMA || EN_SDC_INTERAL_DMA)
+	//no clean-only range op, clean+invalidate leaves memory the same
+	CacheFlushDRegion((uint32)(unsigned long)adr,(uint32)size);
+#endif
 }
 
 
@@ -136,6 +139,42 @@ void   SDPAM_SetMmcClkDiv(SDMMC_PORT_E nSDCPort, uint32 div)
 #endif
 }
 
+/****************************************************************/
+//SDPAM_SetDrvPhase: delay the clock the card sees against the
+//data and command driven out, degree is 0/90/180/270
+/****************************************************************/
+void   SDPAM_SetDrvPhase(SDMMC_PORT_E nSDCPort, uint32 degree)
+{
+#if !SDMMC_NO_PLATFORM
+    SCUSetSDDrvPhase(nSDCPort, degree);
+#endif
+}
+
+/****************************************************************/
+//SDPAM_SetSamplePhase: move the point the host samples read data,
+//phase 0 is the reset default, larger phases sample later
+/****************************************************************/
+void   SDPAM_SetSamplePhase(SDMMC_PORT_E nSDCPort, uint32 phase)
+{
+#if !SDMMC_NO_PLATFORM
+    SCUSetSDSamplePhase(nSDCPort, phase);
+#endif
+}
+
+/****************************************************************/
+//SDPAM_IsIo1V8: the card io runs at 1.8V. The eMMC vccq is wired on
+//the board and nothing here can switch it, so CONFIG_RK_EMMC_IO_1V8
+//tells; the sd card slots stay at 3.3V
+/****************************************************************/
+bool   SDPAM_IsIo1V8(SDMMC_PORT_E nSDCPort)
+{
+#ifdef CONFIG_RK_EMMC_IO_1V8
+    return (nSDCPort == SDC2);
+#else
+    return FALSE;
+#endif
+}
+
 #if EN_SD_DMA
 /****************************************************************/
 //:SDPAM_DMAStart
@@ -22,6 +22,12 @@ $Log: hw_SDPlatAdapt.h,v $
 #define SDPAM_MAX_AHB_FREQ   200//FREQ_HCLK_MAX
 #endif
 
+#if SDMMC_NO_PLATFORM
+#define SDPAM_SAMPLE_PHASES  1
+#else
+#define SDPAM_SAMPLE_PHASES  SD_SAMPLE_PHASE_NUM    //sample phases SDPAM_SetSamplePhase can select
+#endif
+
 /****************************************************************/
 //⺯
 /****************************************************************/
@@ -32,6 +38,9 @@ uint32 SDPAM_GetAHBFreq(SDMMC_PORT_E nSDCPort);
 void   SDPAM_SDCClkEnable(SDMMC_PORT_E nSDCPort, uint32 enable);
 void   SDPAM_SDCReset(SDMMC_PORT_E nSDCPort);
 void   SDPAM_SetMmcClkDiv(SDMMC_PORT_E nSDCPort, uint32 div);
+void   SDPAM_SetDrvPhase(SDMMC_PORT_E nSDCPort, uint32 degree);
+void   SDPAM_SetSamplePhase(SDMMC_PORT_E nSDCPort, uint32 phase);
+bool   SDPAM_IsIo1V8(SDMMC_PORT_E nSDCPort);
 #if EN_SD_DMA
 bool SDPAM_DMAInit(SDMMC_PORT_E nSDCPort);
 bool SDPAM_DMAStart(SDMMC_PORT_E nSDCPort, uint32 dstAddr, uint32 srcAddr, uint32 size, bool rw, pFunc cb_f);
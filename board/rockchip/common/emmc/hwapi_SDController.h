@@ -39,6 +39,13 @@ typedef enum HOST_BUS_WIDTH_Enum
     BUS_WIDTH_8_BIT,
     BUS_WIDTH_MAX
 }HOST_BUS_WIDTH_E;
+
+/* one piece of a scatter-gather data buffer, len must be a multiple of 512 */
+typedef struct SDC_SG_Struct
+{
+    void   *pBuf;
+    uint32  len;
+}SDC_SG_T, *pSDC_SG_T;
 /****************************************************************/
 //⺯
 /****************************************************************/
@@ -56,6 +63,8 @@ int32 SDC_DisableSdioInt(int32 cardId);
 int32 SDC_ControlClock(int32 cardId, uint32 enable);
 int32 SDC_ControlPower(int32 cardId, uint32 enable);
 int32 SDC_WaitCardBusy(int32 cardId);
+int32 SDC_SetDataSG(int32 cardId, pSDC_SG_T pSG, uint32 count);
+int32 SDC_SetDDRMode(int32 cardId, uint32 enable);
 int32 SDC_BusRequest(int32 cardId,
                              uint32 cmd,
                              uint32 cmdArg,
@@ -63,6 +72,12 @@ int32 SDC_BusRequest(int32 cardId,
                              uint32  blockSize,
                              uint32  dataLen,
                              void   *pDataBuf);
+int32 SDC_BusRequestAsync(int32 cardId,
+                             uint32 cmd,
+                             uint32 cmdArg,
+                             uint32  dataLen,
+                             void   *pDataBuf);
+int32 SDC_BusRequestWait(int32 cardId);
 #define SDC_SendCommand(cardId, cmd, cmdArg, responseBuf)  \
                    SDC_BusRequest(cardId, cmd, cmdArg, responseBuf, 0, 0, NULL);
 #define SDC_ReadBlockData(cardId, cmd, cmdArg, responseBuf, dataLen, pDataBuf)  \
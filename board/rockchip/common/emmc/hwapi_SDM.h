@@ -56,6 +56,25 @@ $Log: hwapi_SDM.h,v $
 #define SDM_IOCTR_ACCESS_BOOT_PARTITION  (0xE)           //Access boot partition or user area
 #define SDM_IOCTR_SET_BOOT_BUSWIDTH      (0xF)           //ģʽµ߿
 #define SDM_IOCTR_SET_BOOT_PART_SIZE     (0x10)           //ģʽµ߿
+#define SDM_IOCTR_SET_TIMING             (0x11)           //switch eMMC to its fastest bus timing, param[1]: timing out, param[2]: sample phase in/out
+
+/* SDM_IOCTR_SET_TIMING bus timing */
+#define SDM_TIMING_HS                    (0)             //high speed SDR, as left by card registration
+#define SDM_TIMING_DDR52                 (1)
+#define SDM_TIMING_HS200                 (2)
+#define SDM_PHASE_UNTUNED                (0xFFFFFFFF)    //no sample phase known, tune from scratch
+
+/* SDM_WritePacked */
+#define SDM_PACKED_MAX                   (16)            //writes in one packed command at most
+#define SDM_PACKED_BLOCKS                (128)           //blocks in one packed command at most, header included
+
+/* one write of SDM_WritePacked() */
+typedef struct TagSDM_PACKED
+{
+    uint32  blockNum;
+    uint32  blockCount;
+    void   *pBuf;
+}SDM_PACKED_T, *pSDM_PACKED_T;
 
 
 /****************************************************************/
@@ -65,7 +84,11 @@ void   SDM_Init(uint32 CardId);
 int32  SDM_Open(int32 cardId);
 int32  SDM_Close(int32 cardId);
 int32  SDM_Read(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf);
+int32  SDM_ReadAsync(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf);
+int32  SDM_ReadWait(int32 cardId);
 int32  SDM_Write(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf);
+int32  SDM_WriteReliable(int32 cardId, uint32 blockNum, uint32 blockCount, void *pBuf);
+int32  SDM_WritePacked(int32 cardId, pSDM_PACKED_T pWrite, uint32 count);
 int32  SDM_IOCtrl(uint32 cmd, void *param);
 
 //רŸCMMBʹõ
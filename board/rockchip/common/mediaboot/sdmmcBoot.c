@@ -19,6 +19,9 @@ Revision:   1.00
 #define EMMC_CARD_ID                2
 #define SD_CARD_FW_PART_OFFSET      8192
 #define SD_CARD_SYS_PART_OFFSET     8064
+// sys data sector caching the emmc bus timing, u-boot's first one after the env
+#define SD_CARD_TIMING_SYS_INDEX    (UBOOT_SYS_DATA_OFFSET + \
+				     (CONFIG_ENV_OFFSET + CONFIG_ENV_SIZE + RK_BLK_SIZE - 1) / RK_BLK_SIZE)
 
 typedef struct SDCardInfoTag
 {
@@ -36,8 +39,34 @@ typedef struct SDCardInfoTag
 static uint32 gsdboot_mode = 0;
 #endif
 static SD_Card_Info gSdCardInfoTbl[3];
+
+/* read started by SdmmcBootReadLBA_async(), SdmmcBootReadLBA_wait() ends it */
+typedef struct SdmmcAsyncReadTag
+{
+	uint32 Running;		// on the controller, else Ret is its result
+	uint32 Ret;
+	uint32 LBA;
+	void *pbuf;
+	uint32 nSec;
+}SdmmcAsyncRead;
+static SdmmcAsyncRead gSdmmcAsyncRead;
 static uint32	sdmmc_Data[(1024*8*4/4)] __attribute__((aligned(ARCH_DMA_MINALIGN)));
 
+#if defined(CONFIG_RK_EMMC_HS200) || defined(CONFIG_RK_EMMC_DDR52)
+#define EMMC_TIMING_TAG             0x54494D45  // "EMIT"
+
+typedef struct EmmcTimingTag
+{
+	uint32 Tag;
+	uint32 Psn;         // card the sample phase was tuned on
+	uint32 Timing;
+	uint32 Phase;
+	uint32 Check;       // crc32 of the fields above
+}EMMC_Timing;
+
+static uint32	gEmmcTimingBuf[128] __attribute__((aligned(ARCH_DMA_MINALIGN)));
+#endif
+
 
 void SdmmcSDMInit(void)
 {
@@ -89,6 +118,50 @@ EMMC_INIT_retry:
 }
 
 
+#if defined(CONFIG_RK_EMMC_HS200) || defined(CONFIG_RK_EMMC_DDR52)
+/*
+ * switch emmc from high speed to HS200 or DDR52, the HS200 sample phase
+ * tuned on an earlier boot is kept in sys data so later boots only check it.
+ */
+static void SdmmcSetTiming(uint32 ChipSel)
+{
+	EMMC_Timing *pTiming = (EMMC_Timing *)gEmmcTimingBuf;
+	uint32 ioctlParam[5] = {0,0,0,0,0};
+	uint32 psn, phase = SDM_PHASE_UNTUNED;
+	int32 ret;
+
+	ioctlParam[0] = ChipSel;
+	if (SDM_IOCtrl(SDM_IOCTR_GET_PSN, ioctlParam) != SDM_SUCCESS)
+		return;
+	psn = ioctlParam[1];
+
+	if ((SdmmcSysDataLoad(ChipSel, SD_CARD_TIMING_SYS_INDEX, gEmmcTimingBuf) == SDM_SUCCESS)
+		&& (pTiming->Tag == EMMC_TIMING_TAG) && (pTiming->Psn == psn)
+		&& (pTiming->Timing == SDM_TIMING_HS200)
+		&& (pTiming->Check == crc32(0, (const unsigned char *)pTiming, offsetof(EMMC_Timing, Check))))
+	{
+		phase = pTiming->Phase;
+	}
+
+	ioctlParam[0] = ChipSel;
+	ioctlParam[1] = SDM_TIMING_HS;
+	ioctlParam[2] = phase;
+	ret = SDM_IOCtrl(SDM_IOCTR_SET_TIMING, ioctlParam);
+	debug("SdmmcSetTiming: ret=%x timing=%x phase=%x\n", ret, ioctlParam[1], ioctlParam[2]);
+	if ((ret != SDM_SUCCESS) || (ioctlParam[1] != SDM_TIMING_HS200) || (ioctlParam[2] == phase))
+		return;
+
+	ftl_memset(gEmmcTimingBuf, 0, sizeof(gEmmcTimingBuf));
+	pTiming->Tag = EMMC_TIMING_TAG;
+	pTiming->Psn = psn;
+	pTiming->Timing = ioctlParam[1];
+	pTiming->Phase = ioctlParam[2];
+	pTiming->Check = crc32(0, (const unsigned char *)pTiming, offsetof(EMMC_Timing, Check));
+	SdmmcSysDataStore(ChipSel, SD_CARD_TIMING_SYS_INDEX, gEmmcTimingBuf);
+}
+#endif
+
+
 uint32 SdmmcInit(uint32 ChipSel)
 {
 	int32 ret1 = SDM_SUCCESS;
@@ -158,6 +231,12 @@ uint32 SdmmcInit(uint32 ChipSel)
 #endif /* EMMC_NOT_USED_BOOT_PART */
 		PRINT_E("FwPartOffset = %lx, %x\n", gSdCardInfoTbl[ChipSel].FwPartOffset, gSdCardInfoTbl[ChipSel].BootCapSize);
 		gSdCardInfoTbl[ChipSel].Valid = 1;
+#if defined(CONFIG_RK_EMMC_HS200) || defined(CONFIG_RK_EMMC_DDR52)
+		if ((ret1 == SDM_SUCCESS) && (ChipSel == EMMC_CARD_ID))
+		{
+			SdmmcSetTiming(ChipSel);
+		}
+#endif
 
 		return ret1;
 	}
@@ -320,12 +399,9 @@ uint32 SdmmcBootReadPBA(uint8 ChipSel, uint32 PBA, void *pbuf, uint32 nSec)
 	return 0;
 }
 
-uint32 SdmmcBootReadLBA(uint8 ChipSel, uint32 LBA, void *pbuf, uint32 nSec)
+/* switch to the part the LBAs are in, -1 if the card has none */
+static uint32 SdmmcBootLBAPart(uint8 ChipSel)
 {
-	uint32 iret = FTL_OK;
-	uint32 try_count = 2;
-
-ReadRetry:
 #ifndef EMMC_NOT_USED_BOOT_PART
 	if(gSdCardInfoTbl[ChipSel].BootCapSize > 0)
 	{
@@ -343,6 +419,17 @@ ReadRetry:
 			return -1;//쳣
 		}
 	}
+	return 0;
+}
+
+uint32 SdmmcBootReadLBA(uint8 ChipSel, uint32 LBA, void *pbuf, uint32 nSec)
+{
+	uint32 iret = FTL_OK;
+	uint32 try_count = 2;
+
+ReadRetry:
+	if (SdmmcBootLBAPart(ChipSel) != 0)
+		return -1;
 	iret = SDM_Read(ChipSel,LBA + gSdCardInfoTbl[ChipSel].FwPartOffset,nSec,pbuf);
 	if(iret != FTL_OK && try_count > 0)
 	{
@@ -356,6 +443,69 @@ ReadRetry:
 	return (iret);
 }
 
+/*
+ * Start reading nSec sectors at LBA and return while the controller moves
+ * them, SdmmcBootReadLBA_wait() gives the result. A read the eMMC can't do
+ * that way is done here. One read at a time, other requests wait for it.
+ */
+uint32 SdmmcBootReadLBA_async(uint8 ChipSel, uint32 LBA, void *pbuf, uint32 nSec)
+{
+	SdmmcAsyncRead *pRead = &gSdmmcAsyncRead;
+
+	pRead->LBA = LBA;
+	pRead->pbuf = pbuf;
+	pRead->nSec = nSec;
+	pRead->Running = 0;
+	if (SdmmcBootLBAPart(ChipSel) != 0)
+		return -1;
+
+	if (SDM_ReadAsync(ChipSel, LBA + gSdCardInfoTbl[ChipSel].FwPartOffset, nSec, pbuf) == SDM_SUCCESS)
+		pRead->Running = 1;
+	else
+		pRead->Ret = SdmmcBootReadLBA(ChipSel, LBA, pbuf, nSec);
+
+	return FTL_OK;
+}
+
+uint32 SdmmcBootReadLBA_wait(uint8 ChipSel)
+{
+	SdmmcAsyncRead *pRead = &gSdmmcAsyncRead;
+
+	if (!pRead->Running)
+		return pRead->Ret;
+
+	pRead->Running = 0;
+	if (SDM_ReadWait(ChipSel) == SDM_SUCCESS)
+		return FTL_OK;
+
+	/* again the polled way, it knows how to get the card back */
+	return SdmmcBootReadLBA(ChipSel, pRead->LBA, pRead->pbuf, pRead->nSec);
+}
+
+/* the count writes of pWrite, batched into eMMC packed commands */
+uint32 SdmmcBootWriteLBAPacked(uint8 ChipSel, STORAGE_WRITE_T *pWrite, uint32 count)
+{
+	SDM_PACKED_T Packed[SDM_PACKED_MAX];
+	uint32 iret = FTL_OK;
+	uint32 i, n;
+
+	if (SdmmcBootLBAPart(ChipSel) != 0)
+		return -1;
+
+	for (i = 0; i < count; i += n) {
+		for (n = 0; (n < SDM_PACKED_MAX) && (i + n < count); n++) {
+			Packed[n].blockNum = pWrite[i + n].LBA + gSdCardInfoTbl[ChipSel].FwPartOffset;
+			Packed[n].blockCount = pWrite[i + n].nSec;
+			Packed[n].pBuf = pWrite[i + n].pbuf;
+		}
+		iret = SDM_WritePacked(ChipSel, Packed, n);
+		if (iret != FTL_OK)
+			break;
+	}
+
+	return iret;
+}
+
 uint32 SdmmcBootWriteLBA(uint8 ChipSel, uint32 LBA, void *pbuf, uint32 nSec, uint32 mode)
 {
 	uint32 iret = FTL_OK;
@@ -444,7 +594,8 @@ uint32 SdmmcSysDataLoad(uint8 ChipSel, uint32 Index, void *Buf)
 	return ret;
 }
 
-uint32 SdmmcSysDataStore(uint8 ChipSel, uint32 Index,void *Buf)
+/* nSec sys data sectors from Index, as a reliable write: keys and vendor data survive a power cut */
+uint32 SdmmcSysDataStoreN(uint8 ChipSel, uint32 Index, uint32 nSec, void *Buf)
 {
 	uint32 ret = FTL_ERROR;
 
@@ -457,13 +608,18 @@ uint32 SdmmcSysDataStore(uint8 ChipSel, uint32 Index,void *Buf)
 			EmmcSetBootPart(ChipSel, EMMC_BOOT_PART, EMMC_DATA_PART);
 		}
 #endif
-		ret = SDM_Write(ChipSel, SD_CARD_SYS_PART_OFFSET + Index, 1, Buf);
+		ret = SDM_WriteReliable(ChipSel, SD_CARD_SYS_PART_OFFSET + Index, nSec, Buf);
 		PRINT_E("SdmmcSysDataStore: %x, %x ret=%x\n", ChipSel, Index, ret);
 	}
 
 	return ret;
 }
 
+uint32 SdmmcSysDataStore(uint8 ChipSel, uint32 Index,void *Buf)
+{
+	return SdmmcSysDataStoreN(ChipSel, Index, 1, Buf);
+}
+
 uint32 SdmmcGetFwOffset(uint8 ChipSel)
 {
 	uint32 offset = 0;
@@ -27,11 +27,15 @@ extern uint32  SdmmcBootReadPBA(uint8 ChipSel, uint32 PBA, void *pbuf, uint32 nS
 extern uint32  SdmmcBootWritePBA(uint8 ChipSel, uint32 PBA, void *pbuf, uint32 nSec);
 extern void SdmmcCheckIdBlock(void);
 extern uint32 SdmmcBootReadLBA(uint8 ChipSel, uint32 LBA, void *pbuf, uint32 nSec);
+extern uint32 SdmmcBootReadLBA_async(uint8 ChipSel, uint32 LBA, void *pbuf, uint32 nSec);
+extern uint32 SdmmcBootReadLBA_wait(uint8 ChipSel);
 extern uint32 SdmmcBootWriteLBA(uint8 ChipSel, uint32 LBA, void *pbuf, uint32 nSec, uint32 mode);
+extern uint32 SdmmcBootWriteLBAPacked(uint8 ChipSel, STORAGE_WRITE_T *pWrite, uint32 count);
 extern uint32 SdmmcGetCapacity(uint8 ChipSel);
 
 extern uint32 SdmmcSysDataLoad(uint8 ChipSel, uint32 Index, void *Buf);
 extern uint32 SdmmcSysDataStore(uint8 ChipSel, uint32 Index, void *Buf);
+extern uint32 SdmmcSysDataStoreN(uint8 ChipSel, uint32 Index, uint32 nSec, void *Buf);
 extern uint32 EmmcSetBootPart(uint32 ChipSel, uint32 BootPart, uint32 AccessPart);
 extern uint32 SdmmcGetFwOffset(uint8 ChipSel);
 extern uint32 SdmmcGetSysOffset(uint8 ChipSel);
@@ -41,10 +41,23 @@ void CacheFlushDRegion(uint32 adr, uint32 size)
 }
 
 
+/*
+ * A line only partly inside the region also holds data we do not own, with a
+ * write-back cache it may be dirty: clean those instead of dropping them.
+ */
 void CacheInvalidateDRegion(uint32 adr, uint32 size)
 {
 #ifndef CONFIG_SYS_DCACHE_OFF
-	invalidate_dcache_range((unsigned long)adr, (unsigned long)adr + size);
+	unsigned long start = (unsigned long)adr & ~(ARCH_DMA_MINALIGN - 1);
+	unsigned long end = ALIGN((unsigned long)adr + size, ARCH_DMA_MINALIGN);
+
+	if (size == 0)
+		return;
+	if (start != adr)
+		flush_dcache_range(start, start + ARCH_DMA_MINALIGN);
+	if (end != adr + size)
+		flush_dcache_range(end - ARCH_DMA_MINALIGN, end);
+	invalidate_dcache_range(start, end);
 #endif
 }
 
@@ -166,6 +179,48 @@ int SCUSelSDClk(uint32 sdmmcId, uint32 div)
 }
 
 
+/*
+ * emmc clock phase, CRU_EMMC_CON0 is the drive clock and CRU_EMMC_CON1 the sample clock:
+ * bits [2:1] coarse phase in 90 degree, [10:3] delay elements, [11] delay enable.
+ */
+#define EMMC_PHASE_SHIFT		1
+#define EMMC_PHASE_MASK			0x7ff
+#define EMMC_PHASE_DELAY_SEL		(1 << 10)
+#define EMMC_SAMPLE_DELAY_UNIT		4	/* delay elements per fine step, ~60ps each */
+
+static void SCUSetEmmcPhase(uint32 reg, uint32 degree, uint32 delay)
+{
+	uint32 con;
+
+	con = ((degree / 90) & 0x3) | ((delay & 0xff) << 2) | (delay ? EMMC_PHASE_DELAY_SEL : 0);
+	cru_writel((con << EMMC_PHASE_SHIFT) | (EMMC_PHASE_MASK << (EMMC_PHASE_SHIFT + 16)), reg);
+}
+
+void SCUSetSDDrvPhase(uint32 sdmmcId, uint32 degree)
+{
+#ifdef CRU_EMMC_CON0
+	if (sdmmcId == 2) {
+		SCUSetEmmcPhase(CRU_EMMC_CON0, degree, 0);
+	}
+#endif
+}
+
+/*
+ * sample phase index 0 .. SD_SAMPLE_PHASE_NUM - 1 walks the sample clock later in time,
+ * each 90 degree step is split into SD_SAMPLE_PHASE_NUM / 4 fine delay steps.
+ */
+void SCUSetSDSamplePhase(uint32 sdmmcId, uint32 phase)
+{
+#ifdef CRU_EMMC_CON1
+	uint32 steps = SD_SAMPLE_PHASE_NUM / 4;
+
+	if (sdmmcId == 2) {
+		SCUSetEmmcPhase(CRU_EMMC_CON1, (phase / steps) * 90, (phase % steps) * EMMC_SAMPLE_DELAY_UNIT);
+	}
+#endif
+}
+
+
 void sdmmcGpioInit(uint32 ChipSel)
 {
 #ifdef RK_SDCARD_BOOT_EN
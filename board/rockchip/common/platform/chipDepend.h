@@ -21,6 +21,9 @@ extern uint32 GetMmcCLK(uint32 nSDCPort);
 extern void EmmcPowerEn(char En);
 extern void SDCReset(uint32 sdmmcId);
 extern int SCUSelSDClk(uint32 sdmmcId, uint32 div);
+#define SD_SAMPLE_PHASE_NUM	32
+extern void SCUSetSDDrvPhase(uint32 sdmmcId, uint32 degree);
+extern void SCUSetSDSamplePhase(uint32 sdmmcId, uint32 phase);
 extern void sdmmcGpioInit(uint32 ChipSel);
 extern void FW_NandDeInit(void);
 
@@ -23,18 +23,7 @@ void * ftl_memset(void *s, int c, unsigned int n)
 ***************************************************************************/
 void* ftl_memcpy(void* pvTo, const void* pvForm, unsigned int size)
 {
-	if(((unsigned long)pvTo & 0x3)||((unsigned long)pvForm & 0x3)) {
-		int i;
-		char * pTo = (char *)pvTo;
-		char * pForm = (char *)pvForm;
-
-		for(i=0;i<size;i++) {
-			*pTo++ = *pForm++;
-		}
-
-		return 0;
-	}
-
+	//memcpy never makes unaligned accesses, misaligned buffers included
 	return ((void*)memcpy(pvTo, pvForm, size));
 }
 
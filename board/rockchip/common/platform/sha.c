@@ -11,6 +11,9 @@
 //#include <string.h>
 #include "../config.h"
 #include "sha.h"
+#ifdef CONFIG_RK_SHA_NEON
+#include <u-boot/sha1.h>
+#endif
 
 extern void* ftl_memcpy(void* pvTo, const void* pvForm, unsigned int  size);
 
@@ -226,6 +229,20 @@ static void blk_SHA1_Block(SHA_CTX *ctx, const unsigned int *data)
 	ctx->H[4] += E;
 }
 
+static void blk_SHA1_Blocks(SHA_CTX *ctx, const void *data, unsigned int blocks)
+{
+#ifdef CONFIG_RK_SHA_NEON
+	unsigned int done = sha1_accel_blocks(ctx->H, data, blocks);
+
+	data = ((const char *)data + done * 64);
+	blocks -= done;
+#endif
+	while (blocks--) {
+		blk_SHA1_Block(ctx, data);
+		data = ((const char *)data + 64);
+	}
+}
+
 void SHA_init(SHA_CTX *ctx)
 {
 	ctx->size = 0;
@@ -255,12 +272,12 @@ void SHA_update(SHA_CTX *ctx, const void *data, unsigned int len)
 		data = ((const char *)data + left);
 		if (lenW)
 			return;
-		blk_SHA1_Block(ctx, ctx->W);
+		blk_SHA1_Blocks(ctx, ctx->W, 1);
 	}
-	while (len >= 64) {
-		blk_SHA1_Block(ctx, data);
-		data = ((const char *)data + 64);
-		len -= 64;
+	if (len >= 64) {
+		blk_SHA1_Blocks(ctx, data, len / 64);
+		data = ((const char *)data + (len & ~63));
+		len &= 63;
 	}
 	if (len)
 		ftl_memcpy(ctx->W, data, len);
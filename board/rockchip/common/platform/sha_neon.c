@@ -0,0 +1,363 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+/*
+ * SHA-1/SHA-256 block functions on the cpu vector unit.
+ *
+ * The arm v8 crypto extension hashes a whole block with a few sha
+ * instructions. Without it, the message schedule is expanded with neon
+ * four words at a time and only the rounds are done on the integer unit.
+ * What the cpu supports is probed at the first call, sha1_accel_blocks()
+ * and sha256_accel_blocks() return 0 when there is nothing to use, the
+ * caller then hashes with the portable c code.
+ *
+ * arm_neon.h brings in the compiler's stdint.h, whose types clash with
+ * the u-boot ones, so nothing from common.h is used here.
+ */
+#include <arm_neon.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+#define SHA_ACCEL_UNKNOWN	0
+#define SHA_ACCEL_NONE		1
+#define SHA_ACCEL_NEON		2
+#define SHA_ACCEL_CE		3
+
+static int sha1_accel = SHA_ACCEL_UNKNOWN;
+static int sha256_accel = SHA_ACCEL_UNKNOWN;
+
+static const uint32_t sha256_k[64] __attribute__((aligned(16))) = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+	0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+	0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+	0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+	0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+	0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+	0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+	0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+	0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+	0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+static const uint32_t sha1_k[4] = {
+	0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6,
+};
+
+#define ROR32(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+#define ROL32(x, n)	(((x) << (n)) | ((x) >> (32 - (n))))
+
+/* vector rotates, the shifted in bits are inserted by vsri */
+#define VROR4(x, n)	vsriq_n_u32(vshlq_n_u32(x, 32 - (n)), x, n)
+#define VROL4(x, n)	vsriq_n_u32(vshlq_n_u32(x, n), x, 32 - (n))
+#define VROR2(x, n)	vsri_n_u32(vshl_n_u32(x, 32 - (n)), x, n)
+
+static inline uint32x4_t vload_be32(const uint8_t *data)
+{
+	return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data)));
+}
+
+#ifdef __aarch64__
+static void sha_accel_probe(void)
+{
+	unsigned long isar0;
+
+	/* fp/simd is enabled at reset, it is always there on v8 */
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+
+	sha1_accel = SHA_ACCEL_NEON;
+	sha256_accel = SHA_ACCEL_NEON;
+#ifdef __ARM_FEATURE_CRYPTO
+	if ((isar0 >> 8) & 0xf)
+		sha1_accel = SHA_ACCEL_CE;
+	if ((isar0 >> 12) & 0xf)
+		sha256_accel = SHA_ACCEL_CE;
+#endif
+}
+#else
+static void sha_accel_probe(void)
+{
+	uint32_t cpacr, fpexc, mvfr1;
+
+	sha1_accel = SHA_ACCEL_NONE;
+	sha256_accel = SHA_ACCEL_NONE;
+
+	/* cp10/cp11 full access, reads back as 0 when there is no vfp/neon */
+	asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (cpacr));
+	cpacr |= (0xf << 20);
+	asm volatile("mcr p15, 0, %0, c1, c0, 2" : : "r" (cpacr));
+	asm volatile("isb" : : : "memory");
+	asm volatile("mrc p15, 0, %0, c1, c0, 2" : "=r" (cpacr));
+	if ((cpacr & (0xf << 20)) != (0xf << 20))
+		return;
+
+	fpexc = (1 << 30);
+	asm volatile("vmsr fpexc, %0" : : "r" (fpexc));
+
+	/* advanced simd load/store and integer instructions */
+	asm volatile("vmrs %0, mvfr1" : "=r" (mvfr1));
+	if (!((mvfr1 >> 8) & 0xf) || !((mvfr1 >> 12) & 0xf))
+		return;
+
+	sha1_accel = SHA_ACCEL_NEON;
+	sha256_accel = SHA_ACCEL_NEON;
+}
+#endif
+
+#ifdef __ARM_FEATURE_CRYPTO
+static void sha1_ce_blocks(uint32_t state[5], const uint8_t *data,
+		unsigned int blocks)
+{
+	uint32x4_t abcd = vld1q_u32(state);
+	uint32_t e = state[4];
+	uint32x4_t abcd0, msg[4], wk;
+	uint32_t e0, e1;
+	int i;
+
+	while (blocks--) {
+		abcd0 = abcd;
+		e0 = e;
+
+		for (i = 0; i < 4; i++)
+			msg[i] = vload_be32(data + i * 16);
+
+		/* 20 groups of 4 rounds, w[16..79] are expanded on the way */
+		for (i = 0; i < 20; i++) {
+			wk = vaddq_u32(msg[i & 3], vdupq_n_u32(sha1_k[i / 5]));
+			e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+			if (i < 5)
+				abcd = vsha1cq_u32(abcd, e, wk);
+			else if (i >= 10 && i < 15)
+				abcd = vsha1mq_u32(abcd, e, wk);
+			else
+				abcd = vsha1pq_u32(abcd, e, wk);
+			e = e1;
+
+			if (i < 16)
+				msg[i & 3] = vsha1su1q_u32(vsha1su0q_u32(msg[i & 3],
+						msg[(i + 1) & 3], msg[(i + 2) & 3]),
+						msg[(i + 3) & 3]);
+		}
+
+		abcd = vaddq_u32(abcd, abcd0);
+		e += e0;
+		data += 64;
+	}
+
+	vst1q_u32(state, abcd);
+	state[4] = e;
+}
+
+static void sha256_ce_blocks(uint32_t state[8], const uint8_t *data,
+		unsigned int blocks)
+{
+	uint32x4_t abcd = vld1q_u32(&state[0]);
+	uint32x4_t efgh = vld1q_u32(&state[4]);
+	uint32x4_t abcd0, efgh0, msg[4], wk, tmp;
+	int i;
+
+	while (blocks--) {
+		abcd0 = abcd;
+		efgh0 = efgh;
+
+		for (i = 0; i < 4; i++)
+			msg[i] = vload_be32(data + i * 16);
+
+		/* 16 groups of 4 rounds, w[16..63] are expanded on the way */
+		for (i = 0; i < 16; i++) {
+			wk = vaddq_u32(msg[i & 3], vld1q_u32(&sha256_k[i * 4]));
+			if (i < 12)
+				msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3],
+						msg[(i + 1) & 3]),
+						msg[(i + 2) & 3], msg[(i + 3) & 3]);
+			tmp = abcd;
+			abcd = vsha256hq_u32(abcd, efgh, wk);
+			efgh = vsha256h2q_u32(efgh, tmp, wk);
+		}
+
+		abcd = vaddq_u32(abcd, abcd0);
+		efgh = vaddq_u32(efgh, efgh0);
+		data += 64;
+	}
+
+	vst1q_u32(&state[0], abcd);
+	vst1q_u32(&state[4], efgh);
+}
+#endif /* __ARM_FEATURE_CRYPTO */
+
+static void sha1_neon_blocks(uint32_t state[5], const uint8_t *data,
+		unsigned int blocks)
+{
+	uint32_t w[80] __attribute__((aligned(16)));
+	uint32_t a, b, c, d, e, f, temp;
+	uint32x4_t x;
+	int t;
+
+	while (blocks--) {
+		for (t = 0; t < 16; t += 4)
+			vst1q_u32(&w[t], vload_be32(data + t * 4));
+
+		/*
+		 * w[t] = rol(w[t-3] ^ w[t-8] ^ w[t-14] ^ w[t-16], 1), the last
+		 * lane needs w[t] of the first lane, it is patched in after.
+		 */
+		for (t = 16; t < 80; t += 4) {
+			x = veorq_u32(vld1q_u32(&w[t - 8]), vld1q_u32(&w[t - 14]));
+			x = veorq_u32(x, vld1q_u32(&w[t - 16]));
+			x = veorq_u32(x, vsetq_lane_u32(0, vld1q_u32(&w[t - 3]), 3));
+			x = VROL4(x, 1);
+			x = veorq_u32(x, VROL4(vextq_u32(vdupq_n_u32(0), x, 1), 1));
+			vst1q_u32(&w[t], x);
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+
+		for (t = 0; t < 80; t++) {
+			if (t < 20)
+				f = ((c ^ d) & b) ^ d;
+			else if (t >= 40 && t < 60)
+				f = (b & c) | (d & (b | c));
+			else
+				f = b ^ c ^ d;
+			temp = ROL32(a, 5) + f + e + sha1_k[t / 20] + w[t];
+			e = d;
+			d = c;
+			c = ROL32(b, 30);
+			b = a;
+			a = temp;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		data += 64;
+	}
+}
+
+#define S0(x)	(ROR32(x, 2) ^ ROR32(x, 13) ^ ROR32(x, 22))
+#define S1(x)	(ROR32(x, 6) ^ ROR32(x, 11) ^ ROR32(x, 25))
+
+static void sha256_neon_blocks(uint32_t state[8], const uint8_t *data,
+		unsigned int blocks)
+{
+	uint32_t w[64] __attribute__((aligned(16)));
+	uint32_t a, b, c, d, e, f, g, h, t1, t2;
+	uint32x4_t x, s0;
+	uint32x2_t lo, hi, s1;
+	int t;
+
+	while (blocks--) {
+		for (t = 0; t < 16; t += 4)
+			vst1q_u32(&w[t], vload_be32(data + t * 4));
+
+		/*
+		 * w[t] = s1(w[t-2]) + w[t-7] + s0(w[t-15]) + w[t-16], all but
+		 * s1 go four lanes at once, s1 depends on the two previous
+		 * words, so it is added to each half in turn.
+		 */
+		for (t = 16; t < 64; t += 4) {
+			x = vld1q_u32(&w[t - 15]);
+			s0 = veorq_u32(VROR4(x, 7), VROR4(x, 18));
+			s0 = veorq_u32(s0, vshrq_n_u32(x, 3));
+			x = vaddq_u32(vld1q_u32(&w[t - 16]), vld1q_u32(&w[t - 7]));
+			x = vaddq_u32(x, s0);
+
+			lo = vld1_u32(&w[t - 2]);
+			s1 = veor_u32(VROR2(lo, 17), VROR2(lo, 19));
+			s1 = veor_u32(s1, vshr_n_u32(lo, 10));
+			lo = vadd_u32(vget_low_u32(x), s1);
+
+			s1 = veor_u32(VROR2(lo, 17), VROR2(lo, 19));
+			s1 = veor_u32(s1, vshr_n_u32(lo, 10));
+			hi = vadd_u32(vget_high_u32(x), s1);
+
+			vst1q_u32(&w[t], vcombine_u32(lo, hi));
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		for (t = 0; t < 64; t++) {
+			t1 = h + S1(e) + (g ^ (e & (f ^ g))) + sha256_k[t] + w[t];
+			t2 = S0(a) + ((a & b) | (c & (a | b)));
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+		data += 64;
+	}
+}
+
+int sha1_accel_blocks(uint32_t state[5], const unsigned char *data,
+		unsigned int blocks)
+{
+	if (sha1_accel == SHA_ACCEL_UNKNOWN)
+		sha_accel_probe();
+
+	switch (sha1_accel) {
+#ifdef __ARM_FEATURE_CRYPTO
+	case SHA_ACCEL_CE:
+		sha1_ce_blocks(state, data, blocks);
+		return blocks;
+#endif
+	case SHA_ACCEL_NEON:
+		sha1_neon_blocks(state, data, blocks);
+		return blocks;
+	default:
+		return 0;
+	}
+}
+
+int sha256_accel_blocks(uint32_t state[8], const uint8_t *data,
+		unsigned int blocks)
+{
+	if (sha256_accel == SHA_ACCEL_UNKNOWN)
+		sha_accel_probe();
+
+	switch (sha256_accel) {
+#ifdef __ARM_FEATURE_CRYPTO
+	case SHA_ACCEL_CE:
+		sha256_ce_blocks(state, data, blocks);
+		return blocks;
+#endif
+	case SHA_ACCEL_NEON:
+		sha256_neon_blocks(state, data, blocks);
+		return blocks;
+	default:
+		return 0;
+	}
+}
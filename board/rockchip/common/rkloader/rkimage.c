@@ -73,10 +73,184 @@ int rkimage_load_image(rk_boot_img_hdr *hdr, const disk_partition_t *boot_ptn, \
 
 //base on ti's common/cmd_fastboot.c
 
+#define SPARSE_BUF_SIZE		CONFIG_RK_SPARSE_WRITE_BUF_SIZE
+/* chunks up to this size are staged and merged with their neighbours */
+#define SPARSE_STAGE_MAX	(SPARSE_BUF_SIZE >> 2)
+
+/*
+ * Small RAW and FILL chunks landing on consecutive sectors are gathered
+ * in the batch buffer and written with one storage request. Big FILL
+ * chunks are written straight from the pattern buffer, which is only
+ * refilled when the fill value changes. Both buffers are kept across images.
+ */
+struct sparse_writer {
+	u8 *batch;
+	lbaint_t batch_start;
+	u32 batch_len;
+	u32 *pattern;
+	u32 pattern_val;
+	bool pattern_valid;
+	bool check_crc;
+	u32 crc;
+};
+
+static struct sparse_writer sparse_writer;
+
+static int sparse_writer_init(struct sparse_writer *w, bool check_crc)
+{
+	if (!w->batch)
+		w->batch = memalign(ARCH_DMA_MINALIGN, SPARSE_BUF_SIZE);
+	if (!w->pattern)
+		w->pattern = memalign(ARCH_DMA_MINALIGN, SPARSE_BUF_SIZE);
+	if (!w->batch || !w->pattern) {
+		printf("sparse: no memory for write buffers\n");
+		return -1;
+	}
+
+	w->batch_len = 0;
+	w->check_crc = check_crc;
+	w->crc = 0;
+	return 0;
+}
+
+static int sparse_writer_flush(struct sparse_writer *w)
+{
+	if (!w->batch_len)
+		return 0;
+
+	FBTDBG("sparse: flush(sector=%lu,len=%u)\n", w->batch_start, w->batch_len);
+	if (rkloader_CopyMemory2Flash((uint32)(unsigned long)w->batch,
+				w->batch_start, w->batch_len / RK_BLK_SIZE)) {
+		printf("sparse: block write to sector %lu"
+				" of %u bytes failed\n", w->batch_start, w->batch_len);
+		return -1;
+	}
+	w->batch_len = 0;
+	return 0;
+}
+
+/* reserve len bytes of the batch buffer for data going to sector */
+static u8 *sparse_writer_stage(struct sparse_writer *w, lbaint_t sector, u32 len)
+{
+	u8 *dst;
+
+	if (w->batch_len && (sector != w->batch_start + w->batch_len / RK_BLK_SIZE
+				|| w->batch_len + len > SPARSE_BUF_SIZE)) {
+		if (sparse_writer_flush(w))
+			return NULL;
+	}
+	if (!w->batch_len)
+		w->batch_start = sector;
+
+	dst = w->batch + w->batch_len;
+	w->batch_len += len;
+	return dst;
+}
+
+static void sparse_fill_pattern(struct sparse_writer *w, u32 val)
+{
+	u32 i;
+
+	if (w->pattern_valid && w->pattern_val == val)
+		return;
+	for (i = 0; i < SPARSE_BUF_SIZE / sizeof(u32); i++)
+		w->pattern[i] = val;
+	w->pattern_val = val;
+	w->pattern_valid = true;
+}
+
+static void sparse_crc_pattern(struct sparse_writer *w, u64 len)
+{
+	while (len) {
+		u32 n = min(len, (u64)SPARSE_BUF_SIZE);
+
+		w->crc = crc32(w->crc, (unsigned char *)w->pattern, n);
+		len -= n;
+	}
+}
+
+static int sparse_write_raw(struct sparse_writer *w, lbaint_t sector,
+		unsigned char *data, u64 len)
+{
+	u8 *dst;
+
+	if (w->check_crc)
+		w->crc = crc32(w->crc, data, len);
+
+	if (len <= SPARSE_STAGE_MAX) {
+		dst = sparse_writer_stage(w, sector, len);
+		if (!dst)
+			return -1;
+		memcpy(dst, data, len);
+		return 0;
+	}
+
+	if (sparse_writer_flush(w))
+		return -1;
+	if (rkloader_CopyMemory2Flash((uint32)(unsigned long)data, sector, len / RK_BLK_SIZE)) {
+		printf("sparse: block write to sector %lu"
+				" of %llu bytes failed\n", sector, len);
+		return -1;
+	}
+	return 0;
+}
+
+static int sparse_write_fill(struct sparse_writer *w, lbaint_t sector,
+		u32 val, u64 len)
+{
+	u8 *dst;
+
+	sparse_fill_pattern(w, val);
+	if (w->check_crc)
+		sparse_crc_pattern(w, len);
+
+	if (len <= SPARSE_STAGE_MAX) {
+		dst = sparse_writer_stage(w, sector, len);
+		if (!dst)
+			return -1;
+		memcpy(dst, w->pattern, len);
+		return 0;
+	}
+
+	if (sparse_writer_flush(w))
+		return -1;
+	while (len) {
+		u32 n = min(len, (u64)SPARSE_BUF_SIZE);
+
+		if (rkloader_CopyMemory2Flash((uint32)(unsigned long)w->pattern,
+					sector, n / RK_BLK_SIZE)) {
+			printf("sparse: fill write to sector %lu"
+					" of %u bytes failed\n", sector, n);
+			return -1;
+		}
+		sector += n / RK_BLK_SIZE;
+		len -= n;
+	}
+	return 0;
+}
+
+/* crc32 over the output is only worth computing if something checks it */
+static bool sparse_need_crc(sparse_header_t *header, unsigned char *source)
+{
+	u32 i;
+
+	if (header->image_checksum)
+		return true;
+	for (i = 0; i < header->total_chunks; i++) {
+		chunk_header_t *chunk = (void *) source;
+
+		if (chunk->chunk_type == CHUNK_TYPE_CRC32)
+			return true;
+		source += chunk->total_sz;
+	}
+	return false;
+}
+
 static int unsparse(unsigned char *source,
 		lbaint_t sector, lbaint_t size_kb)
 {
 	sparse_header_t *header = (void *) source;
+	struct sparse_writer *w = &sparse_writer;
 	u32 i;
 	unsigned long blksz = RK_BLK_SIZE;
 	u64 section_size = (u64)size_kb << 10;
@@ -106,16 +280,20 @@ static int unsparse(unsigned char *source,
 
 	if ((header->major_version != SPARSE_HEADER_MAJOR_VER) ||
 			(header->file_hdr_sz != sizeof(sparse_header_t)) ||
-			(header->chunk_hdr_sz != sizeof(chunk_header_t))) {
+			(header->chunk_hdr_sz != sizeof(chunk_header_t)) ||
+			!header->blk_sz || (header->blk_sz % blksz)) {
 		printf("sparse: incompatible format\n");
 		return 1;
 	}
 	/* Skip the header now */
 	source += header->file_hdr_sz;
 
+	if (sparse_writer_init(w, sparse_need_crc(header, source)))
+		return 1;
+
 	for (i = 0; i < header->total_chunks; i++) {
 		u64 clen = 0;
-		lbaint_t blkcnt;
+		u32 val;
 		chunk_header_t *chunk = (void *) source;
 
 		FBTDBG("chunk_header:\n");
@@ -124,10 +302,10 @@ static int unsparse(unsigned char *source,
 		FBTDBG("\t      total_sz=%u\n", chunk->total_sz);
 		/* move to next chunk */
 		source += sizeof(chunk_header_t);
+		clen = (u64)chunk->chunk_sz * header->blk_sz;
 
 		switch (chunk->chunk_type) {
 			case CHUNK_TYPE_RAW:
-				clen = (u64)chunk->chunk_sz * header->blk_sz;
 				FBTDBG("sparse: RAW blk=%d bsz=%d:"
 						" write(sector=%lu,clen=%llu)\n",
 						chunk->chunk_sz, header->blk_sz, sector, clen);
@@ -144,20 +322,37 @@ static int unsparse(unsigned char *source,
 							" exceeded\n", section_size/(1024*1024));
 					return 1;
 				}
-				blkcnt = clen / blksz;
-				FBTDBG("sparse: RAW blk=%d bsz=%d:"
+
+				if (sparse_write_raw(w, sector, source, clen))
+					return 1;
+
+				sector += (clen / blksz);
+				source += clen;
+				break;
+
+			case CHUNK_TYPE_FILL:
+				if (chunk->total_sz != (sizeof(chunk_header_t) + sizeof(u32))) {
+					printf("sparse: bad chunk size for"
+							" chunk %d, type Fill\n", i);
+					return 1;
+				}
+				val = *(u32 *)source;
+				FBTDBG("sparse: FILL blk=%d bsz=%d val=0x%08x:"
 						" write(sector=%lu,clen=%llu)\n",
-						chunk->chunk_sz, header->blk_sz, sector, clen);
+						chunk->chunk_sz, header->blk_sz, val, sector, clen);
 
-				if (rkloader_CopyMemory2Flash((uint32)(unsigned long)source, sector, blkcnt)) {
-					printf("sparse: block write to sector %lu"
-							" of %llu bytes (%ld blkcnt) failed\n",
-							sector, clen, blkcnt);
+				outlen += clen;
+				if (outlen > section_size) {
+					printf("sparse: section size %llu MB limit:"
+							" exceeded\n", section_size/(1024*1024));
 					return 1;
 				}
 
+				if (sparse_write_fill(w, sector, val, clen))
+					return 1;
+
 				sector += (clen / blksz);
-				source += clen;
+				source += sizeof(u32);
 				break;
 
 			case CHUNK_TYPE_DONT_CARE:
@@ -165,7 +360,6 @@ static int unsparse(unsigned char *source,
 					printf("sparse: bogus DONT CARE chunk\n");
 					return 1;
 				}
-				clen = (u64)chunk->chunk_sz * header->blk_sz;
 				FBTDBG("sparse: DONT_CARE blk=%d bsz=%d:"
 						" skip(sector=%lu,clen=%llu)\n",
 						chunk->chunk_sz, header->blk_sz, sector, clen);
@@ -176,9 +370,29 @@ static int unsparse(unsigned char *source,
 							" exceeded\n", section_size/(1024*1024));
 					return 1;
 				}
+				/* skipped blocks count as zeroes for the crc32 */
+				if (w->check_crc) {
+					sparse_fill_pattern(w, 0);
+					sparse_crc_pattern(w, clen);
+				}
 				sector += (clen / blksz);
 				break;
 
+			case CHUNK_TYPE_CRC32:
+				if (chunk->total_sz != (sizeof(chunk_header_t) + sizeof(u32))) {
+					printf("sparse: bogus CRC32 chunk\n");
+					return 1;
+				}
+				val = *(u32 *)source;
+				FBTDBG("sparse: CRC32 0x%08x, calc 0x%08x\n", val, w->crc);
+				if (val != w->crc) {
+					printf("sparse: crc32 mismatch at chunk %d"
+							" (0x%08x != 0x%08x)\n", i, val, w->crc);
+					return 1;
+				}
+				source += sizeof(u32);
+				break;
+
 			default:
 				printf("sparse: unknown chunk ID %04x\n",
 						chunk->chunk_type);
@@ -186,6 +400,15 @@ static int unsparse(unsigned char *source,
 		}
 	}
 
+	if (sparse_writer_flush(w))
+		return 1;
+
+	if (header->image_checksum && header->image_checksum != w->crc) {
+		printf("sparse: image checksum mismatch (0x%08x != 0x%08x)\n",
+				header->image_checksum, w->crc);
+		return 1;
+	}
+
 	printf("sparse: out-length %llu MB\n", outlen/(1024*1024));
 	return 0;
 }
@@ -302,10 +525,22 @@ int rkimage_store_image(const char *name, const disk_partition_t *ptn,
 	{
 		//flash parameter.
 		int i, ret = -1, len = 0;
+		STORAGE_WRITE_T writes[PARAMETER_NUM];
 		len = rkimg_buildParameter(priv->transfer_buffer, priv->d_bytes);
 
 		printf("Write parameter\n");
 		for(i=0; i<PARAMETER_NUM; i++)
+		{
+			writes[i].LBA = i*PARAMETER_OFFSET;
+			writes[i].pbuf = priv->transfer_buffer;
+			writes[i].nSec = DIV_ROUND_UP(len, RK_BLK_SIZE);
+		}
+		//all copies in one go, or one by one where that fails: one good copy will do
+		if (!StorageWriteLbaPacked(writes, PARAMETER_NUM))
+		{
+			goto ok;
+		}
+		for(i=0; i<PARAMETER_NUM; i++)
 		{
 			if (!StorageWriteLba(i*PARAMETER_OFFSET, priv->transfer_buffer, 
 						DIV_ROUND_UP(len, RK_BLK_SIZE), 0))
@@ -372,21 +607,27 @@ fail:
 		buf += size; len -= size; \
 	}
 
-//direct download to storage, and return wrote len.
-static int rkimg_handleDirectDownload(unsigned char *buffer, 
-		int length, struct cmd_fastboot_interface *priv)
+/*
+ * direct download to storage, and return wrote len.
+ * unless forced, data is only written once a chunk is complete or
+ * CONFIG_FASTBOOT_FLASH_COMMIT_SIZE bytes are pending, the rest stays in the ring.
+ */
+static int rkimg_handleDirectDownload(unsigned char *buffer,
+		int length, struct cmd_fastboot_interface *priv, bool force)
 {
-	int size = priv->d_direct_size;
+	u64 size = priv->d_direct_size;
 	int avail_len = length;
 	int write_len = 0;
 	if (avail_len >= size) {
 		write_len = size;
-	} else {
+	} else if (force || avail_len >= CONFIG_FASTBOOT_FLASH_COMMIT_SIZE) {
 		write_len = avail_len / RK_BLK_SIZE * RK_BLK_SIZE;
 	}
+	if (!write_len)
+		return 0;
 	int blocks = DIV_ROUND_UP(write_len, RK_BLK_SIZE);
 
-	FBTDBG("direct download, size:%d, offset:%lld, rest:%lld\n",
+	FBTDBG("direct download, size:%lld, offset:%lld, rest:%lld\n",
 			size, priv->d_direct_offset, priv->d_direct_size - write_len);
 
 	if(StorageWriteLba(priv->d_direct_offset + priv->pending_ptn->start,
@@ -399,25 +640,24 @@ static int rkimg_handleDirectDownload(unsigned char *buffer,
 	return write_len;
 }
 
-static void rkimg_noBuffer(unsigned char *buffer,
+static void rkimg_keepPending(unsigned char *buffer,
 		int length, struct cmd_fastboot_interface *priv)
 {
-	if (length) {
-		//cache rest buffer.
-		memcpy(priv->d_cache, buffer, length);
-		priv->d_cache_pos = length;
+	//rest data stays in the ring, the next transfer is received right behind it.
+	priv->d_pending = buffer;
+	priv->d_pending_len = length;
+	if (length)
 		FBTDBG("rest:%d\n", length);
-	}
 }
 
 static int rkimg_ImageDownload(unsigned char *buffer,
-		int length, struct cmd_fastboot_interface *priv)
+		int length, struct cmd_fastboot_interface *priv, bool force)
 {
 	if (!priv->d_direct_size) {
 		//should not reach here.
 		return 0;
 	}
-	int ret = rkimg_handleDirectDownload(buffer, length, priv);
+	int ret = rkimg_handleDirectDownload(buffer, length, priv, force);
 	if (ret < 0) {
 		priv->d_status = -1;
 		return 0;
@@ -426,7 +666,7 @@ static int rkimg_ImageDownload(unsigned char *buffer,
 
 	//not done yet!
 	if (priv->d_direct_size) {
-		rkimg_noBuffer(buffer, length, priv);
+		rkimg_keepPending(buffer, length, priv);
 		return 1;
 	}
 	FBTDBG("image download compelete\n");
@@ -435,12 +675,12 @@ static int rkimg_ImageDownload(unsigned char *buffer,
 }
 
 static int rkimg_handleSparseDownload(unsigned char *buffer,
-		int length, struct cmd_fastboot_interface *priv)
+		int length, struct cmd_fastboot_interface *priv, bool force)
 {
 	int ret;
 	if (priv->d_direct_size) {
 		//continue direct download
-		ret = rkimg_handleDirectDownload(buffer, length, priv);
+		ret = rkimg_handleDirectDownload(buffer, length, priv, force);
 		if (ret < 0) {
 			priv->d_status = -1;
 			return 0;
@@ -448,32 +688,42 @@ static int rkimg_handleSparseDownload(unsigned char *buffer,
 		CONSUMED(buffer, length, ret);
 
 		//not done yet!
-	  	if (priv->d_direct_size) {
-				rkimg_noBuffer(buffer, length, priv);
-				return 1;
+		if (priv->d_direct_size) {
+			rkimg_keepPending(buffer, length, priv);
+			return 1;
 		}
 	}
-	chunk_header_t* chunk = (chunk_header_t*)calloc(sizeof(chunk_header_t), 1);
+	chunk_header_t chunk;
 	sparse_header_t* header = &priv->sparse_header;
 	u64 clen = 0;
+	u32 val;
 	while (priv->sparse_cur_chunk < header->total_chunks) {
 		if (length < sizeof(chunk_header_t)) {
-			rkimg_noBuffer(buffer, length, priv);
+			rkimg_keepPending(buffer, length, priv);
 			return 1;
 		}
+		//chunk headers sit at any offset of the ring.
+		memcpy(&chunk, buffer, sizeof(chunk_header_t));
+		if (chunk.chunk_type == CHUNK_TYPE_FILL ||
+				chunk.chunk_type == CHUNK_TYPE_CRC32) {
+			if (length < sizeof(chunk_header_t) + sizeof(u32)) {
+				rkimg_keepPending(buffer, length, priv);
+				return 1;
+			}
+			memcpy(&val, buffer + sizeof(chunk_header_t), sizeof(u32));
+		}
 		priv->sparse_cur_chunk++;
-		memcpy(chunk, buffer, sizeof(chunk_header_t));
 		CONSUMED(buffer, length, sizeof(chunk_header_t));
 
-		switch (chunk->chunk_type) {
+		clen = (u64)chunk.chunk_sz * header->blk_sz;
+		switch (chunk.chunk_type) {
 			case CHUNK_TYPE_RAW:
-				clen = (u64)chunk->chunk_sz * header->blk_sz;
 				FBTDBG("sparse: RAW blk=%d bsz=%d:"
 						" write(sector=%llu,clen=%llu)\n",
-						chunk->chunk_sz, header->blk_sz,
+						chunk.chunk_sz, header->blk_sz,
 						priv->d_direct_offset, clen);
 
-				if (chunk->total_sz != (clen + sizeof(chunk_header_t))) {
+				if (chunk.total_sz != (clen + sizeof(chunk_header_t))) {
 					printf("sparse: bad chunk size for"
 							" chunk %d, type Raw\n", priv->sparse_cur_chunk);
 					goto failed;
@@ -481,7 +731,7 @@ static int rkimg_handleSparseDownload(unsigned char *buffer,
 
 				priv->d_direct_size = clen;
 
-				ret = rkimg_handleDirectDownload(buffer, length, priv);
+				ret = rkimg_handleDirectDownload(buffer, length, priv, force);
 				if (ret < 0) {
 					priv->d_status = -1;
 					return 0;
@@ -490,31 +740,59 @@ static int rkimg_handleSparseDownload(unsigned char *buffer,
 
 				//not done yet!
 				if (priv->d_direct_size) {
-					rkimg_noBuffer(buffer, length, priv);
+					rkimg_keepPending(buffer, length, priv);
 					return 1;
 				}
 				break;
+			case CHUNK_TYPE_FILL:
+				if (chunk.total_sz != (sizeof(chunk_header_t) + sizeof(u32))) {
+					printf("sparse: bad chunk size for"
+							" chunk %d, type Fill\n", priv->sparse_cur_chunk);
+					goto failed;
+				}
+				FBTDBG("sparse: FILL blk=%d bsz=%d val=0x%08x:"
+						" write(sector=%llu,clen=%llu)\n",
+						chunk.chunk_sz, header->blk_sz, val,
+						priv->d_direct_offset, clen);
+
+				if (sparse_write_fill(&sparse_writer,
+							priv->pending_ptn->start + priv->d_direct_offset,
+							val, clen))
+					goto failed;
+				priv->d_direct_offset += (clen / RK_BLK_SIZE);
+				CONSUMED(buffer, length, sizeof(u32));
+				break;
 			case CHUNK_TYPE_DONT_CARE:
-				if (chunk->total_sz != sizeof(chunk_header_t)) {
+				if (chunk.total_sz != sizeof(chunk_header_t)) {
 					printf("sparse: bogus DONT CARE chunk\n");
 					goto failed;
 				}
-				clen = (u64)chunk->chunk_sz * header->blk_sz;
 				FBTDBG("sparse: DONT_CARE blk=%d bsz=%d:"
 						" skip(sector=%llu,clen=%llu)\n",
-						chunk->chunk_sz, header->blk_sz, priv->d_direct_offset, clen);
+						chunk.chunk_sz, header->blk_sz, priv->d_direct_offset, clen);
 
 				priv->d_direct_offset += (clen / RK_BLK_SIZE);
 				break;
+			case CHUNK_TYPE_CRC32:
+				//the image is not kept, nothing to check the crc32 against.
+				if (chunk.total_sz != (sizeof(chunk_header_t) + sizeof(u32))) {
+					printf("sparse: bogus CRC32 chunk\n");
+					goto failed;
+				}
+				FBTDBG("sparse: CRC32 0x%08x skipped\n", val);
+				CONSUMED(buffer, length, sizeof(u32));
+				break;
 
 			default:
 				FBTERR("sparse: unknown chunk ID %04x\n",
-						chunk->chunk_type);
+						chunk.chunk_type);
 				goto failed;
 		}
 	}
 
 	//complete
+	if (sparse_writer_flush(&sparse_writer))
+		goto failed;
 	priv->d_status = 1;
 	return 0;
 
@@ -523,8 +801,19 @@ failed:
 	return 0;
 }
 
+static int rkimg_continueDownload(unsigned char *buffer,
+		int length, struct cmd_fastboot_interface *priv, bool force)
+{
+	priv->d_pending_len = 0;
+	if (priv->flag_sparse) {
+		return rkimg_handleSparseDownload(buffer, length, priv, force);
+	} else {
+		return rkimg_ImageDownload(buffer, length, priv, force);
+	}
+}
+
 static int rkimg_startDownload(unsigned char *buffer,
-		int length, struct cmd_fastboot_interface *priv)
+		int length, struct cmd_fastboot_interface *priv, bool force)
 {
 #if 0
 	printf("start download, receive:\n");
@@ -541,7 +830,7 @@ static int rkimg_startDownload(unsigned char *buffer,
 	priv->d_direct_size = 0;
 	priv->d_direct_offset = 0;
 	priv->sparse_cur_chunk = 0;
-	priv->d_cache_pos = 0;
+	priv->d_pending_len = 0;
 
 	//check sparse image
 	sparse_header_t* header = &priv->sparse_header;
@@ -554,13 +843,18 @@ static int rkimg_startDownload(unsigned char *buffer,
 
 		CONSUMED(buffer, length, sizeof(sparse_header_t));
 
+		if (sparse_writer_init(&sparse_writer, false)) {
+			priv->d_status = -1;
+			return 0;
+		}
+
 		FBTDBG("found sparse image\n");
-		return rkimg_handleSparseDownload(buffer, length, priv);
+		return rkimg_handleSparseDownload(buffer, length, priv, force);
 	}
 
 #if 1
 	priv->d_direct_size = priv->d_size;
-	return rkimg_ImageDownload(buffer, length, priv);
+	return rkimg_ImageDownload(buffer, length, priv, force);
 #else //only support ext image
 	//check ext image
 	filesystem* fs = (filesystem*) buffer;
@@ -568,7 +862,7 @@ static int rkimg_startDownload(unsigned char *buffer,
 			fs->sb.s_magic == EXT3_MAGIC_NUMBER) {
 		priv->d_direct_size = priv->d_size;
 		FBTDBG("found ext image\n");
-		return rkimg_ImageDownload(buffer, length, priv);
+		return rkimg_ImageDownload(buffer, length, priv, force);
 	}
 
 	priv->d_status = -1;
@@ -602,38 +896,40 @@ int rkimage_handleDownload(unsigned char *buffer,
 		return 0;
 	}
 
+	//the last transfer, write out everything.
+	bool last = length + priv->d_bytes >= priv->d_size;
+
 	//start to download something.
 	bool start = priv->d_bytes == 0;
 
 	if (start) {
 		FBTDBG("start download, length:%d\n", length);
-		return rkimg_startDownload(buffer, length, priv);
-	}
-
-	//check buffer size.
-	if (length + priv->d_cache_pos > sizeof(priv->d_cache)) {
-		FBTDBG("something wrong with d_cache, pose:%d, len %d\n",
-				priv->d_cache_pos, length);
-		priv->d_status = -1;
-		return 0;
+		return rkimg_startDownload(buffer, length, priv, last);
 	}
 
-	if (priv->d_cache_pos) {
-		memcpy(priv->d_cache + priv->d_cache_pos, buffer, length);
-		length += priv->d_cache_pos;
-		buffer = priv->d_cache;
-		priv->d_cache_pos = 0;
-		if (!priv->flag_sparse) {
-			FBTERR("normal image should not get here!\n");
+	if (priv->d_pending_len) {
+		if (priv->d_pending + priv->d_pending_len != buffer) {
+			//ring wrapped, write out pending data and move the partial
+			//block left in front of the new transfer.
+			FBTDBG("ring wrapped, pending:%d\n", priv->d_pending_len);
+			if (!rkimg_continueDownload(priv->d_pending,
+						priv->d_pending_len, priv, true))
+				return 0;
+			if (priv->d_pending_len > buffer - priv->buffer[0]) {
+				FBTERR("something wrong with pending data, len %d\n",
+						priv->d_pending_len);
+				priv->d_status = -1;
+				return 0;
+			}
+			memmove(buffer - priv->d_pending_len, priv->d_pending,
+					priv->d_pending_len);
 		}
+		length += priv->d_pending_len;
+		buffer -= priv->d_pending_len;
 	}
 
 	FBTDBG("continue download, length:%d\n", length);
-	if (priv->flag_sparse) {
-		return rkimg_handleSparseDownload(buffer, length, priv);
-	} else {
-		return rkimg_ImageDownload(buffer, length, priv);
-	}
+	return rkimg_continueDownload(buffer, length, priv, last);
 }
 
 
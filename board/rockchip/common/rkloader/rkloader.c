@@ -26,68 +26,109 @@
 #include "rkloader.h"
 
 
-#if 0
-#define MaxFlashReadSize  16384  //8MB
-int32 rkloader_CopyFlash2Memory(uint32 dest_addr, uint32 src_addr, uint32 total_sec)
+/*
+ * Flash <-> memory copies move the sectors straight between the media and
+ * the caller's memory, in requests as large as the storage layer takes.
+ * The controllers dma whole words, memory off a word boundary goes through
+ * a bounce buffer. A read to memory off a cache line bounces its first and
+ * last sectors only: the lines the dma shares are then ours, never the
+ * caller's neighbours'.
+ */
+#define MaxFlashReadSize  128		//64KB, bounce buffer
+#define MaxFlashXferSize  0x8000	//16MB, one request: 16 bit nSec, 0xffff idmac blocks
+
+static int32 rkloader_ReadBounce(uint32 LBA, uint8 *pSdram, uint32 total_sec)
 {
-	uint8 * pSdram = (uint8*)dest_addr;
-	uint16 sec = 0;
-	uint32 LBA = src_addr;
-	uint32 remain_sec = total_sec;
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, RK_BLK_SIZE * MaxFlashReadSize);
+	uint32 sec;
 
-	//  RkPrintf("Enter >> src_addr=0x%08X, dest_addr=0x%08X, total_sec=%d\n", src_addr, dest_addr, total_sec);
+	while(total_sec > 0)
+	{
+		sec = (total_sec > MaxFlashReadSize) ? MaxFlashReadSize : total_sec;
+		if(StorageReadLba(LBA, (uint8*)buf, sec) != 0) {
+			return -1;
+		}
+		memcpy(pSdram, buf, RK_BLK_SIZE * sec);
+		total_sec -= sec;
+		LBA += sec;
+		pSdram += sec * RK_BLK_SIZE;
+	}
+
+	return 0;
+}
 
-	//  RkPrintf("(0x%X->0x%X)  size: %d\n", src_addr, dest_addr, total_sec);
+static int32 rkloader_ReadDirect(uint32 LBA, uint8 *pSdram, uint32 total_sec)
+{
+	uint32 sec;
 
-	while(remain_sec > 0)
+	while(total_sec > 0)
 	{
-		sec = (remain_sec > MaxFlashReadSize) ? MaxFlashReadSize : remain_sec;
-		if(StorageReadLba(LBA,(uint8*)pSdram, sec) != 0)
-		{
+		sec = (total_sec > MaxFlashXferSize) ? MaxFlashXferSize : total_sec;
+		if(StorageReadLba(LBA, pSdram, sec) != 0) {
 			return -1;
 		}
-		remain_sec -= sec;
+		total_sec -= sec;
 		LBA += sec;
-		pSdram += sec*512;
+		pSdram += sec * RK_BLK_SIZE;
 	}
 
-	//  RkPrintf("Leave\n");
 	return 0;
 }
-#else
-#define MaxFlashReadSize  128  //64KB
+
 int32 rkloader_CopyFlash2Memory(uint32 dest_addr, uint32 src_addr, uint32 total_sec)
 {
-	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, RK_BLK_SIZE * MaxFlashReadSize);
 	uint8 * pSdram = (uint8 *)(unsigned long)dest_addr;
-	uint16 sec = 0;
-	uint32 LBA = src_addr;
-	uint32 remain_sec = total_sec;
+	uint32 last;
+
+	if(dest_addr & 0x3)
+		return rkloader_ReadBounce(src_addr, pSdram, total_sec);
+	if(!(dest_addr & (ARCH_DMA_MINALIGN - 1)))
+		return rkloader_ReadDirect(src_addr, pSdram, total_sec);
+	if(total_sec <= 2)
+		return rkloader_ReadBounce(src_addr, pSdram, total_sec);
+
+	//the middle first, the head and tail sectors land after its dma
+	last = total_sec - 1;
+	if(rkloader_ReadDirect(src_addr + 1, pSdram + RK_BLK_SIZE, total_sec - 2) != 0)
+		return -1;
+	if(rkloader_ReadBounce(src_addr, pSdram, 1) != 0)
+		return -1;
 
-	while(remain_sec > 0)
+	return rkloader_ReadBounce(src_addr + last, pSdram + last * RK_BLK_SIZE, 1);
+}
+
+static int rkloader_WriteBounce(uint32 LBA, uint8 *pSdram, uint32 total_sec)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, RK_BLK_SIZE * MaxFlashReadSize);
+	uint32 sec;
+
+	while(total_sec > 0)
 	{
-		sec = (remain_sec > MaxFlashReadSize) ? MaxFlashReadSize : remain_sec;
-		if(StorageReadLba(LBA, (uint8*)buf, sec) != 0) {
-			return -1;
+		sec = (total_sec > MaxFlashReadSize) ? MaxFlashReadSize : total_sec;
+		memcpy(buf, pSdram, RK_BLK_SIZE * sec);
+		if(StorageWriteLba(LBA, (uint8*)buf, sec, 0) != 0) {
+			return -2;
 		}
-		memcpy(pSdram, buf, RK_BLK_SIZE * sec);
-		remain_sec -= sec;
+		total_sec -= sec;
 		LBA += sec;
 		pSdram += sec * RK_BLK_SIZE;
 	}
 
 	return 0;
 }
-#endif
 
 int rkloader_CopyMemory2Flash(uint32 src_addr, uint32 dest_offset, int sectors)
 {
 	uint16 sec = 0;
 	uint32 remain_sec = sectors;
 
+	//the dma only cleans the lines it reads, any word aligned memory will do
+	if(src_addr & 0x3)
+		return rkloader_WriteBounce(dest_offset, (uint8 *)(unsigned long)src_addr, sectors);
+
 	while(remain_sec > 0)
 	{
-		sec = (remain_sec>32)?32:remain_sec;
+		sec = (remain_sec > MaxFlashXferSize) ? MaxFlashXferSize : remain_sec;
 
 		if(StorageWriteLba(dest_offset, (void *)(unsigned long)src_addr, sec, 0) != 0)
 		{
@@ -162,11 +203,15 @@ static int dispose_bootloader_cmd(struct bootloader_message *msg,
 
 		{// ܳɹ񣬽misc0
 			int i=0;
+			STORAGE_WRITE_T writes[3];
 			memset(g_32secbuf, 0, 32*528);
 			for(i=0; i<3; i++)
 			{
-				StorageWriteLba(misc_part->start+i*32, (void*)g_32secbuf,32, 0);
+				writes[i].LBA = misc_part->start+i*32;
+				writes[i].pbuf = (void*)g_32secbuf;
+				writes[i].nSec = 32;
 			}
+			StorageWriteLbaPacked(writes, 3);
 
 			if(reboot)
 			{
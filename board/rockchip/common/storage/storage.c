@@ -11,6 +11,7 @@
 #include <mmc.h>
 #include <part.h>
 #include <malloc.h>
+#include <fs.h>
 
 #include "../config.h"
 #include "storage.h"
@@ -82,6 +83,10 @@ static MEM_FUN_T emmcFunOp =
 	SdmmcGetCapacity,
 	SdmmcSysDataLoad,
 	SdmmcSysDataStore,
+	SdmmcBootWriteLBAPacked,
+	SdmmcSysDataStoreN,
+	SdmmcBootReadLBA_async,
+	SdmmcBootReadLBA_wait,
 };
 #endif
 
@@ -106,6 +111,8 @@ MEM_FUN_T sd0FunOp =
 	SdmmcGetCapacity,
 	SdmmcSysDataLoad,
 	SdmmcSysDataStore,
+	SdmmcBootWriteLBAPacked,
+	SdmmcSysDataStoreN,
 };
 #endif
 
@@ -154,11 +161,217 @@ static MEM_FUN_T *memFunTab[] =
 #define MAX_MEM_DEV	(sizeof(memFunTab)/sizeof(MEM_FUN_T *))
 
 
+/* bumped whenever media content may change, lets callers keep what they parsed */
+static uint32 gStorageWriteCount = 0;
+
+uint32 StorageGetWriteCount(void)
+{
+	return gStorageWriteCount;
+}
+
+static void StorageChanged(void)
+{
+	gStorageWriteCount++;
+	/* the mounted filesystems may sit on this media too */
+	fs_invalidate_mounts();
+}
+
+#ifdef CONFIG_RK_STORAGE_CACHE
+/*
+ * small lba reads (resource index, boot header probes, parameter, ...) are
+ * served from a lru cache of aligned sector lines. a miss right after the
+ * previous fill continues the run and fetches more lines in one read.
+ * lines are never dirty: writes, erases and media changes drop them.
+ */
+#define SCACHE_LINES		CONFIG_RK_STORAGE_CACHE_LINES
+#define SCACHE_LINE_SECS	CONFIG_RK_STORAGE_CACHE_LINE_SECS
+#define SCACHE_LINE_SIZE	(SCACHE_LINE_SECS * RK_BLK_SIZE)
+#define SCACHE_READAHEAD	CONFIG_RK_STORAGE_CACHE_READAHEAD
+
+typedef struct StorageCacheLineTag
+{
+	uint32 Line;		// LBA / SCACHE_LINE_SECS
+	uint32 Stamp;		// last use, 0 for an empty line
+	uint8 *Buf;
+} STORAGE_CACHE_LINE;
+
+typedef struct StorageCacheTag
+{
+	STORAGE_CACHE_LINE Lines[SCACHE_LINES];
+	uint8 *RaBuf;		// SCACHE_READAHEAD lines read in one go
+	uint32 Stamp;
+	uint32 NextLine;	// line following the last fill
+	uint32 RaLines;		// lines fetched by the last fill
+	MEM_FUN_T *pMem;	// media the lines were read from
+	uint32 Ready;
+} STORAGE_CACHE;
+
+static STORAGE_CACHE gStorageCache;
+
+static int StorageCacheSetup(void)
+{
+	STORAGE_CACHE *pCache = &gStorageCache;
+	uint8 *buf;
+	uint32 i;
+
+	if (pCache->Ready)
+		return 1;
+
+	buf = memalign(ARCH_DMA_MINALIGN, SCACHE_LINE_SIZE * (SCACHE_LINES + SCACHE_READAHEAD));
+	if (buf == NULL)
+		return 0;
+
+	memset(pCache, 0, sizeof(STORAGE_CACHE));
+	for (i = 0; i < SCACHE_LINES; i++)
+		pCache->Lines[i].Buf = buf + i * SCACHE_LINE_SIZE;
+	pCache->RaBuf = buf + SCACHE_LINES * SCACHE_LINE_SIZE;
+	pCache->Ready = 1;
+
+	return 1;
+}
+
+static void StorageCacheInvalidate(uint32 LBA, uint32 nSec)
+{
+	STORAGE_CACHE *pCache = &gStorageCache;
+	uint32 first = LBA / SCACHE_LINE_SECS;
+	uint32 last = (LBA + nSec - 1) / SCACHE_LINE_SECS;
+	uint32 i;
+
+	if (!pCache->Ready || nSec == 0)
+		return;
+
+	for (i = 0; i < SCACHE_LINES; i++)
+	{
+		if (pCache->Lines[i].Stamp && pCache->Lines[i].Line >= first && pCache->Lines[i].Line <= last)
+			pCache->Lines[i].Stamp = 0;
+	}
+	pCache->RaLines = 0;
+}
+
+static void StorageCacheInvalidateAll(void)
+{
+	StorageCacheInvalidate(0, ~0U);
+}
+
+static STORAGE_CACHE_LINE *StorageCacheLookup(uint32 line)
+{
+	STORAGE_CACHE *pCache = &gStorageCache;
+	uint32 i;
+
+	for (i = 0; i < SCACHE_LINES; i++)
+	{
+		if (pCache->Lines[i].Stamp && pCache->Lines[i].Line == line)
+		{
+			pCache->Lines[i].Stamp = ++pCache->Stamp;
+			return &pCache->Lines[i];
+		}
+	}
+
+	return NULL;
+}
+
+static STORAGE_CACHE_LINE *StorageCacheInstall(uint32 line, const uint8 *data)
+{
+	STORAGE_CACHE *pCache = &gStorageCache;
+	STORAGE_CACHE_LINE *pLine = NULL;
+	uint32 i;
+
+	for (i = 0; i < SCACHE_LINES; i++)
+	{
+		if (pCache->Lines[i].Stamp && pCache->Lines[i].Line == line)
+		{
+			pLine = &pCache->Lines[i];
+			break;
+		}
+		if (pLine == NULL || pCache->Lines[i].Stamp < pLine->Stamp)
+			pLine = &pCache->Lines[i];
+	}
+
+	memcpy(pLine->Buf, data, SCACHE_LINE_SIZE);
+	pLine->Line = line;
+	pLine->Stamp = ++pCache->Stamp;
+
+	return pLine;
+}
+
+static STORAGE_CACHE_LINE *StorageCacheFill(uint32 line)
+{
+	STORAGE_CACHE *pCache = &gStorageCache;
+	STORAGE_CACHE_LINE *pLine = NULL;
+	uint32 ra = 1;
+	uint32 i;
+
+	/* sequential misses double the read-ahead */
+	if (pCache->RaLines && line == pCache->NextLine)
+		ra = MIN(pCache->RaLines * 2, SCACHE_READAHEAD);
+
+	if (gpMemFun->ReadLba(gpMemFun->id, line * SCACHE_LINE_SECS, pCache->RaBuf, ra * SCACHE_LINE_SECS) != FTL_OK)
+	{
+		/* the read-ahead may run past the end of the media */
+		ra = 1;
+		if (gpMemFun->ReadLba(gpMemFun->id, line * SCACHE_LINE_SECS, pCache->RaBuf, SCACHE_LINE_SECS) != FTL_OK)
+		{
+			pCache->RaLines = 0;
+			return NULL;
+		}
+	}
+
+	/* install the requested line last so the read-ahead cannot evict it */
+	for (i = ra; i > 0; i--)
+		pLine = StorageCacheInstall(line + i - 1, pCache->RaBuf + (i - 1) * SCACHE_LINE_SIZE);
+
+	pCache->NextLine = line + ra;
+	pCache->RaLines = ra;
+
+	return pLine;
+}
+
+static int StorageCacheRead(uint32 LBA, void *pbuf, uint16 nSec)
+{
+	STORAGE_CACHE *pCache = &gStorageCache;
+	STORAGE_CACHE_LINE *pLine;
+	uint8 *dst = (uint8 *)pbuf;
+	uint32 off, n;
+
+	/* the lines are keyed by LBA only, drop them when the media changes */
+	if (pCache->pMem != gpMemFun)
+	{
+		StorageCacheInvalidateAll();
+		pCache->pMem = gpMemFun;
+	}
+
+	while (nSec)
+	{
+		off = LBA % SCACHE_LINE_SECS;
+		n = MIN(SCACHE_LINE_SECS - off, (uint32)nSec);
+
+		pLine = StorageCacheLookup(LBA / SCACHE_LINE_SECS);
+		if (pLine == NULL)
+			pLine = StorageCacheFill(LBA / SCACHE_LINE_SECS);
+		if (pLine == NULL)
+			return FTL_ERROR;
+
+		memcpy(dst, pLine->Buf + off * RK_BLK_SIZE, n * RK_BLK_SIZE);
+		dst += n * RK_BLK_SIZE;
+		LBA += n;
+		nSec -= n;
+	}
+
+	return FTL_OK;
+}
+#else
+#define StorageCacheInvalidate(LBA, nSec)
+#define StorageCacheInvalidateAll()
+#endif /* CONFIG_RK_STORAGE_CACHE */
+
+
 int32 StorageInit(void)
 {
 	uint32 memdev;
 
 	memset((uint8*)&g_FlashInfo, 0, sizeof(g_FlashInfo));
+	StorageCacheInvalidateAll();
+	StorageChanged();
 	for(memdev=0; memdev<MAX_MEM_DEV; memdev++)
 	{
 		gpMemFun = memFunTab[memdev];
@@ -179,6 +392,8 @@ int32 StorageInit(void)
 void FW_ReIntForUpdate(void)
 {
 	gpMemFun->Valid = 0;
+	StorageCacheInvalidateAll();
+	StorageChanged();
 	if(gpMemFun->IntForUpdate)
 	{
 		gpMemFun->IntForUpdate();
@@ -199,6 +414,8 @@ void FW_SorageLowFormat(void)
 		if(gpMemFun->LowFormat && !SecureBootLock)
 		{
 			gpMemFun->Valid = 0;
+			StorageCacheInvalidateAll();
+			StorageChanged();
 			gpMemFun->LowFormat();
 			gpMemFun->Valid = 1;
 		}
@@ -265,6 +482,8 @@ int StorageWritePba(uint32 PBA, void *pbuf, uint16 nSec)
 
 	if(gpMemFun->WritePba)
 	{
+		StorageCacheInvalidateAll();
+		StorageChanged();
 		ret = gpMemFun->WritePba(gpMemFun->id, PBA, pbuf, nSec);
 	}
 
@@ -277,24 +496,83 @@ int StorageReadLba(uint32 LBA, void *pbuf, uint16 nSec)
 
 	if(gpMemFun->ReadLba)
 	{
+#ifdef CONFIG_RK_STORAGE_CACHE
+		if (nSec < SCACHE_LINE_SECS && StorageCacheSetup())
+		{
+			return StorageCacheRead(LBA, pbuf, nSec);
+		}
+#endif
 		ret = gpMemFun->ReadLba(gpMemFun->id, LBA, pbuf, nSec);
 	}
 
 	return ret;
 }
 
+static int gStorageReadRet;	// the read StorageReadLbaAsync() did itself
+
+/*
+ * Start reading nSec sectors at LBA into pbuf, StorageReadLbaWait() gives the
+ * result once they are in. Media without background reads do it right here.
+ * One read at a time, no other storage call until its wait.
+ */
+int StorageReadLbaAsync(uint32 LBA, void *pbuf, uint16 nSec)
+{
+	if(gpMemFun->ReadLbaAsync)
+	{
+		return gpMemFun->ReadLbaAsync(gpMemFun->id, LBA, pbuf, nSec);
+	}
+
+	gStorageReadRet = StorageReadLba(LBA, pbuf, nSec);
+	return FTL_OK;
+}
+
+int StorageReadLbaWait(void)
+{
+	if(gpMemFun->ReadLbaWait)
+	{
+		return gpMemFun->ReadLbaWait(gpMemFun->id);
+	}
+
+	return gStorageReadRet;
+}
+
 int StorageWriteLba(uint32 LBA, void *pbuf, uint16 nSec, uint16 mode)
 {
 	int ret = FTL_ERROR;
 
 	if(gpMemFun->WriteLba)
 	{
+		StorageCacheInvalidate(LBA, nSec);
+		StorageChanged();
 		ret = gpMemFun->WriteLba(gpMemFun->id, LBA, pbuf, nSec, mode);
 	}
 
 	return ret;
 }
 
+/*
+ * the count writes of pWrite, in order. Media that can batch small writes
+ * (eMMC packed commands) get them in one go, the rest one by one.
+ */
+int StorageWriteLbaPacked(STORAGE_WRITE_T *pWrite, uint32 count)
+{
+	int ret = FTL_OK;
+	uint32 i;
+
+	if(gpMemFun->WriteLbaPacked)
+	{
+		for(i = 0; i < count; i++)
+			StorageCacheInvalidate(pWrite[i].LBA, pWrite[i].nSec);
+		StorageChanged();
+		return gpMemFun->WriteLbaPacked(gpMemFun->id, pWrite, count);
+	}
+
+	for(i = 0; i < count && ret == FTL_OK; i++)
+		ret = StorageWriteLba(pWrite[i].LBA, pWrite[i].pbuf, pWrite[i].nSec, 0);
+
+	return ret;
+}
+
 uint32 StorageGetCapacity(void)
 {
 	uint32 ret = FTL_ERROR;
@@ -333,7 +611,6 @@ uint32 StorageSysDataStore(uint32 Index, void *Buf)
 }
 
 
-#define UBOOT_SYS_DATA_OFFSET 64
 uint32 StorageUbootSysDataLoad(uint32 Index, void *Buf)
 {
 	return StorageSysDataLoad(Index + UBOOT_SYS_DATA_OFFSET, Buf);
@@ -370,8 +647,19 @@ uint32 StorageVendorSysDataStore(uint32 offset, uint32 len, uint32 *Buf)
 
 	for(i=0; i<len; i++)
 	{
-		Buf[0] = 0x444E4556;
-		Buf[1] = 504;
+		Buf[i * 128] = 0x444E4556;
+		Buf[i * 128 + 1] = 504;
+	}
+
+	/* the vendor sectors follow each other, store them in one write */
+	if(gpMemFun->SysDataStoreN)
+	{
+		gpMemFun->SysDataStoreN(gpMemFun->id, offset + 2, len, Buf);
+		return ret;
+	}
+
+	for(i=0; i<len; i++)
+	{
 		StorageSysDataStore(offset + 2 + i, Buf);
 		Buf += 128;
 	}
@@ -398,6 +686,8 @@ int StorageEraseBlock(uint32 blkIndex, uint32 nblk, uint8 mod)
 
 	if(gpMemFun->Erase && !SecureBootLock)
 	{
+		StorageCacheInvalidateAll();
+		StorageChanged();
 		Status = gpMemFun->Erase(0, blkIndex, nblk, mod);
 	}
 
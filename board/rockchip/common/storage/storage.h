@@ -34,6 +34,9 @@
 #define     SPARE_LEN           (32*8*2/4)               //Уݳ
 #define     PAGE_LEN            (DATA_LEN+SPARE_LEN)    //ÿݵλĳ
 
+/* u-boot's own sys data sectors start here: the env, then the emmc timing */
+#define     UBOOT_SYS_DATA_OFFSET   64
+
 
 extern  void    FW_ReIntForUpdate(void);
 extern  void	FW_SorageLowFormat(void);
@@ -42,8 +45,19 @@ extern  uint32	FW_StorageGetValid(void);
 extern  uint32	FW_GetCurEraseBlock(void);
 extern  uint32	FW_GetTotleBlk(void);
 
+/* one write of StorageWriteLbaPacked() */
+typedef struct STORAGE_WRITE_Tag
+{
+	uint32 LBA;
+	void *pbuf;
+	uint32 nSec;
+} STORAGE_WRITE_T;
+
 extern  int StorageWriteLba(uint32 LBA, void *pbuf, uint16 nSec, uint16 mode);
+extern  int StorageWriteLbaPacked(STORAGE_WRITE_T *pWrite, uint32 count);
 extern  int StorageReadLba(uint32 LBA, void *pbuf, uint16 nSec);
+extern  int StorageReadLbaAsync(uint32 LBA, void *pbuf, uint16 nSec);
+extern  int StorageReadLbaWait(void);
 extern  int StorageReadPba(uint32 PBA, void *pbuf, uint16 nSec);
 extern  int StorageWritePba(uint32 PBA, void *pbuf, uint16 nSec);
 extern  uint32 StorageGetCapacity(void);
@@ -60,6 +74,7 @@ extern  int StorageReadId(void *pbuf);
 extern  int32 StorageInit(void);
 extern  uint32 StorageVendorSysDataLoad(uint32 offset, uint32 len, uint32 *Buf);
 extern  uint32 StorageVendorSysDataStore(uint32 offset, uint32 len, uint32 *Buf);
+extern  uint32 StorageGetWriteCount(void);
 #ifdef RK_SDCARD_BOOT_EN
 extern  uint32 StorageSDCardUpdateMode(void);
 #endif
@@ -83,6 +98,10 @@ typedef uint32 (*Memory_GetTotleBlk)(void);
 typedef uint32 (*Memory_GetCapacity)(uint8 ChipSel);
 typedef uint32 (*Memory_SysDataLoad)(uint8 ChipSel, uint32 Index, void *Buf);
 typedef uint32 (*Memory_SysDataStore)(uint8 ChipSel, uint32 Index, void *Buf);
+typedef uint32 (*Memory_WriteLbaPacked)(uint8 ChipSel, STORAGE_WRITE_T *pWrite, uint32 count);
+typedef uint32 (*Memory_SysDataStoreN)(uint8 ChipSel, uint32 Index, uint32 nSec, void *Buf);
+typedef uint32 (*Memory_ReadLbaAsync)(uint8 ChipSel, uint32 LBA, void *pbuf, uint32 nSec);
+typedef uint32 (*Memory_ReadLbaWait)(uint8 ChipSel);
 
 typedef struct MEM_FUN_Tag
 {
@@ -104,6 +123,10 @@ typedef struct MEM_FUN_Tag
 	Memory_GetCapacity GetCapacity;
 	Memory_SysDataLoad SysDataLoad;
 	Memory_SysDataStore SysDataStore;
+	Memory_WriteLbaPacked WriteLbaPacked;	// NULL: one WriteLba each
+	Memory_SysDataStoreN SysDataStoreN;	// NULL: one SysDataStore each
+	Memory_ReadLbaAsync ReadLbaAsync;	// NULL: ReadLba, the caller waits in it
+	Memory_ReadLbaWait ReadLbaWait;
 } MEM_FUN_T, pMEM_FUN_T;
 
 
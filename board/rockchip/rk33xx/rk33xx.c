@@ -180,16 +180,21 @@ int board_late_init(void)
         RemotectlInit();
 #endif
 	debug("rkimage_prepare_fdt\n");
+	bootstage_start(BOOTSTAGE_ID_ACCUM_FDT, "fdt");
 	rkimage_prepare_fdt();
+	bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_FDT, gd->fdt_size);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_FDT);
 
 	debug("key_init\n");
 	key_init();
 
 #ifdef CONFIG_POWER_RK
+	bootstage_start(BOOTSTAGE_ID_ACCUM_PMIC, "pmic");
 	debug("pmic_init\n");
 	pmic_init(0);
 	debug("fg_init\n");
 	fg_init(0); /*fuel gauge init*/
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_PMIC);
 #endif
 
 	debug("idb init\n");
@@ -214,7 +219,9 @@ int board_late_init(void)
 	}
 
 	debug("fbt preboot\n");
+	bootstage_start(BOOTSTAGE_ID_ACCUM_PREBOOT, "preboot");
 	board_fbt_preboot();
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_PREBOOT);
 
 	return 0;
 }
@@ -27,6 +27,7 @@
 #include <command.h>
 #include <bootm.h>
 #include <image.h>
+#include <dma_memcpy.h>
 
 #ifndef CONFIG_SYS_BOOTM_LEN
 /* use 8MByte as default max gunzip size */
@@ -271,7 +272,8 @@ static int decomp_image(int comp, ulong load, ulong image_start, int type,
 			printf("   XIP %s ... ", type_name);
 		} else {
 			printf("   Loading %s ... ", type_name);
-			memmove_wd(load_buf, image_buf, image_len, CHUNKSZ);
+			/* lands by the dma_wait() in do_bootm_states() */
+			dma_memcpy_async(load_buf, image_buf, image_len);
 		}
 		*load_end = load + image_len;
 		break;
@@ -557,10 +559,14 @@ int do_bootm_states(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 
 		iflag = bootm_disable_interrupts();
 		ret = bootm_load_os(images, &load_end, 0);
-		if (ret == 0)
+		if (ret == 0) {
 			lmb_reserve(&images->lmb, images->os.load,
 				    (load_end - images->os.load));
-		else if (ret && ret != BOOTM_ERR_OVERLAP)
+			/* the copy reads the image until the dma_wait() below */
+			if (images->os.comp == IH_COMP_NONE)
+				lmb_reserve(&images->lmb, images->os.image_start,
+					    images->os.image_len);
+		} else if (ret && ret != BOOTM_ERR_OVERLAP)
 			goto err;
 		else if (ret == BOOTM_ERR_OVERLAP)
 			ret = 0;
@@ -591,6 +597,9 @@ int do_bootm_states(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	}
 #endif
 
+	/* kernel and ramdisk copies must have landed before the OS hooks */
+	dma_wait();
+
 	/* From now on, we need the OS boot function */
 	if (ret)
 		return ret;
@@ -8,11 +8,10 @@
 /*
  * This module records the progress of boot and arbitrary commands, and
  * permits accurate timestamping of each.
- *
- * TBD: Pass timings to kernel in the FDT
  */
 
 #include <common.h>
+#include <div64.h>
 #include <libfdt.h>
 #include <malloc.h>
 #include <linux/compiler.h>
@@ -25,13 +24,14 @@ struct bootstage_record {
 	const char *name;
 	int flags;		/* see enum bootstage_flags */
 	enum bootstage_id id;
+	ulong bytes;		/* moved by an accumulated activity */
 };
 
 static struct bootstage_record record[BOOTSTAGE_ID_COUNT] = { {1} };
 static int next_id = BOOTSTAGE_ID_USER;
 
 enum {
-	BOOTSTAGE_VERSION	= 0,
+	BOOTSTAGE_VERSION	= 1,
 	BOOTSTAGE_MAGIC		= 0xb00757a3,
 	BOOTSTAGE_DIGITS	= 9,
 };
@@ -137,6 +137,7 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name)
 
 	rec->start_us = timer_get_boot_us();
 	rec->name = name;
+	rec->id = id;
 	return rec->start_us;
 }
 
@@ -150,6 +151,19 @@ uint32_t bootstage_accum(enum bootstage_id id)
 	return duration;
 }
 
+void bootstage_add_bytes(enum bootstage_id id, ulong bytes)
+{
+	record[id].bytes += bytes;
+}
+
+/* throughput of an accumulated activity, in KiB/s */
+static ulong get_record_kbps(struct bootstage_record *rec)
+{
+	if (!rec->time_us)
+		return 0;
+	return lldiv(((uint64_t)rec->bytes * 1000000) >> 10, rec->time_us);
+}
+
 /**
  * Get a record name as a printable string
  *
@@ -183,11 +197,37 @@ static uint32_t print_time_record(enum bootstage_id id,
 		print_grouped_ull(rec->time_us, BOOTSTAGE_DIGITS);
 		print_grouped_ull(rec->time_us - prev, BOOTSTAGE_DIGITS);
 	}
-	printf("  %s\n", get_record_name(buf, sizeof(buf), rec));
+	printf("  %s", get_record_name(buf, sizeof(buf), rec));
+	if (rec->bytes)
+		printf(" (%lu KiB, %lu KiB/s)", rec->bytes >> 10,
+		       get_record_kbps(rec));
+	puts("\n");
 
 	return rec->time_us;
 }
 
+int bootstage_summary(char *buf, int size)
+{
+	struct bootstage_record *rec;
+	char name[20];
+	int len, id;
+
+	len = snprintf(buf, size, "total:%lu", timer_get_boot_us());
+	for (id = 0, rec = record; id < BOOTSTAGE_ID_COUNT && len < size;
+			id++, rec++) {
+		if (!rec->start_us)
+			continue;
+		len += snprintf(buf + len, size - len, ",%s:%u",
+				get_record_name(name, sizeof(name), rec),
+				(uint32_t)rec->time_us);
+		if (rec->bytes && len < size)
+			len += snprintf(buf + len, size - len, ":%lu:%lu",
+					rec->bytes, get_record_kbps(rec));
+	}
+
+	return len < size ? len : -1;
+}
+
 static int h_compare_record(const void *r1, const void *r2)
 {
 	const struct bootstage_record *rec1 = r1, *rec2 = r2;
@@ -250,9 +290,37 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 	return 0;
 }
 
+/**
+ * Add the bootstage summary to /chosen, as "u-boot,bootstage"
+ *
+ * @param blob	Device tree blob
+ * @return 0 on success, != 0 on failure.
+ */
+static int add_bootstage_chosen(void *blob)
+{
+	char buf[BOOTSTAGE_SUMMARY_LEN];
+	int node;
+
+	if (!blob)
+		return 0;
+
+	if (bootstage_summary(buf, sizeof(buf)) < 0)
+		return -1;
+
+	/* fdt_chosen() has normally made it by now */
+	node = fdt_path_offset(blob, "/chosen");
+	if (node == -FDT_ERR_NOTFOUND)
+		node = fdt_add_subnode(blob, 0, "chosen");
+	if (node < 0)
+		return -1;
+
+	return fdt_setprop_string(blob, node, "u-boot,bootstage", buf);
+}
+
 int bootstage_fdt_add_report(void)
 {
-	if (add_bootstages_devicetree(working_fdt))
+	if (add_bootstages_devicetree(working_fdt) ||
+	    add_bootstage_chosen(working_fdt))
 		puts("bootstage: Failed to add to device tree\n");
 
 	return 0;
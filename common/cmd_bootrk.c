@@ -10,8 +10,14 @@
 
 #include <fastboot.h>
 #include <malloc.h>
+#include <dma_memcpy.h>
+#include <rk_task.h>
+#include <rk_smp.h>
 #include <../board/rockchip/common/config.h>
 #include <generated/timestamp_autogenerated.h>
+#ifdef CONFIG_BOOTRK_KERNEL_UNZIP
+#include <u-boot/zlib.h>
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -39,6 +45,10 @@ extern bool is_rk81x_fg_init(void);
 extern int rkimage_load_image(rk_boot_img_hdr *hdr,
 		const disk_partition_t *boot_ptn, const disk_partition_t *kernel_ptn);
 
+#ifndef CONFIG_BOOTRK_LOAD_CHUNK_SIZE
+#define CONFIG_BOOTRK_LOAD_CHUNK_SIZE	SZ_2M
+#endif
+
 /* Section for Android bootimage format support
  * Refer:
  * http://android.git.kernel.org/?p=platform/system/core.git;a=blob;f=mkbootimg/bootimg.h
@@ -150,8 +160,13 @@ static rk_boot_img_hdr * rk_load_image_from_ram(char *ram_addr,
 	secaddr = (void *)(unsigned long)(raddr + ALIGN(hdr->ramdisk_size,
 				hdr->page_size));
 
-	memmove((void *)(unsigned long)hdr->kernel_addr, kaddr, hdr->kernel_size);
-	memmove((void *)(unsigned long)hdr->ramdisk_addr, raddr, hdr->ramdisk_size);
+	/* keep bootm's ramdisk and fdt allocations off where the moves land */
+	lmb_reserve(&pimage->lmb, hdr->kernel_addr, hdr->kernel_size);
+	lmb_reserve(&pimage->lmb, hdr->ramdisk_addr, hdr->ramdisk_size);
+
+	/* both moves run back to back on the dmac, the image check needs them */
+	dma_memcpy_async((void *)(unsigned long)hdr->kernel_addr, kaddr, hdr->kernel_size);
+	dma_memcpy_async((void *)(unsigned long)hdr->ramdisk_addr, raddr, hdr->ramdisk_size);
 
 	char* fastboot_unlocked_env = getenv(FASTBOOT_UNLOCKED_ENV_NAME);
 	unsigned long unlocked = 0;
@@ -162,6 +177,7 @@ static rk_boot_img_hdr * rk_load_image_from_ram(char *ram_addr,
 	}
 
 	/* check image */
+	dma_wait();
 	if (SecureBootImageCheck(hdr, unlocked) == false) {
 #ifdef CONFIG_SECUREBOOT_CRYPTO
 		if ((SecureMode != SBOOT_MODE_NS) && (SecureBootCheckOK == 0)) {
@@ -202,6 +218,216 @@ fail:
 }
 
 
+/*
+ * Read one of kernel/ramdisk/second in chunks. The storage reads a chunk in
+ * the background while the one before goes to the secure boot hash, so the
+ * image is hashed during the load.
+ */
+static int rk_load_image_section(unsigned long sector, void *addr,
+		uint32 size, unsigned long blksz, bool hash)
+{
+	unsigned long blocks = DIV_ROUND_UP(size, blksz);
+	unsigned long chunk;
+	void *prev = NULL;
+	uint32 len = 0;
+
+	bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_LOAD, size);
+	while (blocks) {
+		chunk = min(blocks, CONFIG_BOOTRK_LOAD_CHUNK_SIZE / blksz);
+		if (StorageReadLbaAsync(sector, addr, chunk) != 0)
+			return -1;
+		if (prev)
+			SecureModeBootImageHashUpdate(prev, len);
+		if (StorageReadLbaWait() != 0)
+			return -1;
+
+		if (hash) {
+			len = min(size, (uint32)(chunk * blksz));
+			size -= len;
+			prev = addr;
+		}
+
+		sector += chunk;
+		addr += chunk * blksz;
+		blocks -= chunk;
+	}
+
+	if (hash) {
+		if (prev)
+			SecureModeBootImageHashUpdate(prev, len);
+		SecureModeBootImageHashNext();
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_BOOTRK_KERNEL_UNZIP
+#define GZIP_HEAD_CRC		2
+#define GZIP_EXTRA_FIELD	4
+#define GZIP_ORIG_NAME		8
+#define GZIP_COMMENT		0x10
+#define GZIP_RESERVED		0xe0
+#define GZIP_DEFLATED		8
+
+/* length of the gzip header in front of the deflate stream, 0 if not gzip */
+static uint32 rk_gzip_header_len(const u8 *src, uint32 len)
+{
+	uint32 i = 10;
+
+	if (len < i || src[0] != 0x1f || src[1] != 0x8b
+			|| src[2] != GZIP_DEFLATED || (src[3] & GZIP_RESERVED))
+		return 0;
+
+	if (src[3] & GZIP_EXTRA_FIELD)
+		i = 12 + src[10] + (src[11] << 8);
+	if (src[3] & GZIP_ORIG_NAME)
+		while (i < len && src[i++] != 0)
+			;
+	if (src[3] & GZIP_COMMENT)
+		while (i < len && src[i++] != 0)
+			;
+	if (src[3] & GZIP_HEAD_CRC)
+		i += 2;
+
+	return i < len ? i : 0;
+}
+
+struct rk_unzip_job {
+	struct rk_smp_job job;
+	z_stream *s;
+	int r;
+};
+
+static void rk_unzip_run(void *arg)
+{
+	struct rk_unzip_job *uj = arg;
+
+	uj->r = inflate(uj->s, Z_NO_FLUSH);
+}
+
+static int rk_unzip_check(z_stream *s, int r)
+{
+	if (r != Z_OK && r != Z_STREAM_END) {
+		FBTERR("bootrk: inflate kernel failed(%d)\n", r);
+		return -1;
+	}
+	if (r == Z_OK && s->avail_out == 0) {
+		FBTERR("bootrk: kernel too large to inflate\n");
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Read a gzip kernel in chunks into the stage buffer and inflate every chunk
+ * to the kernel address right after it is read, while it is still in cache.
+ * The kernel is unpacked when the last chunk is read instead of after it.
+ *
+ * The stage holds two chunks: a secondary core inflates one while the next
+ * is read into the other. The first inflate stays here, it allocates the
+ * window.
+ */
+static int rk_unzip_image_section(unsigned long sector, void *addr,
+		uint32 addrlen, void *stage, uint32 size, unsigned long blksz,
+		bool hash)
+{
+	unsigned long blocks = DIV_ROUND_UP(size, blksz);
+	unsigned long chunk;
+	struct rk_unzip_job uj;
+	void *buf = stage;
+	uint32 len, skip = 0;
+	bool first = true;
+	z_stream s;
+
+	bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_LOAD, size);
+	memset(&s, 0, sizeof(s));
+	s.zalloc = gzalloc;
+	s.zfree = gzfree;
+	if (inflateInit2(&s, -MAX_WBITS) != Z_OK)
+		return -1;
+	s.next_out = addr;
+	s.avail_out = addrlen;
+
+	memset(&uj, 0, sizeof(uj));
+	uj.job.fn = rk_unzip_run;
+	uj.job.arg = &uj;
+	uj.s = &s;
+	uj.r = Z_OK;
+
+	while (blocks) {
+		chunk = min(blocks, CONFIG_BOOTRK_LOAD_CHUNK_SIZE / blksz);
+		if (StorageReadLba(sector, buf, chunk) != 0)
+			goto fail;
+
+		len = min(size, (uint32)(chunk * blksz));
+		if (hash)
+			SecureModeBootImageHashUpdate(buf, len);
+
+		if (first)
+			skip = rk_gzip_header_len(buf, len);
+
+		/* the previous chunk is inflated, its half of the stage is free */
+		rk_smp_wait(&uj.job);
+		if (rk_unzip_check(&s, uj.r) != 0)
+			goto fail;
+
+		/* data after the end of the stream is the gzip trailer */
+		if (uj.r != Z_STREAM_END) {
+			s.next_in = buf + skip;
+			s.avail_in = len - skip;
+			if (first)
+				rk_unzip_run(&uj);
+			else
+				rk_smp_submit(&uj.job);
+		}
+		first = false;
+		skip = 0;
+
+		buf = (buf == stage) ? stage + CONFIG_BOOTRK_LOAD_CHUNK_SIZE : stage;
+		size -= len;
+		sector += chunk;
+		blocks -= chunk;
+	}
+
+	rk_smp_wait(&uj.job);
+	if (rk_unzip_check(&s, uj.r) != 0)
+		goto fail;
+
+	if (hash)
+		SecureModeBootImageHashNext();
+
+	inflateEnd(&s);
+	if (uj.r != Z_STREAM_END) {
+		FBTERR("bootrk: kernel gzip stream truncated\n");
+		return -1;
+	}
+	printf("kernel inflated to 0x%08lx bytes\n", s.total_out);
+	return 0;
+
+fail:
+	rk_smp_wait(&uj.job);
+	inflateEnd(&s);
+	return -1;
+}
+
+/*
+ * Unpacking in place keeps the stored kernel_size in the header, the image
+ * digest is over the stored bytes, so only do it when that digest is streamed
+ * or no digest is checked at all.
+ */
+static bool rk_kernel_unzip(unsigned long sector, void *stage, bool hash)
+{
+#if defined(CONFIG_SECUREBOOT_CRYPTO) || defined(CONFIG_BOOTRK_OTA_IMAGE_CHECK)
+	if (!hash)
+		return false;
+#endif
+	if (StorageReadLba(sector, stage, 1) != 0)
+		return false;
+
+	return rk_gzip_header_len(stage, RK_BLK_SIZE) != 0;
+}
+#endif /* CONFIG_BOOTRK_KERNEL_UNZIP */
+
 static rk_boot_img_hdr * rk_load_image_from_storage(const disk_partition_t* ptn, bootm_headers_t *pimage)
 {
 	rk_boot_img_hdr *hdr = NULL;
@@ -209,6 +435,8 @@ static rk_boot_img_hdr * rk_load_image_from_storage(const disk_partition_t* ptn,
 	unsigned sector;
 	unsigned blocks;
 	void *kaddr, *raddr;
+	bool hash;
+	uint32 checked;
 #ifdef CONFIG_OF_LIBFDT
 	resource_content content;
 
@@ -229,6 +457,7 @@ static rk_boot_img_hdr * rk_load_image_from_storage(const disk_partition_t* ptn,
 		return NULL;
 	}
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_LOAD, "load");
 	if (StorageReadLba(ptn->start, (void *) hdr, 1 << 2) != 0) {
 		FBTERR("bootrk: failed to read bootimg header\n");
 		goto fail;
@@ -245,37 +474,60 @@ static rk_boot_img_hdr * rk_load_image_from_storage(const disk_partition_t* ptn,
 			FBTERR("bootrk: bad boot or kernel image\n");
 			goto fail;
 		}
+		bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_LOAD,
+				hdr->kernel_size + hdr->ramdisk_size);
 	} else {
 		hdr->kernel_addr = (uint32)(unsigned long)kaddr;
 		hdr->ramdisk_addr = (uint32)(unsigned long)raddr;
 
+		/* image sha is computed chunk by chunk while loading */
+		hash = SecureModeBootImageHashBegin(hdr);
+
 		sector = ptn->start + (hdr->page_size / blksz);
-		blocks = DIV_ROUND_UP(hdr->kernel_size, blksz);
-		if (StorageReadLba(sector, (void *)(unsigned long) hdr->kernel_addr, \
-					blocks) != 0) {
+#ifdef CONFIG_BOOTRK_KERNEL_UNZIP
+		/* ramdisk is read after the kernel, so its buffer stages the gzip chunks */
+		if ((raddr > kaddr) && rk_kernel_unzip(sector, raddr, hash)) {
+			if (rk_unzip_image_section(sector, kaddr, raddr - kaddr, raddr,
+						hdr->kernel_size, blksz, hash) != 0) {
+				FBTERR("bootrk: failed to unzip kernel\n");
+				goto fail;
+			}
+		} else
+#endif
+		if (rk_load_image_section(sector, (void *)(unsigned long) hdr->kernel_addr, \
+					hdr->kernel_size, blksz, hash) != 0) {
 			FBTERR("bootrk: failed to read kernel\n");
 			goto fail;
 		}
 
 		sector += ALIGN(hdr->kernel_size, hdr->page_size) / blksz;
 		blocks = DIV_ROUND_UP(hdr->ramdisk_size, blksz);
-		if (StorageReadLba(sector, (void *)(unsigned long) hdr->ramdisk_addr, \
-					blocks) != 0) {
+		if (rk_load_image_section(sector, (void *)(unsigned long) hdr->ramdisk_addr, \
+					hdr->ramdisk_size, blksz, hash) != 0) {
 			FBTERR("bootrk: failed to read ramdisk\n");
 			goto fail;
 		}
 #ifdef CONFIG_SECUREBOOT_CRYPTO
 		if (hdr->second_size != 0) {
+#else
+		/* without crypto second is only read to complete the image sha */
+		if (hash && (hdr->second_size != 0)) {
+#endif
 			hdr->second_addr = hdr->ramdisk_addr + blksz * blocks;
 
 			sector += ALIGN(hdr->ramdisk_size, hdr->page_size) / blksz;
-			blocks = DIV_ROUND_UP(hdr->second_size, blksz);
-			if (StorageReadLba(sector, (void *)(unsigned long) hdr->second_addr, \
-						blocks) != 0) {
+			if (rk_load_image_section(sector, (void *)(unsigned long) hdr->second_addr, \
+						hdr->second_size, blksz, hash) != 0) {
 				FBTERR("bootrk: failed to read second\n");
 				goto fail;
 			}
+		} else if (hash) {
+			SecureModeBootImageHashNext();
+		}
+		SecureModeBootImageHashEnd();
 
+#ifdef CONFIG_SECUREBOOT_CRYPTO
+		if (hdr->second_size != 0) {
 			/* load fdt from boot image sencode address */
 			#ifdef CONFIG_OF_LIBFDT
 			debug("Try to load fdt from second address.\n");
@@ -307,8 +559,13 @@ static rk_boot_img_hdr * rk_load_image_from_storage(const disk_partition_t* ptn,
 		}
 	}
 
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_LOAD);
+
 	/* check image */
-	if (SecureBootImageCheck(hdr, unlocked) == false) {
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SECURE_CHECK, "secure_check");
+	checked = SecureBootImageCheck(hdr, unlocked);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SECURE_CHECK);
+	if (checked == false) {
 #ifdef CONFIG_SECUREBOOT_CRYPTO
 		if ((SecureMode != SBOOT_MODE_NS) && (SecureBootCheckOK == 0)) {
 			puts("Not allow to boot no secure sign image!\n");
@@ -354,6 +611,7 @@ static int rk_load_kernel_logo(void)
 	resource_content content;
 	int blocks;
 	int offset = CONFIG_RK_FB_SIZE;
+	void *packed;
 
 	debug("loader kernel logo from resource.\n");
 	g_rk_fb_size = -1;
@@ -372,11 +630,25 @@ static int rk_load_kernel_logo(void)
 		       content.content_size);
 		return -1;
 	}
-	if (!load_content_data(&content, 0, content.load_addr, blocks)) {
+	if (!load_content_data(&content, 0, content.load_addr, 1)) {
+		return -1;
+	}
+
+	if (is_content_packed(content.load_addr)) {
+		/* the kernel wants a plain bmp: load at the end, unpack here */
+		packed = content.load_addr + CONFIG_RK_LCD_SIZE - offset
+			- blocks * BLOCK_SIZE;
+		if (!load_content_data(&content, 0, packed, blocks) ||
+		    !unpack_content(packed, content.content_size,
+				    content.load_addr,
+				    CONFIG_RK_LCD_SIZE - offset - blocks * BLOCK_SIZE))
+			return -1;
+	} else if (!load_content_data(&content, 0, content.load_addr, blocks)) {
 		return -1;
 	}
 
 	g_rk_fb_size = CONFIG_RK_FB_SIZE;
+	bootstage_add_bytes(BOOTSTAGE_ID_ACCUM_LOGO, content.content_size);
 
 	return offset;
 }
@@ -463,6 +735,13 @@ static void rk_commandline_setenv(const char *boot_name, rk_boot_img_hdr *hdr, b
 	snprintf(command_line, sizeof(command_line),
 			"%s loader.timestamp=%s", command_line, U_BOOT_TIMESTAMP);
 
+	/* boot time so far, /chosen/u-boot,bootstage has it up to the handoff */
+	char bootstage[BOOTSTAGE_SUMMARY_LEN];
+	if (bootstage_summary(bootstage, sizeof(bootstage)) > 0) {
+		snprintf(command_line, sizeof(command_line),
+				"%s loader.bootstage=%s", command_line, bootstage);
+	}
+
 #if defined(CONFIG_RK_HDMI)
 	snprintf(command_line, sizeof(command_line),
 			 "%s hdmi.vic=%d", command_line, g_hdmi_vic);
@@ -535,7 +814,9 @@ int do_bootrk(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		}
 	}
 #if defined(CONFIG_LCD) && defined(CONFIG_KERNEL_LOGO)
+	bootstage_start(BOOTSTAGE_ID_ACCUM_LOGO, "logo");
 	rk_load_kernel_logo();
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_LOGO);
 #endif
 
 #if defined(CONFIG_UBOOT_CHARGE) && defined(CONFIG_POWER_FG_ADC)
@@ -549,6 +830,8 @@ int do_bootrk(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	rk_commandline_setenv(boot_source, hdr, charge);
 
+	/* deferred init must be over before the modules go down */
+	rk_task_wait_all();
 	rk_module_deinit();
 
 	/* Secure boot state will set drm, sn and others information in the nanc ram,
@@ -35,6 +35,8 @@
 #include <power/pmic.h>
 #include <resource.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /*#define DEBUG*/
 #define LOGE(fmt, args...) printf(fmt "\n", ##args)
 #ifdef DEBUG
@@ -457,20 +459,10 @@ void test_anim_desc(void) {
 static int current_conf = 0;
 static int current_index = 0;
 
-static bool show_image(void) {
-	if (!level_confs
-			|| current_conf >= level_conf_num || current_conf < 0
-			|| current_index >= level_confs[current_conf].num
-			|| current_index < 0) {
-		LOGE("Inval params!");
-		return false;
-	}
-
-	//generate image path.
-	anim_level_conf* conf = level_confs + current_conf;
-	char path[MAX_INDEX_ENTRY_PATH_LEN];
+static void get_image_path(const anim_level_conf* conf, int index,
+		char* path, size_t len) {
 	if (conf->num == 1) {
-		snprintf(path, sizeof(path), "%s.bmp",
+		snprintf(path, len, "%s.bmp",
 				conf->prefix);
 	} else {
 		int num = conf->num;
@@ -481,12 +473,167 @@ static bool show_image(void) {
 		}
 		char buf[30];
 		snprintf(buf, sizeof(buf), "%%s%%0%dd.bmp", n);
-		snprintf(path, sizeof(path), buf,
-				conf->prefix, current_index);
+		snprintf(path, len, buf,
+				conf->prefix, index);
+	}
+}
+
+#ifdef CONFIG_CHARGE_FRAME_CACHE
+/*
+ * Frames of a level are read in one pass, decoded once into lcdc format
+ * and shown by moving the window base, so a tick touches neither the
+ * storage nor the pixels. The decoded frames sit in the kernel logo half
+ * of the lcd memory, which is unused until bootrk loads the logo; when
+ * it is full, the cache starts over. A cached frame on screen is never
+ * written: with one up, a level that does not fit is shown uncached
+ * once and the cache only starts over on the next tick, so there is no
+ * tearing and no need to flip.
+ */
+#define FRAME_CACHE_ALIGN		SZ_4K
+
+static struct fb_dsp_info** frame_cache = NULL;	/* per level conf */
+static ulong frame_cache_next = 0;
+static bool* frame_cache_failed = NULL;	/* per level conf, don't retry */
+static bool frame_cache_on_screen = false;	/* lcdc scans out of the cache */
+
+static inline ulong frame_cache_start(void) {
+	return gd->fb_base + CONFIG_RK_FB_SIZE;
+}
+
+static inline ulong frame_cache_end(void) {
+	return gd->fb_base + CONFIG_RK_LCD_SIZE;
+}
+
+static void frame_cache_reset(void) {
+	int i;
+
+	if (frame_cache) {
+		for (i = 0; i < level_conf_num; i++)
+			free(frame_cache[i]);
+		free(frame_cache);
+		frame_cache = NULL;
+	}
+	frame_cache_next = frame_cache_start();
+}
+
+//drop the cache and the failed loads, a new charge run tries them again.
+static void frame_cache_release(void) {
+	frame_cache_reset();
+	free(frame_cache_failed);
+	frame_cache_failed = NULL;
+	frame_cache_on_screen = false;
+}
+
+static bool frame_cache_load(int conf_idx) {
+	anim_level_conf* conf = level_confs + conf_idx;
+	resource_content* contents = NULL;
+	struct fb_dsp_info* frames = NULL;
+	ulong next = frame_cache_next;
+	//files load to the upper half of the boot buffer, unpack to the lower.
+	void* buf = (void *)gd->arch.rk_boot_buf_addr;
+	size_t half = CONFIG_RK_BOOT_BUFFER_SIZE / 2;
+	void* bmp;
+	bool ret = false;
+	int i, size;
+
+	if (!frame_cache) {
+		frame_cache = calloc(level_conf_num, sizeof(*frame_cache));
+		if (!frame_cache)
+			return false;
+	}
+
+	contents = calloc(conf->num, sizeof(*contents));
+	frames = calloc(conf->num, sizeof(*frames));
+	if (!contents || !frames)
+		goto end;
+
+	for (i = 0; i < conf->num; i++)
+		get_image_path(conf, i, contents[i].path,
+				sizeof(contents[i].path));
+	if (!load_contents(0, contents, conf->num, buf + half, half))
+		goto end;
+
+	for (i = 0; i < conf->num; i++) {
+		bmp = unpack_content(contents[i].load_addr,
+				contents[i].content_size, buf, half);
+		if (!bmp)
+			goto end;
+		size = lcd_decode_frame((ulong)bmp,
+				(void *)next, frame_cache_end() - next,
+				&frames[i]);
+		if (size < 0) {
+			LOGE("Failed to cache frame:%s", contents[i].path);
+			goto end;
+		}
+		next = ALIGN(next + size, FRAME_CACHE_ALIGN);
+	}
+
+	LOGD("cached %d frames of level %d", conf->num, conf_idx);
+	frame_cache[conf_idx] = frames;
+	frame_cache_next = next;
+	frames = NULL;
+	ret = true;
+end:
+	free(frames);
+	free(contents);
+	return ret;
+}
+
+static bool show_cached_frame(void) {
+	if (frame_cache_failed && frame_cache_failed[current_conf])
+		return false;
+
+	if (!frame_cache || !frame_cache[current_conf]) {
+		if (!frame_cache_load(current_conf)) {
+			//out of space? not over the frame on screen, show this one uncached.
+			if (frame_cache_on_screen)
+				return false;
+			//start over with this level only.
+			frame_cache_reset();
+			if (!frame_cache_load(current_conf)) {
+				//missing or corrupt: don't read it all again every tick.
+				if (!frame_cache_failed)
+					frame_cache_failed = calloc(level_conf_num,
+							sizeof(*frame_cache_failed));
+				if (frame_cache_failed)
+					frame_cache_failed[current_conf] = true;
+				return false;
+			}
+		}
+	}
+
+	lcd_show_frame(&frame_cache[current_conf][current_index]);
+	frame_cache_on_screen = true;
+	return true;
+}
+#endif /* CONFIG_CHARGE_FRAME_CACHE */
+
+static bool show_image(void) {
+	if (!level_confs
+			|| current_conf >= level_conf_num || current_conf < 0
+			|| current_index >= level_confs[current_conf].num
+			|| current_index < 0) {
+		LOGE("Inval params!");
+		return false;
 	}
 
+#ifdef CONFIG_CHARGE_FRAME_CACHE
+	if (show_cached_frame())
+		return true;
+#endif
+
+	//generate image path.
+	anim_level_conf* conf = level_confs + current_conf;
+	char path[MAX_INDEX_ENTRY_PATH_LEN];
+	get_image_path(conf, current_index, path, sizeof(path));
+
 	LOGD("show image:%s", path);
-	return show_resource_image(path);
+	if (!show_resource_image(path))
+		return false;
+#ifdef CONFIG_CHARGE_FRAME_CACHE
+	frame_cache_on_screen = false;
+#endif
+	return true;
 }
 
 static inline int get_index_for_level(int level) {
@@ -596,6 +743,9 @@ int do_charge(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	/* enbale fb buffer flip */
 	lcd_enable_flip(true);
+#ifdef CONFIG_CHARGE_FRAME_CACHE
+	frame_cache_release();
+#endif
 
 	while (1) {
 		//step 1: check charger state.
@@ -689,6 +839,9 @@ int do_charge(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 exit:
 	/* disable fb buffer flip */
 	lcd_enable_flip(false);
+#ifdef CONFIG_CHARGE_FRAME_CACHE
+	frame_cache_release();
+#endif
 	set_brightness(SCREEN_OFF, &g_state);
 	if (exit_type == EXIT_BOOT) {
 		#ifdef CONFIG_POWER_FG_ADC
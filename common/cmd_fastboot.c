@@ -770,17 +770,22 @@ static const char *getvar_checksum(const char *args)
 	//1:parse params.
 	uint32_t offset = 0;
 	uint32_t blocks = 0;
+	unsigned long long offset_arg, blocks_arg;
 	const char* buf = args + sizeof("checksum:") - 1;
-	offset = simple_strtoull(buf, (char**)(&buf), 0);
+	offset_arg = simple_strtoull(buf, (char**)(&buf), 0);
 	//skip a space char.
 	buf++;
-	blocks = simple_strtoull(buf, (char**)(&buf), 0);
+	blocks_arg = simple_strtoull(buf, (char**)(&buf), 0);
 
-	if (offset < 0 || blocks <= 0) {
+	//the range has to be in the 32 bit lba space.
+	if (blocks_arg == 0 || offset_arg > 0xFFFFFFFFULL
+			|| blocks_arg > 0xFFFFFFFFULL - offset_arg) {
 		snprintf(priv.response, sizeof(priv.response),
 				"FAILinvalidate params!\n");
 		return NULL;
 	}
+	offset = offset_arg;
+	blocks = blocks_arg;
 	FBTDBG("try to get checksum, offset:0x%08x, blocks:0x%08x\n",
 			offset, blocks);
 
@@ -845,6 +850,85 @@ static const char *getvar_checksum(const char *args)
 #endif
 }
 
+#ifdef SECUREBOOT_CRYPTO_EN
+/*
+ * sha1 of a storage range on the crypto engine. Reads go to the two transfer
+ * buffers in turn, the engine hashes one while the next one is read.
+ */
+static const char *getvar_sha1(const char *args)
+{
+	uint32_t offset = 0;
+	uint32_t blocks = 0;
+	unsigned long long offset_arg, blocks_arg;
+	const char* buf = args + sizeof("sha1:") - 1;
+	uint16_t buf_blocks;
+	CRYPTO_HASH_JOB job;
+	uint32_t digest[8];
+	int cur = 0, i;
+
+	offset_arg = simple_strtoull(buf, (char**)(&buf), 0);
+	//skip a space char.
+	buf++;
+	blocks_arg = simple_strtoull(buf, (char**)(&buf), 0);
+
+	//in the 32 bit lba space, and the engine takes a 32 bit byte count.
+	if (blocks_arg == 0 || offset_arg > 0xFFFFFFFFULL
+			|| blocks_arg > 0xFFFFFFFFULL - offset_arg
+			|| blocks_arg > 0xFFFFFFFFULL / RK_BLK_SIZE) {
+		snprintf(priv.response, sizeof(priv.response),
+				"FAILinvalidate params!\n");
+		return NULL;
+	}
+	offset = offset_arg;
+	blocks = blocks_arg;
+	FBTDBG("try to get sha1, offset:0x%08x, blocks:0x%08x\n",
+			offset, blocks);
+
+	if (CryptoHashJobStart(&job, blocks * RK_BLK_SIZE, 160) != OK) {
+		snprintf(priv.response, sizeof(priv.response),
+				"FAILcrypto busy!\n");
+		return NULL;
+	}
+
+	buf_blocks = min(CONFIG_FASTBOOT_TRANSFER_BUFFER_SIZE_EACH / RK_BLK_SIZE,
+			0xFFFF);
+	while (blocks > 0) {
+		uint16_t read_blocks = blocks > buf_blocks? buf_blocks : blocks;
+
+		//the engine may still read this buffer for the chunk before last.
+		while (CryptoHashJobPending(&job) > 1)
+			;
+
+		if (StorageReadLba(offset, priv.buffer[cur], read_blocks) != 0) {
+			FBTERR("read failed, offset:0x%08x, blocks:0x%08x\n",
+					offset, read_blocks);
+			CryptoHashJobAbort(&job);
+			snprintf(priv.response, sizeof(priv.response),
+					"FAILread 0x%08x failed!\n", offset);
+			return NULL;
+		}
+		CryptoHashJobSubmit(&job, priv.buffer[cur],
+				read_blocks * RK_BLK_SIZE);
+
+		offset += read_blocks;
+		blocks -= read_blocks;
+		cur ^= 1;
+	}
+
+	if (CryptoHashJobEnd(&job, digest) != OK) {
+		snprintf(priv.response, sizeof(priv.response),
+				"FAILcrypto error!\n");
+		return NULL;
+	}
+
+	strcpy(priv.response, "OKAY");
+	for (i = 0; i < SHA_DIGEST_SIZE; i++)
+		sprintf(priv.response + 4 + i * 2, "%02x",
+				((uint8_t *)digest)[i]);
+	return NULL;
+}
+#endif /* SECUREBOOT_CRYPTO_EN */
+
 static const char *getvar_partition_offset(const char *args)
 {
 	const char *partition_name;
@@ -891,7 +975,10 @@ static const struct getvar_entry getvar_table[] = {
 	{"partition-type:", 0, getvar_partition_type},
 	{"partition-size:", 0, getvar_partition_size},
 	{"partition-offset:", 0, getvar_partition_offset},
-	{"checksum:", 0, getvar_checksum}
+	{"checksum:", 0, getvar_checksum},
+#ifdef SECUREBOOT_CRYPTO_EN
+	{"sha1:", 0, getvar_sha1},
+#endif
 };
 
 static void fbt_handle_getvar(char *cmdbuf)
@@ -1250,6 +1337,26 @@ static void fbt_handle_boot(const char *cmdbuf)
 	sprintf(priv.response, "FAILinvalid boot image");
 }
 
+/*
+ * Accelerated download receives into a ring spanning the whole transfer
+ * buffer, each transfer lands right behind the previous one, so data the
+ * board has not written to storage yet stays where it is. The first
+ * FBT_RING_HEADROOM bytes are kept free for the board to move a partial
+ * block in front of the new data when the ring wraps.
+ */
+#define FBT_RING_HEADROOM	RK_BLK_SIZE
+
+static u8 *fbt_ring_next(u8 *cur, int length)
+{
+	u8 *next = cur + length;
+
+	if (((unsigned long)next & (ARCH_DMA_MINALIGN - 1)) ||
+			next + priv.transfer_buffer_size >
+			priv.buffer[0] + CONFIG_FASTBOOT_TRANSFER_BUFFER_SIZE)
+		next = priv.buffer[0] + FBT_RING_HEADROOM;
+	return next;
+}
+
 /* XXX: Replace magic number & strings with macros */
 static int fbt_rx_process(unsigned char *buffer, int length)
 {
@@ -1274,7 +1381,7 @@ static int fbt_rx_process(unsigned char *buffer, int length)
 			if(priv.d_legacy)
 				ep->rcv_urb->buffer += priv.transfer_buffer_size;
 			else
-				ep->rcv_urb->buffer = (u8 *)priv.buffer[buffer == priv.transfer_buffer];
+				ep->rcv_urb->buffer = fbt_ring_next(data_buffer, length);
 			resume_usb(ep, 0);
 			FBTDBG("buffer %p, len %x..\n", ep->rcv_urb->buffer, length);
 		}
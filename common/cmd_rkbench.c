@@ -0,0 +1,388 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#include <common.h>
+#include <command.h>
+#include <watchdog.h>
+#include <linux/sizes.h>
+#include <asm/system.h>
+#include <rk_smp.h>
+#include <../board/rockchip/common/config.h>
+#ifdef CONFIG_SHA_HW_ACCEL
+#include <hw_sha.h>
+#endif
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/*
+ * rkbench: throughput of the boot path hot loops under each dcache mode.
+ * Buffers are carved out of the boot buffer: source, destination and the
+ * gzip stream, RKBENCH_SIZE each.
+ */
+#define RKBENCH_SIZE		SZ_8M
+#define RKBENCH_LOOPS		4
+
+enum rkbench_dcache {
+	RKBENCH_DCACHE_OFF,
+	RKBENCH_DCACHE_WT,
+	RKBENCH_DCACHE_WB,
+};
+
+static const char * const rkbench_dcache_name[] = {
+	[RKBENCH_DCACHE_OFF]	= "off",
+	[RKBENCH_DCACHE_WT]	= "write-through",
+	[RKBENCH_DCACHE_WB]	= "write-back",
+};
+
+static const enum rkbench_dcache rkbench_modes[] = {
+	RKBENCH_DCACHE_OFF,
+#ifndef CONFIG_ARM64
+	/* armv8 maps dram with a fixed write-back attribute */
+	RKBENCH_DCACHE_WT,
+#endif
+	RKBENCH_DCACHE_WB,
+};
+
+static unsigned long rkbench_gz_len;
+
+static void rkbench_set_dcache(enum rkbench_dcache mode)
+{
+	if (mode == RKBENCH_DCACHE_OFF) {
+		dcache_disable();
+		return;
+	}
+
+	if (!dcache_status())
+		dcache_enable();
+#ifndef CONFIG_ARM64
+	{
+		int i;
+
+		/*
+		 * dirty lines must reach memory before the attribute changes,
+		 * and dram stays shareable for the boot workers.
+		 */
+		flush_dcache_all();
+		for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++)
+			mmu_set_region_dcache_behaviour(gd->bd->bi_dram[i].start,
+					gd->bd->bi_dram[i].size,
+					(mode == RKBENCH_DCACHE_WT ?
+					DCACHE_WRITETHROUGH : DCACHE_WRITEBACK) | RK_SMP_SECT_SHARED);
+	}
+#endif
+}
+
+static enum rkbench_dcache rkbench_get_dcache(void)
+{
+	if (!dcache_status())
+		return RKBENCH_DCACHE_OFF;
+#if defined(CONFIG_SYS_ARM_CACHE_WRITETHROUGH) && !defined(CONFIG_ARM64)
+	return RKBENCH_DCACHE_WT;
+#else
+	return RKBENCH_DCACHE_WB;
+#endif
+}
+
+static ulong rkbench_memcpy(void *dst, void *src)
+{
+	memcpy(dst, src, RKBENCH_SIZE);
+	return RKBENCH_SIZE;
+}
+
+#ifdef CONFIG_GZIP
+static ulong rkbench_inflate(void *dst, void *src)
+{
+	unsigned long len = rkbench_gz_len;
+
+	if (gunzip(dst, RKBENCH_SIZE, (unsigned char *)src + 2 * RKBENCH_SIZE,
+				&len) != 0)
+		return 0;
+	return len;
+}
+#endif
+
+static ulong rkbench_sha1(void *dst, void *src)
+{
+	SHA_CTX ctx;
+
+	SHA_init(&ctx);
+	SHA_update(&ctx, src, RKBENCH_SIZE);
+	SHA_final(&ctx);
+	return RKBENCH_SIZE;
+}
+
+#ifdef CONFIG_SHA_HW_ACCEL
+static ulong rkbench_hw_sha1(void *dst, void *src)
+{
+	hw_sha1(src, RKBENCH_SIZE, dst, SZ_1M);
+	return RKBENCH_SIZE;
+}
+#endif
+
+static const struct {
+	const char *name;
+	ulong (*run)(void *dst, void *src);
+} rkbench_tests[] = {
+	{ "memcpy",	rkbench_memcpy },
+#ifdef CONFIG_GZIP
+	{ "inflate",	rkbench_inflate },
+#endif
+	{ "sha1",	rkbench_sha1 },
+#ifdef CONFIG_SHA_HW_ACCEL
+	{ "sha1 hw",	rkbench_hw_sha1 },
+#endif
+};
+
+/* MB/s of the best of RKBENCH_LOOPS runs, 0 when the test failed */
+static ulong rkbench_run(ulong (*run)(void *dst, void *src), void *dst, void *src)
+{
+	ulong best = 0;
+	ulong start, ms, bytes;
+	int i;
+
+	for (i = 0; i < RKBENCH_LOOPS; i++) {
+		start = get_timer(0);
+		bytes = run(dst, src);
+		ms = get_timer(start);
+		WATCHDOG_RESET();
+		if (bytes == 0)
+			return 0;
+
+		if (ms == 0)
+			ms = 1;
+		best = max(best, (bytes >> 10) * 1000 / ms >> 10);
+	}
+
+	return best;
+}
+
+/*
+ * String routines: every src/dst alignment pair over a set of lengths, each
+ * byte checked against a pattern computed without the routine under test.
+ */
+#define RKBENCH_PAT(i, seed)	((u8)((i) * 31 + (seed)))
+#define RKBENCH_CHECK_WIN(n)	((n) + 48)	/* room for offsets and guard bytes */
+
+static const ulong rkbench_check_lens[] = {
+	0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65,
+	95, 127, 128, 129, 255, 256, 257, 1023, 4099, SZ_64K + 5,
+};
+
+static void rkbench_pat_fill(u8 *buf, ulong len, u8 seed)
+{
+	ulong i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = RKBENCH_PAT(i, seed);
+}
+
+/* 0 when the check window is the seed pattern with [off, off + n) replaced */
+static int rkbench_pat_check(const u8 *buf, u8 seed, ulong off, ulong n,
+		int (*inside)(ulong i, void *arg), void *arg)
+{
+	ulong i;
+
+	for (i = 0; i < RKBENCH_CHECK_WIN(n); i++) {
+		int v = (i >= off && i < off + n) ? inside(i - off, arg) :
+				RKBENCH_PAT(i, seed);
+
+		if (buf[i] != (u8)v)
+			return -1;
+	}
+
+	return 0;
+}
+
+struct rkbench_copy_ref {
+	ulong src;
+	u8 seed;
+};
+
+static int rkbench_copy_byte(ulong i, void *arg)
+{
+	struct rkbench_copy_ref *ref = arg;
+
+	return RKBENCH_PAT(ref->src + i, ref->seed);
+}
+
+static int rkbench_set_byte(ulong i, void *arg)
+{
+	return *(u8 *)arg;
+}
+
+static int rkbench_string_check(u8 *a, u8 *b)
+{
+	struct rkbench_copy_ref ref;
+	ulong so, doff, n;
+	int i, errors = 0;
+	u8 c;
+
+	for (so = 0; so < 16; so++) {
+		for (doff = 0; doff < 16; doff++) {
+			for (i = 0; i < ARRAY_SIZE(rkbench_check_lens); i++) {
+				n = rkbench_check_lens[i];
+
+				rkbench_pat_fill(a, RKBENCH_CHECK_WIN(n), 0x11);
+				rkbench_pat_fill(b, RKBENCH_CHECK_WIN(n), 0x77);
+				ref.src = so;
+				ref.seed = 0x11;
+				if (memcpy(b + doff, a + so, n) != b + doff ||
+						rkbench_pat_check(b, 0x77, doff, n,
+							rkbench_copy_byte, &ref)) {
+					printf("memcpy  src+%lu dst+%lu len %lu: FAIL\n",
+							so, doff, n);
+					errors++;
+				}
+
+				c = so * 16 + doff;
+				if (memset(b + doff, c, n) != b + doff ||
+						rkbench_pat_check(b, 0x77, doff, n,
+							rkbench_set_byte, &c)) {
+					printf("memset  dst+%lu len %lu: FAIL\n",
+							doff, n);
+					errors++;
+				}
+
+				/* overlapping, destination above then below */
+				rkbench_pat_fill(a, RKBENCH_CHECK_WIN(n), 0x33);
+				ref.src = so;
+				ref.seed = 0x33;
+				if (memmove(a + so + doff + 1, a + so, n) != a + so + doff + 1 ||
+						rkbench_pat_check(a, 0x33, so + doff + 1, n,
+							rkbench_copy_byte, &ref)) {
+					printf("memmove src+%lu dst+%lu len %lu: FAIL\n",
+							so, so + doff + 1, n);
+					errors++;
+				}
+				rkbench_pat_fill(a, RKBENCH_CHECK_WIN(n), 0x55);
+				ref.src = so + doff + 1;
+				ref.seed = 0x55;
+				if (memmove(a + so, a + so + doff + 1, n) != a + so ||
+						rkbench_pat_check(a, 0x55, so, n,
+							rkbench_copy_byte, &ref)) {
+					printf("memmove src+%lu dst+%lu len %lu: FAIL\n",
+							so + doff + 1, so, n);
+					errors++;
+				}
+			}
+			WATCHDOG_RESET();
+		}
+	}
+
+	return errors;
+}
+
+/* MB/s moving RKBENCH_SIZE bytes in len sized calls, best of RKBENCH_LOOPS */
+static ulong rkbench_string_run(int op, u8 *dst, u8 *src, ulong len)
+{
+	ulong best = 0;
+	ulong start, ms, done;
+	int i;
+
+	for (i = 0; i < RKBENCH_LOOPS; i++) {
+		start = get_timer(0);
+		for (done = 0; done < RKBENCH_SIZE; done += len) {
+			if (op == 0)
+				memcpy(dst, src, len);
+			else if (op == 1)
+				memset(dst, done, len);
+			else
+				memmove(src + 64, src, len);
+		}
+		ms = get_timer(start);
+		WATCHDOG_RESET();
+
+		if (ms == 0)
+			ms = 1;
+		best = max(best, (ulong)(RKBENCH_SIZE >> 10) * 1000 / ms >> 10);
+	}
+
+	return best;
+}
+
+static int rkbench_string(u8 *src, u8 *dst)
+{
+	static const ulong sizes[] = { SZ_4K, SZ_256K, RKBENCH_SIZE };
+	static const char * const ops[] = { "memcpy", "memset", "memmove" };
+	int errors, i, j;
+
+	errors = rkbench_string_check(src, dst);
+	printf("string self-check: %s\n", errors ? "FAIL" : "OK");
+
+	printf("%-14s", "size");
+	for (j = 0; j < ARRAY_SIZE(ops); j++)
+		printf("%9s", ops[j]);
+	printf("   (MB/s)\n");
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		printf("%-14lu", sizes[i]);
+		for (j = 0; j < ARRAY_SIZE(ops); j++)
+			printf("%9lu", rkbench_string_run(j, dst, src, sizes[i]));
+		printf("\n");
+	}
+
+	return errors ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+static void rkbench_fill(u32 *buf, ulong len)
+{
+	u32 seed = 0x12345678;
+	ulong i;
+
+	/* small alphabet, so deflate gets a ratio close to a kernel's */
+	for (i = 0; i < len / 4; i++) {
+		seed = seed * 1664525 + 1013904223;
+		buf[i] = (seed >> 8) & 0x1f1f1f1f;
+	}
+}
+
+static int do_rkbench(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	u8 *src = (u8 *)gd->arch.rk_boot_buf_addr;
+	u8 *dst = src + RKBENCH_SIZE;
+	enum rkbench_dcache orig = rkbench_get_dcache();
+	int i, j;
+
+	if (src == NULL)
+		return CMD_RET_FAILURE;
+	if (argc > 1) {
+		if (strcmp(argv[1], "string") != 0)
+			return CMD_RET_USAGE;
+		return rkbench_string(src, dst);
+	}
+
+	rkbench_fill((u32 *)src, RKBENCH_SIZE);
+#ifdef CONFIG_GZIP
+	rkbench_gz_len = RKBENCH_SIZE;
+	if (gzip(src + 2 * RKBENCH_SIZE, &rkbench_gz_len, src, RKBENCH_SIZE)) {
+		printf("rkbench: gzip of the test pattern failed\n");
+		return CMD_RET_FAILURE;
+	}
+	printf("inflate ratio: %lu%%\n", rkbench_gz_len * 100 / RKBENCH_SIZE);
+#endif
+
+	printf("%-14s", "dcache");
+	for (j = 0; j < ARRAY_SIZE(rkbench_tests); j++)
+		printf("%9s", rkbench_tests[j].name);
+	printf("   (MB/s, %d MB)\n", RKBENCH_SIZE >> 20);
+
+	for (i = 0; i < ARRAY_SIZE(rkbench_modes); i++) {
+		rkbench_set_dcache(rkbench_modes[i]);
+		printf("%-14s", rkbench_dcache_name[rkbench_modes[i]]);
+		for (j = 0; j < ARRAY_SIZE(rkbench_tests); j++)
+			printf("%9lu", rkbench_run(rkbench_tests[j].run, dst, src));
+		printf("\n");
+	}
+
+	rkbench_set_dcache(orig);
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	rkbench,	2,	1,	do_rkbench,
+	"boot path throughput benchmarks",
+	"\n    - memcpy/inflate/sha throughput under each dcache mode\n"
+	"rkbench string\n    - memcpy/memset/memmove self-check and throughput\n"
+	"both clobber the boot buffer"
+);
@@ -173,20 +173,18 @@ static void rkusb_init_instances(void)
 	//udc_setup_ep(device_instance, 0, &endpoint_instance[0]);//setup ep0 reg in UdcInit()
 
 #ifdef CONFIG_CMD_FASTBOOT
-	usbcmd.rx_buffer[0] = (u8 *)gd->arch.fastboot_buf_addr;
-	usbcmd.rx_buffer[1] = usbcmd.rx_buffer[0]+(CONFIG_FASTBOOT_TRANSFER_BUFFER_SIZE_EACH>>1);
+	usbcmd.rx_buffer = (u8 *)gd->arch.fastboot_buf_addr;
 
 	usbcmd.tx_buffer[0] = (u8 *)gd->arch.fastboot_buf_addr + CONFIG_FASTBOOT_TRANSFER_BUFFER_SIZE_EACH;
 	usbcmd.tx_buffer[1] = usbcmd.tx_buffer[0]+(CONFIG_FASTBOOT_TRANSFER_BUFFER_SIZE_EACH>>1);
 #else
-	usbcmd.rx_buffer[0] = (u8 *)gd->arch.rk_boot_buf_addr;
-	usbcmd.rx_buffer[1] = usbcmd.rx_buffer[0]+(CONFIG_RK_BOOT_BUFFER_SIZE>>2);
+	usbcmd.rx_buffer = (u8 *)gd->arch.rk_boot_buf_addr;
 
 	usbcmd.tx_buffer[0] = (u8 *)gd->arch.rk_boot_buf_addr + (CONFIG_RK_BOOT_BUFFER_SIZE>>1);
 	usbcmd.tx_buffer[1] = usbcmd.tx_buffer[0]+(CONFIG_RK_BOOT_BUFFER_SIZE>>2);
 #endif
-	RKUSBINFO("%p %p %p %p %x\n",
-		usbcmd.rx_buffer[0], usbcmd.rx_buffer[1], usbcmd.tx_buffer[1], usbcmd.tx_buffer[0], usbcmd.tx_buffer[1]);
+	RKUSBINFO("%p %p %p\n",
+		usbcmd.rx_buffer, usbcmd.tx_buffer[0], usbcmd.tx_buffer[1]);
 	for (i = 1; i <= NUM_ENDPOINTS; i++) {
 		endpoint_instance[i].endpoint_address =
 			ep_descriptor_ptrs[i - 1]->bEndpointAddress;
@@ -221,7 +219,7 @@ static void rkusb_init_instances(void)
 			endpoint_instance[i].rcv_urb =
 				usbd_alloc_urb(device_instance,
 					       &endpoint_instance[i]);
-			endpoint_instance[i].rcv_urb->buffer = usbcmd.rx_buffer[0];
+			endpoint_instance[i].rcv_urb->buffer = usbcmd.rx_buffer;
 			endpoint_instance[i].rcv_urb->status = RECV_OK;
 		}
 	}
@@ -616,6 +614,28 @@ static void FW_Reset(void)
 	usbcmd.status = RKUSB_STATUS_CSW;
 }
 
+/*
+ * Download statistics since the last query, so that the tool gets them per
+ * command when it asks after each one. The queue is programmed by then.
+ */
+static void FW_GetStats(void)
+{
+	struct usb_endpoint_instance *ep = &endpoint_instance[2];
+	struct urb *current_urb = ep->tx_urb;
+	uint32_t *stats = (uint32_t *)&usbcmd.rxq.stats;
+	uint32_t *reply = (uint32_t *)current_urb->buffer;
+	int i;
+
+	for (i = 0; i < sizeof(usbcmd.rxq.stats) / 4; i++)
+		reply[i] = cpu_to_le32(stats[i]);
+	memset(&usbcmd.rxq.stats, 0, sizeof(usbcmd.rxq.stats));
+	current_urb->actual_length = sizeof(usbcmd.rxq.stats);
+
+	usbcmd.csw.Residue = cpu_to_be32(usbcmd.cbw.DataTransferLength);
+	usbcmd.csw.Status = CSW_GOOD;
+	usbcmd.status = RKUSB_STATUS_TXDATA;
+}
+
 static int rkusb_send_csw(void)
 {
 	struct usb_endpoint_instance *ep1 = &endpoint_instance[2];
@@ -649,6 +669,144 @@ static int rkusb_send_csw(void)
 	return 0;
 }
 
+static inline uint32_t rkusb_block_length(uint32_t cmnd)
+{
+	return cmnd == K_FW_WRITE_10 ? 528 : 512;
+}
+
+static inline ulong rkusb_us_since(ulong start)
+{
+	return timer_get_boot_us() - start;
+}
+
+/* point urb at the free slot head for the next piece of the download */
+static void rkusb_rx_arm(struct urb *urb)
+{
+	struct cmd_rockusb_rxqueue *q = &usbcmd.rxq;
+	struct cmd_rockusb_rxslot *slot = &q->slot[q->head % CONFIG_ROCKUSB_RX_QUEUE];
+	uint32_t block_length = rkusb_block_length(usbcmd.cmnd);
+	uint32_t transfer_length;
+
+	transfer_length = usbcmd.d_size - usbcmd.d_bytes;
+	if (transfer_length > RKUSB_RX_SLOT_SIZE / block_length * block_length)
+		transfer_length = RKUSB_RX_SLOT_SIZE / block_length * block_length;
+
+	slot->lba = usbcmd.lba + usbcmd.d_bytes / block_length;
+	slot->cmnd = usbcmd.cmnd;
+	slot->imgwr_mode = usbcmd.imgwr_mode;
+	urb->buffer = usbcmd.rx_buffer + (q->head % CONFIG_ROCKUSB_RX_QUEUE) * RKUSB_RX_SLOT_SIZE;
+	urb->buffer_length = transfer_length;
+	urb->actual_length = 0;
+}
+
+/* udc irq: queue the received slot and go on with the next free one */
+static int rkusb_rx_refill(struct urb *urb)
+{
+	struct cmd_rockusb_rxqueue *q = &usbcmd.rxq;
+
+	/* not a download, or its csw is out and this is the next cbw */
+	if (usbcmd.status != RKUSB_STATUS_RXDATA || usbcmd.d_bytes >= usbcmd.d_size
+			|| urb->status != RECV_OK)
+		return 0;
+
+	q->slot[q->head % CONFIG_ROCKUSB_RX_QUEUE].len = urb->actual_length;
+	q->head++;
+	usbcmd.d_bytes += urb->actual_length;
+	if (usbcmd.d_bytes >= usbcmd.d_size)
+		return 0;
+
+	if (q->head - q->tail >= CONFIG_ROCKUSB_RX_QUEUE) {
+		q->stall_start = timer_get_boot_us();
+		q->stalled = 1;
+		return 0;
+	}
+	rkusb_rx_arm(urb);
+	return 1;
+}
+
+/* a slot is free again, restart the usb the irq left waiting */
+static void rkusb_rx_resume(void)
+{
+	struct usb_endpoint_instance *ep = &endpoint_instance[1];
+	struct cmd_rockusb_rxqueue *q = &usbcmd.rxq;
+
+	q->stats.stall_us += rkusb_us_since(q->stall_start);
+	q->stalled = 0;
+	rkusb_rx_arm(ep->rcv_urb);
+	resume_usb(ep, 0);
+}
+
+/*
+ * Program the oldest queued slots. Full slots of one lba write that follow
+ * each other on the media and in the ring go in one storage request.
+ */
+static void rkusb_rx_program(void)
+{
+	struct cmd_rockusb_rxqueue *q = &usbcmd.rxq;
+	struct cmd_rockusb_rxslot *slot, *next;
+	uint32_t tail = q->tail;
+	uint32_t block_length, blocks, len, n;
+	uint8_t *rxdata_buf;
+	ulong start;
+	int ret = FTL_OK;
+
+	if (tail == q->head)
+		return;
+
+	slot = &q->slot[tail % CONFIG_ROCKUSB_RX_QUEUE];
+	rxdata_buf = usbcmd.rx_buffer + (tail % CONFIG_ROCKUSB_RX_QUEUE) * RKUSB_RX_SLOT_SIZE;
+	block_length = rkusb_block_length(slot->cmnd);
+	len = slot->len;
+	n = 1;
+	if (slot->cmnd == K_FW_LBA_WRITE_10 && slot->lba < 0xFFFFF000) {
+		while (tail + n != q->head && (tail + n) % CONFIG_ROCKUSB_RX_QUEUE != 0
+				&& len == n * RKUSB_RX_SLOT_SIZE) {
+			next = &q->slot[(tail + n) % CONFIG_ROCKUSB_RX_QUEUE];
+			if (next->cmnd != slot->cmnd || next->imgwr_mode != slot->imgwr_mode
+					|| next->lba != slot->lba + len / 512)
+				break;
+			len += next->len;
+			n++;
+		}
+	}
+	blocks = len / block_length;
+
+	start = timer_get_boot_us();
+	if (blocks) {
+		RKUSBINFO("write to media %x, lba %x, buf %p\n", blocks, slot->lba, rxdata_buf);
+		if (slot->cmnd == K_FW_WRITE_10) {
+			ISetLoaderFlag(SYS_LOADER_ERR_FLAG);
+			if (SecureBootLock == 0)
+				ret = StorageWritePba(slot->lba, rxdata_buf, blocks);
+		} else if (slot->cmnd == K_FW_LBA_WRITE_10) {
+			if (slot->lba >= 0xFFFFFF00)
+				StorageVendorSysDataStore(slot->lba - 0xFFFFFF00, blocks, (uint32 *)rxdata_buf);
+			else if (slot->lba == 0xFFFFF000)
+				SecureBootUnlock(rxdata_buf);
+			else if (SecureBootLock == 0)
+				ret = StorageWriteLba(slot->lba, rxdata_buf, blocks, slot->imgwr_mode);
+		}
+		q->stats.media_bytes += blocks * block_length;
+		q->stats.media_writes++;
+		if (ret != FTL_OK) {
+			q->stats.media_errors++;
+			q->failed = 1;
+		}
+	}
+	q->stats.media_us += rkusb_us_since(start);
+
+	q->tail = tail + n;
+	if (q->stalled)
+		rkusb_rx_resume();
+}
+
+/* program the whole queue, before anything else touches the media */
+static void rkusb_rx_flush(void)
+{
+	while (usbcmd.rxq.tail != usbcmd.rxq.head)
+		rkusb_rx_program();
+}
+
 void do_rockusb_cmd(void)
 {
 	struct usb_endpoint_instance *ep = &endpoint_instance[2];
@@ -656,6 +814,9 @@ void do_rockusb_cmd(void)
 	current_urb->buffer = usbcmd.tx_buffer[usbcmd.txbuf_num&1];
 	usbcmd.cmnd = usbcmd.cbw.CDB[0];
 	RKUSBINFO("CBW %x %x %x\n",usbcmd.cbw.Tag, usbcmd.cbw.Flags, usbcmd.cbw.Length);
+
+	/* only a download the host gave up on half way leaves slots queued */
+	rkusb_rx_flush();
     
 //	RKUSBINFO("do_rockusb_cmd %x\n", usbcmd.cbw.CDB[0]);
 	switch (usbcmd.cmnd)
@@ -705,6 +866,9 @@ void do_rockusb_cmd(void)
 		case K_FW_LOW_FORMAT:		//0x1C
 			FW_LowFormat();
 			break;
+		case K_FW_GET_STATS:		//0x1D
+			FW_GetStats();
+			break;
 		case K_FW_SET_RESET_FLAG:       //0x1e
 			FW_SetResetFlag();
 			break;
@@ -721,76 +885,39 @@ void do_rockusb_cmd(void)
 void rkusb_handle_datarx(void)
 {
 	struct usb_endpoint_instance *ep = &endpoint_instance[1];
-	struct urb *current_urb = ep->rcv_urb;
-	uint8_t *rxdata_buf = NULL;
-	uint32_t rxdata_blocks = 0;
-	uint32_t transfer_length;
-	uint32_t rx_blocks = 0;
-	uint32_t block_length ;
-    
-	if(usbcmd.cmnd == K_FW_WRITE_10)
-		block_length = 528;
-	else if(usbcmd.cmnd == K_FW_LBA_WRITE_10)
-		block_length = 512;
-	else
-		block_length = 512;
-
-	// updatea varilables
-	if(current_urb->actual_length) { // data received
-		usbcmd.d_bytes += current_urb->actual_length;
-		rxdata_buf = (uint8_t *)current_urb->buffer;
-		rxdata_blocks = current_urb->actual_length / block_length;
-
-		current_urb->actual_length = 0;
-		usbcmd.rxbuf_num ++;
-		current_urb->buffer = usbcmd.rx_buffer[usbcmd.rxbuf_num & 1];
-//		RKUSBINFO("data received %x %p\n", rxdata_buf, current_urb->buffer);
-    }
-    
-	// read next packet from usb
-	if(usbcmd.d_bytes < usbcmd.d_size) {
-		transfer_length = usbcmd.d_size - usbcmd.d_bytes;
-		rx_blocks = transfer_length / block_length;
-		if(rx_blocks > RKUSB_BUFFER_BLOCK_MAX)
-			rx_blocks = RKUSB_BUFFER_BLOCK_MAX;
-		transfer_length = rx_blocks * block_length;
-        
-//		RKUSBINFO("read next packet %x\n", transfer_length);
-		current_urb->buffer_length = transfer_length;
-		resume_usb(ep, 0);
-		usbcmd.status = RKUSB_STATUS_RXDATA;
-	}
-	else {   // data receive complete
-//		RKUSBINFO("data receive complete\n");
-		usbcmd.csw.Residue = cpu_to_be32(usbcmd.cbw.DataTransferLength);
-		usbcmd.csw.Status = CSW_GOOD;
-//		usbcmd.status = RKUSB_STATUS_CSW;
-		rkusb_send_csw();
-	}
-
-	/* Write to media */
-	if(rxdata_blocks) {
-		RKUSBINFO("write to media %x, lba %x, buf %p\n", rxdata_blocks, usbcmd.lba, rxdata_buf);
-		if(usbcmd.cmnd == K_FW_WRITE_10) {
-			ISetLoaderFlag(SYS_LOADER_ERR_FLAG);
-			if(SecureBootLock == 0) {
-				StorageWritePba(usbcmd.lba, rxdata_buf, rxdata_blocks);
-				usbcmd.lba += rxdata_blocks;
+	struct cmd_rockusb_rxqueue *q = &usbcmd.rxq;
+
+	if (usbcmd.status == RKUSB_STATUS_RXDATA_PREPARE) {
+		q->usb_start = timer_get_boot_us();
+		q->usb_done = 0;
+		q->failed = 0;
+		if (usbcmd.d_size != 0) {
+			/* set before the usb starts, the irq only refills downloads */
+			usbcmd.status = RKUSB_STATUS_RXDATA;
+			if (q->head - q->tail >= CONFIG_ROCKUSB_RX_QUEUE) {
+				q->stall_start = q->usb_start;
+				q->stalled = 1;
+			} else {
+				rkusb_rx_arm(ep->rcv_urb);
+				resume_usb(ep, 0);
 			}
+			return;
 		}
-		else if(usbcmd.cmnd == K_FW_LBA_WRITE_10) {
-			if(usbcmd.lba >= 0xFFFFFF00) {
-				StorageVendorSysDataStore(usbcmd.lba - 0xFFFFFF00, rxdata_blocks, (uint32 *)rxdata_buf);
-				usbcmd.lba += rxdata_blocks;
-			}
-			else if(usbcmd.lba == 0xFFFFF000) {
-				SecureBootUnlock(rxdata_buf);
-			}
-			else if(SecureBootLock == 0) {
-				StorageWriteLba(usbcmd.lba, rxdata_buf, rxdata_blocks, usbcmd.imgwr_mode);
-				usbcmd.lba += rxdata_blocks;
-			}
+	}
+
+	// data receive complete, the csw waits until the main loop has programmed its slots
+	if (usbcmd.d_bytes >= usbcmd.d_size) {
+		if (!q->usb_done) {
+			q->stats.usb_bytes += usbcmd.d_bytes;
+			q->stats.usb_us += rkusb_us_since(q->usb_start);
+			q->usb_done = 1;
 		}
+		if (q->tail != q->head)
+			return;
+
+		usbcmd.csw.Residue = cpu_to_be32(usbcmd.cbw.DataTransferLength);
+		usbcmd.csw.Status = q->failed ? CSW_FAIL : CSW_GOOD;
+		rkusb_send_csw();
 	}
 }
 
@@ -869,7 +996,6 @@ void rkusb_handle_response(void)
 {
 	struct usb_endpoint_instance *ep;
 	struct urb *current_urb = NULL;
-	uint32_t actural_length;
 
 	switch (usbcmd.status) {
 	case RKUSB_STATUS_TXDATA:
@@ -887,14 +1013,6 @@ void rkusb_handle_response(void)
 		break;
 
 	case RKUSB_STATUS_RXDATA:
-		ep = &endpoint_instance[1];
-		current_urb = ep->rcv_urb;
-		actural_length = current_urb->actual_length;
-
-		if(actural_length)
-			rkusb_handle_datarx();
-		break;
-
 	case RKUSB_STATUS_RXDATA_PREPARE:
 		rkusb_handle_datarx();
 		break;
@@ -979,6 +1097,7 @@ int do_rockusb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 	rkusb_init_strings();
 	rkusb_init_instances();
+	udc_set_rx_refill(rkusb_rx_refill);
 
 	udc_startup_events(device_instance);
 	udc_connect();
@@ -992,7 +1111,7 @@ int do_rockusb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 			struct usb_endpoint_instance *ep = &endpoint_instance[1];
 			if(ep->rcv_urb->actual_length) {
 				usbcmd.status = RKUSB_STATUS_CMD;
-				ep->rcv_urb->buffer = usbcmd.rx_buffer[usbcmd.rxbuf_num&1];
+				ep->rcv_urb->buffer = usbcmd.rx_buffer;
 				do_rockusb_cmd();
 			}
 		}
@@ -1005,12 +1124,16 @@ int do_rockusb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		if (usbcmd.status == RKUSB_STATUS_CSW) {
 			rkusb_send_csw();
 		}
+		/* one storage request per pass, the usb keeps filling the queue */
+		rkusb_rx_program();
 		rkusb_reset_check();
 		rkusb_lowformat_check();
 #ifdef CONFIG_ROCKUSB_TIMEOUT_CHECK
 		/* if press key enter rockusb, flag = 1 */
 		if(rkusb_timeout_check(flag) == 1) {
 			/* if timeout, return 1 for enter recovery */
+			rkusb_rx_flush();
+			udc_set_rx_refill(NULL);
 			return 1;
 		}
 #endif
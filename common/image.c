@@ -10,6 +10,7 @@
 #ifndef USE_HOSTCC
 #include <common.h>
 #include <watchdog.h>
+#include <dma_memcpy.h>
 
 #ifdef CONFIG_SHOW_BOOT_PROGRESS
 #include <status_led.h>
@@ -1121,10 +1122,17 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 			printf("   Loading Ramdisk to %08lx, end %08lx ... ",
 					*initrd_start, *initrd_end);
 
-			memmove_wd((void *)*initrd_start,
-					(void *)rd_data, rd_len, CHUNKSZ);
+			/*
+			 * lands while the fdt is set up, see dma_wait(): keep
+			 * the fdt off the source meanwhile, the destination is
+			 * reserved by the alloc above
+			 */
+			lmb_reserve(lmb, rd_data, rd_len);
+			dma_memcpy_async((void *)*initrd_start,
+					(void *)rd_data, rd_len);
 
 #ifdef CONFIG_MP
+			dma_wait();
 			/*
 			 * Ensure the image is flushed to memory to handle
 			 * AMP boot scenarios in which we might not be
@@ -142,6 +142,11 @@ static short console_row;
 
 static void *lcd_console_address;
 static void *lcd_base;			/* Start of framebuffer memory	*/
+#ifdef CONFIG_RK_FB
+/* set by lcd_decode_frame(): bitmap goes here and is not shown */
+static void *lcd_frame_buf;
+static struct fb_dsp_info *lcd_frame_info;
+#endif
 
 static char lcd_flush_dcache;	/* 1 to flush dcache after each lcd update */
 
@@ -433,7 +438,9 @@ int drv_lcd_init(void)
 
 	lcd_base = map_sysmem(gd->fb_base, 0);
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_LCD, "lcd");
 	lcd_init(lcd_base);		/* LCD initialization */
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_LCD);
 
 	/* Device initialization */
 	memset(&lcddev, 0, sizeof(lcddev));
@@ -858,8 +865,8 @@ static void draw_encoded_bitmap(ushort **fbp, ushort c, int cnt)
 /*
  * Do not call this function directly, must be called from lcd_display_bitmap.
  */
-static void lcd_display_rle8_bitmap(bmp_image_t *bmp, ushort *cmap, uchar *fb,
-				    int x_off, int y_off)
+static void lcd_display_rle8_bitmap(bmp_image_t *bmp, ushort *cmap,
+				    uchar *base, uchar *fb, int x_off, int y_off)
 {
 	uchar *bmap;
 	ulong width, height;
@@ -894,7 +901,7 @@ static void lcd_display_rle8_bitmap(bmp_image_t *bmp, ushort *cmap, uchar *fb,
 				x += bmap[2];
 				y -= bmap[3];
 				/* 16bpix, 2-byte per pixel, x should *2 */
-				fb = (uchar *) (lcd_base + (y + y_off - 1)
+				fb = (uchar *) (base + (y + y_off - 1)
 					* lcd_line_length + (x + x_off) * 2);
 				bmap += 4;
 				break;
@@ -1001,6 +1008,7 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
 	ushort *cmap = tmpmap;
 	struct fb_dsp_info fb_info;
 	u8 format = RGB565;
+	uchar *fb_start;
 #endif
 #endif
 	ushort *cmap_base = NULL;
@@ -1131,18 +1139,23 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
   	bmap = (uchar *)bmp + get_unaligned_le32(&bmp->header.data_offset);
 #if defined(CONFIG_RK_FB)
 	/* rk charge mode, enable fb flip */
-	if (lcd_flip) {
-		if((unsigned long)lcd_base == gd->fb_base)
-			lcd_base += width * height * bpix >> 3;
-		else
-			lcd_base = (void *)gd->fb_base;
+	if (lcd_frame_buf) {
+		fb_start = lcd_frame_buf;
 	} else {
-		lcd_base = (void *)gd->fb_base;
+		if (lcd_flip) {
+			if((unsigned long)lcd_base == gd->fb_base)
+				lcd_base += width * height * bpix >> 3;
+			else
+				lcd_base = (void *)gd->fb_base;
+		} else {
+			lcd_base = (void *)gd->fb_base;
+		}
+		lcd_base = (void *) ALIGN((ulong)lcd_base, CONFIG_LCD_ALIGNMENT);
+		fb_start = lcd_base;
 	}
-	lcd_base = (void *) ALIGN((ulong)lcd_base, CONFIG_LCD_ALIGNMENT);
 
 	lcd_line_length = (width * bpix) / 8;
-	fb = (uchar *) (lcd_base + ( height - 1) * lcd_line_length);
+	fb = (uchar *) (fb_start + ( height - 1) * lcd_line_length);
 #else
 	fb   = (uchar *)(lcd_base +
 		(y + height - 1) * lcd_line_length + x * bpix / 8);
@@ -1161,7 +1174,14 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
 					printf("Error: only support 16 bpix");
 					return 1;
 				}
-				lcd_display_rle8_bitmap(bmp, cmap_base, fb, x, y);
+#ifdef CONFIG_RK_FB
+				/* the rk buffer holds just the bitmap */
+				lcd_display_rle8_bitmap(bmp, cmap_base, fb_start,
+							fb, 0, 0);
+#else
+				lcd_display_rle8_bitmap(bmp, cmap_base, lcd_base,
+							fb, x, y);
+#endif
 				break;
 			}
 		}
@@ -1259,7 +1279,11 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
 	fb_info.xvir = fb_info.xact;
 	fb_info.layer_id = WIN0;
 	fb_info.format = format;
-	fb_info.yaddr = (u32)(unsigned long)lcd_base;
+	fb_info.yaddr = (u32)(unsigned long)fb_start;
+	if (lcd_frame_buf) {
+		*lcd_frame_info = fb_info;
+		return 0;
+	}
 	lcd_pandispaly(&fb_info);
 #endif
 
@@ -1268,6 +1292,44 @@ int lcd_display_bitmap(ulong bmp_image, int x, int y)
 }
 #endif
 
+#if defined(CONFIG_RK_FB) && (defined(CONFIG_CMD_BMP) || defined(CONFIG_SPLASH_SCREEN))
+/*
+ * Decode a bmp, centered as lcd_display_bitmap_center() does, into buf in
+ * lcdc format without showing it. Returns the bytes used, or -1 if the
+ * bitmap is invalid or doesn't fit in len. lcd_show_frame() puts it on
+ * screen by moving the window base, nothing is copied.
+ */
+int lcd_decode_frame(ulong bmp_image, void *buf, size_t len,
+		struct fb_dsp_info *info)
+{
+	bmp_image_t *bmp = (bmp_image_t *)bmp_image;
+	unsigned long width, height, size;
+	int ret;
+
+	if (!bmp || !(bmp->header.signature[0] == 'B' &&
+			bmp->header.signature[1] == 'M'))
+		return -1;
+
+	width = get_unaligned_le32(&bmp->header.width);
+	height = get_unaligned_le32(&bmp->header.height);
+	size = width * height *
+		(get_unaligned_le16(&bmp->header.bit_count) > 16 ? 4 : 2);
+	if (size > len)
+		return -1;
+
+	lcd_frame_buf = buf;
+	lcd_frame_info = info;
+	ret = lcd_display_bitmap_center(bmp_image);
+	lcd_frame_buf = NULL;
+	lcd_frame_info = NULL;
+	if (ret)
+		return -1;
+
+	flush_dcache_range((ulong)buf, (ulong)buf + size);
+	return size;
+}
+#endif
+
 static void *lcd_logo(void)
 {
 #ifdef CONFIG_SPLASH_SCREEN
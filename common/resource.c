@@ -35,6 +35,7 @@
 
 #include <fdt_support.h>
 #include <lcd.h>
+#include <lz4.h>
 
 static bool inline read_storage(lbaint_t offset, void* buf, uint16_t blocks) {
 #if 1
@@ -48,7 +49,190 @@ static bool inline read_storage(lbaint_t offset, void* buf, uint16_t blocks) {
 #endif
 }
 
-static int inline get_base_offset(void) {
+/*
+ * resource index cache: the index table of a resource image is read once
+ * and hashed by path. a few images (resource partition, boot/recovery
+ * second area) can be cached at the same time, and all of them are
+ * dropped once the storage content may have changed.
+ */
+#define RESOURCE_INDEX_SLOTS	4
+#define RESOURCE_INDEX_NONE	0xFFFF
+
+typedef struct {
+	int base_offset;
+	uint32_t write_count;//StorageGetWriteCount() when loaded.
+	uint32_t entry_num;
+	uint32_t bucket_mask;
+	char* table;//raw index table, one entry per tbl_entry_size blocks.
+	uint16_t* buckets;//first entry of each hash chain.
+	uint16_t* chain;//next entry in the same chain.
+} resource_index;
+
+static resource_index resource_indexes[RESOURCE_INDEX_SLOTS];
+static int resource_index_victim;
+
+static int resource_base_offset;
+static uint32_t resource_base_write_count;
+
+static inline uint32_t resource_hash(const char* path) {
+	uint32_t hash = 5381;
+	int i;
+
+	for (i = 0; i < MAX_INDEX_ENTRY_PATH_LEN && path[i]; i++)
+		hash = hash * 33 + (unsigned char)path[i];
+	return hash;
+}
+
+static inline index_tbl_entry* resource_index_entry(resource_index* index,
+		uint32_t i) {
+	return (index_tbl_entry*)(index->table
+			+ i * INDEX_TBL_ENTR_SIZE * BLOCK_SIZE);
+}
+
+static void resource_index_free(resource_index* index) {
+	if (index->table)
+		free(index->table);
+	if (index->buckets)
+		free(index->buckets);
+	memset(index, 0, sizeof(*index));
+}
+
+static bool resource_check_header(const resource_ptn_header* header) {
+	if (memcmp(header->magic, RESOURCE_PTN_HDR_MAGIC,
+				sizeof(header->magic))) {
+		FBTERR("Not a resource image!\n");
+		return false;
+	}
+
+	//TODO: support header_size & tbl_entry_size
+	if (header->resource_ptn_version != RESOURCE_PTN_VERSION
+			|| header->header_size != RESOURCE_PTN_HDR_SIZE
+			|| header->index_tbl_version != INDEX_TBL_VERSION
+			|| header->tbl_entry_size != INDEX_TBL_ENTR_SIZE) {
+		FBTERR("Not supported in this version!\n");
+		return false;
+	}
+	return true;
+}
+
+static bool resource_index_load(resource_index* index, int base_offset) {
+	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, BLOCK_SIZE);
+	resource_ptn_header header;
+	uint32_t buckets, i, hash;
+
+	memset(index, 0, sizeof(*index));
+	if (!read_storage(base_offset, buf, 1)) {
+		FBTERR("Failed to read header!\n");
+		return false;
+	}
+	memcpy(&header, buf, sizeof(header));
+	if (!resource_check_header(&header))
+		return false;
+	if (!header.tbl_entry_num
+			|| header.tbl_entry_num * header.tbl_entry_size > 0xFFFF) {
+		FBTERR("Bad index entry num:%d!\n", header.tbl_entry_num);
+		return false;
+	}
+
+	for (buckets = 16; buckets < header.tbl_entry_num; buckets <<= 1)
+		;
+	index->table = (char *)memalign(ARCH_DMA_MINALIGN,
+			header.tbl_entry_num * header.tbl_entry_size * BLOCK_SIZE);
+	index->buckets = (uint16_t *)malloc((buckets + header.tbl_entry_num)
+			* sizeof(uint16_t));
+	if (!index->table || !index->buckets)
+		goto err;
+	index->chain = index->buckets + buckets;
+	index->bucket_mask = buckets - 1;
+	index->entry_num = header.tbl_entry_num;
+
+	if (!read_storage(base_offset + header.header_size, index->table,
+				header.tbl_entry_num * header.tbl_entry_size)) {
+		FBTERR("Failed to read index entries!\n");
+		goto err;
+	}
+
+	memset(index->buckets, 0xFF, buckets * sizeof(uint16_t));
+	//insert backwards, so the first of duplicated paths wins like the linear scan did.
+	for (i = index->entry_num; i > 0; i--) {
+		index_tbl_entry* entry = resource_index_entry(index, i - 1);
+
+		if (memcmp(entry->tag, INDEX_TBL_ENTR_TAG,
+					sizeof(entry->tag))) {
+			FBTERR("Something wrong with index entry:%d!\n", i - 1);
+			goto err;
+		}
+		hash = resource_hash(entry->path) & index->bucket_mask;
+		index->chain[i - 1] = index->buckets[hash];
+		index->buckets[hash] = i - 1;
+	}
+
+	index->base_offset = base_offset;
+	index->write_count = StorageGetWriteCount();
+	FBTDBG("resource index at 0x%x: %d entries\n", base_offset,
+			index->entry_num);
+	return true;
+err:
+	resource_index_free(index);
+	return false;
+}
+
+static resource_index* get_index(int base_offset) {
+	uint32_t write_count = StorageGetWriteCount();
+	resource_index* index;
+	int i;
+
+	for (i = 0; i < RESOURCE_INDEX_SLOTS; i++) {
+		index = &resource_indexes[i];
+		if (!index->table)
+			continue;
+		if (index->write_count != write_count) {
+			resource_index_free(index);
+			continue;
+		}
+		if (index->base_offset == base_offset)
+			return index;
+	}
+
+	for (i = 0; i < RESOURCE_INDEX_SLOTS; i++) {
+		if (!resource_indexes[i].table)
+			break;
+	}
+	if (i == RESOURCE_INDEX_SLOTS) {
+		i = resource_index_victim;
+		resource_index_victim = (resource_index_victim + 1)
+			% RESOURCE_INDEX_SLOTS;
+		resource_index_free(&resource_indexes[i]);
+	}
+
+	index = &resource_indexes[i];
+	if (!resource_index_load(index, base_offset))
+		return NULL;
+	return index;
+}
+
+static bool index_lookup(resource_index* index, const char* file_path,
+		index_tbl_entry* entry) {
+	uint16_t i;
+
+	i = index->buckets[resource_hash(file_path) & index->bucket_mask];
+	for (; i != RESOURCE_INDEX_NONE; i = index->chain[i]) {
+		index_tbl_entry* cur = resource_index_entry(index, i);
+
+		if (!strncmp(cur->path, file_path, sizeof(cur->path))) {
+			memcpy(entry, cur, sizeof(*entry));
+			FBTDBG("Found entry:\n\tpath:%s\n\toffset:%d\tsize:%d\n",
+					entry->path, entry->content_offset,
+					entry->content_size);
+			return true;
+		}
+	}
+
+	FBTERR("Cannot find %s!\n", file_path);
+	return false;
+}
+
+static int inline find_base_offset(void) {
 	const disk_partition_t* ptn;
 #ifdef CONFIG_ROCKCHIP
 	ptn	= get_disk_partition(RESOURCE_NAME);
@@ -67,7 +251,10 @@ static int inline get_base_offset(void) {
 			rk_boot_img_hdr *hdr = NULL;
 
 			hdr = memalign(ARCH_DMA_MINALIGN, blksz << 2);
+			if (!hdr)
+				return 0;
 			if (StorageReadLba(ptn->start, (void *) hdr, 1 << 2) != 0) {
+				free(hdr);
 				return 0;
 			}
 			//load from bootimg's second data area.
@@ -76,9 +263,9 @@ static int inline get_base_offset(void) {
 				offset = ptn->start + (hdr->page_size / blksz);
 				offset += ALIGN(hdr->kernel_size, hdr->page_size) / blksz;
 				offset += ALIGN(hdr->ramdisk_size, hdr->page_size) / blksz;
-
-				return offset;
 			}
+			free(hdr);
+			return offset;
 		}
 
 		return 0;
@@ -86,25 +273,24 @@ static int inline get_base_offset(void) {
 	return ptn->start;
 }
 
+static int get_base_offset(void) {
+	uint32_t write_count = StorageGetWriteCount();
+
+	//boot partition may be rewritten, so only trust the cached offset until then.
+	if (!resource_base_offset || resource_base_write_count != write_count) {
+		resource_base_offset = find_base_offset();
+		resource_base_write_count = write_count;
+	}
+	return resource_base_offset;
+}
+
 static bool get_entry_ram(resource_ptn_header header, void *table,
 		size_t table_len, const char* file_path,
 		index_tbl_entry* entry) {
 	bool ret = false;
 
-	if (memcmp(header.magic, RESOURCE_PTN_HDR_MAGIC,
-				sizeof(header.magic))) {
-		FBTERR("Not a resource image!\n");
+	if (!resource_check_header(&header))
 		goto end;
-	}
-
-	//TODO: support header_size & tbl_entry_size
-	if (header.resource_ptn_version != RESOURCE_PTN_VERSION
-			|| header.header_size != RESOURCE_PTN_HDR_SIZE
-			|| header.index_tbl_version != INDEX_TBL_VERSION
-			|| header.tbl_entry_size != INDEX_TBL_ENTR_SIZE) {
-		FBTERR("Not supported in this version!\n");
-		goto end;
-	}
 
 	if (header.tbl_entry_num * header.tbl_entry_size <= 0xFFFF) {
 		if (!table)
@@ -176,10 +362,7 @@ end:
 
 static bool get_entry(int base_offset, const char* file_path,
 		index_tbl_entry* entry) {
-	bool ret = false;
-	ALLOC_CACHE_ALIGN_BUFFER(u8, buf, BLOCK_SIZE);
-	char* table = NULL;
-	resource_ptn_header header;
+	resource_index* index;
 
 	debug("get_entry: base_offset = 0x%x\n", base_offset);
 	if (!base_offset) {
@@ -187,50 +370,12 @@ static bool get_entry(int base_offset, const char* file_path,
 	}
 	if (!base_offset) {
 		FBTERR("base offset is NULL!\n");
-		goto end;
-	}
-	if (!read_storage(base_offset, buf, 1)) {
-		FBTERR("Failed to read header!\n");
-		goto end;
-	}
-	memcpy(&header, buf, sizeof(header));
-
-	if (memcmp(header.magic, RESOURCE_PTN_HDR_MAGIC,
-				sizeof(header.magic))) {
-		FBTERR("Not a resource image!\n");
-		goto end;
-	}
-	//TODO: support header_size & tbl_entry_size
-	if (header.resource_ptn_version != RESOURCE_PTN_VERSION
-			|| header.header_size != RESOURCE_PTN_HDR_SIZE
-			|| header.index_tbl_version != INDEX_TBL_VERSION
-			|| header.tbl_entry_size != INDEX_TBL_ENTR_SIZE) {
-		FBTERR("Not supported in this version!\n");
-		goto end;
-	}
-
-	if (header.tbl_entry_num * header.tbl_entry_size <= 0xFFFF) {
-		table = (char *)memalign(ARCH_DMA_MINALIGN,
-				header.tbl_entry_num
-				* header.tbl_entry_size * BLOCK_SIZE);
-		if (!table)
-			goto end;
-		if (!read_storage(base_offset + header.header_size, table,
-					header.tbl_entry_num
-					* header.tbl_entry_size)) {
-			FBTERR("Failed to read index entries!\n");
-			goto end;
-		}
-	}
-	ret = get_entry_ram(header, table, header.tbl_entry_num
-			* header.tbl_entry_size * BLOCK_SIZE,
-			file_path, entry);
-
-end:
-	if (table) {
-		free(table);
+		return false;
 	}
-	return ret;
+	index = get_index(base_offset);
+	if (!index)
+		return false;
+	return index_lookup(index, file_path, entry);
 }
 
 bool get_content(int base_offset, resource_content* content) {
@@ -279,6 +424,93 @@ bool load_content(resource_content* content) {
 	return true;
 }
 
+static int content_offset_cmp(const void* a, const void* b) {
+	const resource_content* x = *(const resource_content**)a;
+	const resource_content* y = *(const resource_content**)b;
+
+	if (x->content_offset == y->content_offset)
+		return 0;
+	return x->content_offset < y->content_offset ? -1 : 1;
+}
+
+/*
+ * Load several contents of the same image into buf in one pass.
+ * Contents are laid out in disk order, and every run of adjacent
+ * contents is read with a single storage request. load_addr of each
+ * content points into buf, so don't free_content() them.
+ */
+bool load_contents(int base_offset, resource_content* contents, int num,
+		void* buf, size_t len) {
+	resource_content** sorted;
+	index_tbl_entry entry;
+	uint32_t run_start, run_end, blocks;
+	char* dst = buf;
+	bool ret = false;
+	int i, run;
+
+	if (!base_offset) {
+		base_offset = get_base_offset();
+	}
+	if (!base_offset || num <= 0 || !buf) {
+		FBTERR("Invalid args to load contents!\n");
+		return false;
+	}
+
+	sorted = (resource_content**)malloc(num * sizeof(*sorted));
+	if (!sorted)
+		return false;
+	for (i = 0; i < num; i++) {
+		if (!get_entry(base_offset, contents[i].path, &entry))
+			goto end;
+		contents[i].content_offset = entry.content_offset + base_offset;
+		contents[i].content_size = entry.content_size;
+		contents[i].load_addr = NULL;
+		sorted[i] = &contents[i];
+	}
+	qsort(sorted, num, sizeof(*sorted), content_offset_cmp);
+
+	for (i = 0; i < num; i = run) {
+		run_start = sorted[i]->content_offset;
+		run_end = run_start;
+		for (run = i; run < num; run++) {
+			if (sorted[run]->content_offset > run_end)
+				break;
+			blocks = (sorted[run]->content_size + BLOCK_SIZE - 1)
+				/ BLOCK_SIZE;
+			if (sorted[run]->content_offset + blocks > run_end)
+				run_end = sorted[run]->content_offset + blocks;
+			sorted[run]->load_addr = dst
+				+ (sorted[run]->content_offset - run_start)
+				* BLOCK_SIZE;
+		}
+
+		blocks = run_end - run_start;
+		if ((dst - (char*)buf) + blocks * BLOCK_SIZE > len) {
+			FBTERR("Buffer too small to load contents!\n");
+			goto end;
+		}
+		FBTDBG("load contents: %d entries, %d blocks at 0x%x\n",
+				run - i, blocks, run_start);
+		while (blocks) {
+			uint16_t chunk = blocks > 0xFFFF ? 0xFFFF : blocks;
+
+			if (!read_storage(run_start, dst, chunk))
+				goto end;
+			run_start += chunk;
+			dst += chunk * BLOCK_SIZE;
+			blocks -= chunk;
+		}
+	}
+	ret = true;
+end:
+	if (!ret) {
+		for (i = 0; i < num; i++)
+			contents[i].load_addr = NULL;
+	}
+	free(sorted);
+	return ret;
+}
+
 bool load_content_data(resource_content* content,
 		int offset_block, void* data, int blocks) {
 	if (!content->content_offset)
@@ -290,6 +522,50 @@ bool load_content_data(resource_content* content,
 	return true;
 }
 
+bool is_content_packed(const void* data) {
+#ifdef CONFIG_LZ4
+	return !memcmp(data, RESOURCE_LZ4_MAGIC, 4);
+#else
+	return false;
+#endif
+}
+
+/*
+ * Contents packed by resource_tool --lz4 start with a resource_lz4_header.
+ * Returns data itself if it isn't packed, else decodes the size bytes
+ * loaded at data into buf and returns buf, or NULL if it is corrupt or
+ * doesn't fit in len.
+ */
+void* unpack_content(void* data, size_t size, void* buf, size_t len) {
+#ifdef CONFIG_LZ4
+	resource_lz4_header header;
+
+	if (!is_content_packed(data))
+		return data;
+
+	memcpy(&header, data, sizeof(header));
+	if (size < sizeof(header) ||
+	    header.data_size > size - sizeof(header)) {
+		FBTERR("Failed to unpack content, lz4 data past its end, %d\n",
+				header.data_size);
+		return NULL;
+	}
+	if (header.raw_size > len) {
+		FBTERR("Failed to unpack content, too large, %d\n",
+				header.raw_size);
+		return NULL;
+	}
+	if (lz4_decompress_block(data + sizeof(header), header.data_size,
+				buf, header.raw_size) != header.raw_size) {
+		FBTERR("Failed to unpack content, corrupt lz4 data\n");
+		return NULL;
+	}
+	return buf;
+#else
+	return data;
+#endif
+}
+
 bool show_resource_image(const char* image_path) {
 	bool ret = false;
 #ifdef CONFIG_LCD
@@ -324,12 +600,19 @@ bool show_resource_image(const char* image_path) {
 				return false;
 			}
 
-			image.load_addr = (void *)gd->arch.rk_boot_buf_addr;
+			/* packed images load at the end and unpack to the start */
+			image.load_addr = (void *)gd->arch.rk_boot_buf_addr +
+				CONFIG_RK_BOOT_BUFFER_SIZE - blocks * BLOCK_SIZE;
 			if (!load_content_data(&image, 0, image.load_addr, blocks)) {
 				return false;
 			}
+			bmp = unpack_content(image.load_addr, image.content_size,
+					(void *)gd->arch.rk_boot_buf_addr,
+					CONFIG_RK_BOOT_BUFFER_SIZE - blocks * BLOCK_SIZE);
+			if (!bmp)
+				return false;
 			FBTDBG("Try to show:%s\n", image_path);
-			lcd_display_bitmap_center((uint32_t)(unsigned long)image.load_addr);
+			lcd_display_bitmap_center((uint32_t)(unsigned long)bmp);
 
 			ret = true;
 		} else {
@@ -38,6 +38,7 @@
 #include <asm/processor.h>
 
 #include <part.h>
+#include <fs.h>
 #include <usb.h>
 
 #undef BBB_COMDAT_TRACE
@@ -221,6 +222,8 @@ int usb_stor_scan(int mode)
 	if (mode == 1)
 		printf("       scanning usb for storage devices... ");
 
+	fs_invalidate_mounts();
+
 	usb_disable_asynch(1); /* asynch transfer not allowed */
 
 	for (i = 0; i < USB_MAX_STOR_DEV; i++) {
@@ -1127,6 +1130,7 @@ unsigned long usb_stor_write(int device, lbaint_t blknr,
 	if (blkcnt == 0)
 		return 0;
 
+	fs_invalidate_mounts();
 	device &= 0xff;
 	/* Setup  device */
 	debug("\nusb_write: dev %d \n", device);
@@ -16,6 +16,7 @@
 #include <malloc.h>
 #include <linux/list.h>
 #include <div64.h>
+#include <fs.h>
 #include "mmc_private.h"
 
 static struct list_head mmc_devices;
@@ -1369,6 +1370,8 @@ int mmc_init(struct mmc *mmc)
 	if (mmc->has_init)
 		return 0;
 
+	/* a card that was reinserted or rescanned may hold anything */
+	fs_invalidate_mounts();
 	start = get_timer(0);
 
 	if (!mmc->init_in_progress)
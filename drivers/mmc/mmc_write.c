@@ -10,6 +10,7 @@
 #include <config.h>
 #include <common.h>
 #include <part.h>
+#include <fs.h>
 #include "mmc_private.h"
 
 static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
@@ -73,6 +74,8 @@ unsigned long mmc_berase(int dev_num, lbaint_t start, lbaint_t blkcnt)
 	if (!mmc)
 		return -1;
 
+	fs_invalidate_mounts();
+
 	if ((start % mmc->erase_grp_size) || (blkcnt % mmc->erase_grp_size))
 		printf("\n\nCaution! Your devices Erase group is 0x%x\n"
 		       "The erase range would be change to "
@@ -163,6 +166,7 @@ ulong mmc_bwrite(int dev_num, lbaint_t start, lbaint_t blkcnt, const void *src)
 	if (!mmc)
 		return 0;
 
+	fs_invalidate_mounts();
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
@@ -159,6 +159,21 @@ extern uint32_t SecureBootLock_backup;
 
 extern uint32 FW_StorageGetValid(void);
 
+/*
+ * OUT buffers are cleaned before the core gets them, so that no dirty line
+ * can be evicted over the received data, and invalidated again on completion
+ * to drop what the cpu fetched speculatively meanwhile.
+ */
+static inline void dwc_otg_rx_prepare(void *buf, uint32_t len)
+{
+	flush_dcache_range((unsigned long)buf, (unsigned long)buf + ((len + ARCH_DMA_MINALIGN - 1) & ~(ARCH_DMA_MINALIGN - 1)));
+}
+
+static inline void dwc_otg_rx_complete(void *buf, uint32_t len)
+{
+	invalidate_dcache_range((unsigned long)buf, (unsigned long)buf + ((len + ARCH_DMA_MINALIGN - 1) & ~(ARCH_DMA_MINALIGN - 1)));
+}
+
 /**************************************************************************
 ȡ˵
 ***************************************************************************/
@@ -167,7 +182,7 @@ static void ReadEndpoint0(uint16_t len, void *buf)
 	pUSB_OTG_REG OtgReg = (pUSB_OTG_REG)RKIO_USBOTG_BASE;
 
 //	debug("%s: buf = 0x%p, len = %d\n", __func__, buf, len);
-	invalidate_dcache_range((unsigned long)buf, (unsigned long)buf + ((len + ARCH_DMA_MINALIGN - 1) & ~(ARCH_DMA_MINALIGN - 1)));
+	dwc_otg_rx_prepare(buf, len);
 	OtgReg->Device.OutEp[0].DoEpDma = (uint32_t)(unsigned long)buf;
 	OtgReg->Device.OutEp[0].DoEpTSiz = Ep0PktSize | (1<<29) | (1<<19);
 	/* Active ep, Clr Nak, endpoint enable */
@@ -203,7 +218,7 @@ static void ReadBulkEndpoint(uint32_t len, void *buf)
 	uint32_t regBak;
 
 //	debug("%s: buf = 0x%p, len = %d\n", __func__, buf, len);
-	invalidate_dcache_range((unsigned long)buf, (unsigned long)buf + ((len + ARCH_DMA_MINALIGN - 1) & ~(ARCH_DMA_MINALIGN - 1)));
+	dwc_otg_rx_prepare(buf, len);
 	OtgReg->Device.OutEp[BULK_OUT_EP].DoEpDma = (uint32_t)(unsigned long)buf;
 	// OtgReg->Device.OutEp[BULK_OUT_EP].DoEpTSiz = BulkEpSize | (1<<19);
 	regBak = 0x20000 | (((len+BulkEpSize-1)/BulkEpSize)<<19);
@@ -624,6 +639,20 @@ static void dwc_otg_epn_in_ack(void)
 }
 
 
+/*
+ * Bulk out refill, set by a gadget for its downloads: called in the irq
+ * once a transfer landed in the rcv urb, it returns nonzero when it has
+ * taken the data and pointed the urb at a free buffer, then the next
+ * transfer starts right away. Otherwise the endpoint naks until the next
+ * resume_usb().
+ */
+static int (*udc_rx_refill)(struct urb *urb);
+
+void udc_set_rx_refill(int (*refill)(struct urb *urb))
+{
+	udc_rx_refill = refill;
+}
+
 volatile int suspend = 1;
 void suspend_usb(void)
 {
@@ -681,6 +710,7 @@ static bool dwc_otg_fix_test_ready(int len, void *buf)
 static void dwc_otg_setup(struct usb_endpoint_instance *endpoint)
 {
 	usbdbg("-> Entering device setup\n");
+	dwc_otg_rx_complete((void *)Ep0Buf, 8);
 	memcpy((void *)&ep0_urb->device_request, (void *)Ep0Buf, 8);
 	memcpy((void *)&ControlData.DeviceRequest, (void *)Ep0Buf, 8);
 
@@ -965,6 +995,7 @@ static void dwc_otg_epn_rx(uint32_t len)
 			//get available size for next xfer.
 			remaining_space = urb->buffer_length - urb->actual_length;
 			usbdbg("buffer_length:%d, actual_length:%x, len:%x\n", urb->buffer_length, urb->actual_length, len);
+			dwc_otg_rx_complete((void *)urb->buffer, len);
 			if (!dwc_otg_fix_test_ready(len, (void *)urb->buffer))
 				return;
 			len = (len <= remaining_space) ? len : remaining_space;
@@ -973,7 +1004,10 @@ static void dwc_otg_epn_rx(uint32_t len)
 		usbd_rcv_complete(endpoint, len, 0);
 		remaining_space -= len;
 		//usberr("buffer_length:%x, actual_length:%x, len:%x\n", urb->buffer_length, urb->actual_length, len);
-		if (1/*remaining_space <= 0*/) {
+		if (udc_rx_refill != NULL && udc_rx_refill(urb)) {
+			urb->status = RECV_READY;
+			ReadBulkEndpoint(urb->buffer_length, (void *)urb->buffer);
+		} else if (1/*remaining_space <= 0*/) {
 			//buffer is full, so we not do another xfer here. 
 			suspend_usb();
 		} else {
@@ -23,6 +23,7 @@
 #include <malloc.h>
 #include <asm-generic/errno.h>
 #include <asm/arch/rkplat.h>
+#include <rk_task.h>
 
 #include "rk_hdmi.h"
 #include "rk3036_hdmi.h"
@@ -801,7 +802,7 @@ static int rk3036_hdmi_hardware_init(struct hdmi_dev *hdmi_dev)
 
 	rk3036_hdmi_reset_pclk();
 	rk3036_hdmi_reset(hdmi_dev);
-	mdelay(10);
+	rk_task_mdelay(10);
 
 	hdmi_dev->mode_len = 16; //1080p@60
 	hdmi_dev->read_edid = hdmi_dev_read_edid;
@@ -813,7 +814,7 @@ static int rk3036_hdmi_hardware_init(struct hdmi_dev *hdmi_dev)
 		if(hdmi_detect_hotplug(hdmi_dev) == HDMI_HPD_ACTIVED)
 		break;
 		else
-		mdelay(10);
+		rk_task_mdelay(10);
 	}
 
 	if (hdmi_detect_hotplug(hdmi_dev) == HDMI_HPD_ACTIVED) {
@@ -13,6 +13,7 @@
 #include <fdtdec.h>
 #include <fdt_support.h>
 #include <bmp_logo.h>
+#include <rk_task.h>
 #include <asm/arch/rkplat.h>
 
 #include "rockchip_fb.h"
@@ -238,28 +239,47 @@ int rk_fb_pwr_ctr_parse_dt(struct rockchip_fb *rk_fb, const void *blob)
 	return 0;
 }
 
-int rk_fb_pwr_enable(struct rockchip_fb *fb)
+/*
+ * The power sequence runs as a task: each gpio in dts order, then its
+ * delay, so the delays overlap with the hdmi/tve probe.
+ */
+static struct rk_task rk_fb_pwr_task;
+
+static ulong rk_fb_pwr_step(struct rk_task *task)
 {
+	struct rockchip_fb *fb = task->priv;
 	struct list_head *pos;
 	struct rk_fb_pwr_ctr_list *pwr_ctr_list;
 	struct pwr_ctr *pwr_ctr;
+	int i = 0;
 
-	if (list_empty(&fb->pwrlist_head))
-		return 0;
+	/* task->state is the number of entries done */
 	list_for_each(pos, &fb->pwrlist_head) {
+		if (i++ < task->state)
+			continue;
+		task->state++;
 		pwr_ctr_list = list_entry(pos, struct rk_fb_pwr_ctr_list,
 					  list);
 		pwr_ctr = &pwr_ctr_list->pwr_ctr;
 		if (pwr_ctr->type == GPIO) {
 			gpio_direction_output(pwr_ctr->gpio.gpio,
 					      pwr_ctr->atv_val);
-			mdelay(pwr_ctr->delay);
+			if (pwr_ctr->delay)
+				return pwr_ctr->delay * 1000;
 		}
 	}
 
 	return 0;
 }
 
+static void rk_fb_pwr_start(struct rockchip_fb *fb)
+{
+	rk_fb_pwr_task.name = "fb pwr";
+	rk_fb_pwr_task.step = rk_fb_pwr_step;
+	rk_fb_pwr_task.priv = fb;
+	rk_task_start(&rk_fb_pwr_task);
+}
+
 int rk_fb_pwr_disable(struct rockchip_fb *fb)
 {
 	struct list_head *pos;
@@ -455,6 +475,7 @@ void lcd_ctrl_init(void *lcdbase)
 		return;
 
 #endif
+	rk_fb_pwr_start(fb);
 
 #if defined(CONFIG_RK_HDMI)
 	rk_hdmi_probe(&panel_info);
@@ -483,7 +504,9 @@ void lcd_ctrl_init(void *lcdbase)
 #endif
 
 	panel_info.logo_rgb_mode = RGB565;
-	rk_fb_pwr_enable(fb);
+	/* the lcdc scans out of memory, not out of a write-back cache */
+	lcd_set_flush_dcache(1);
+	rk_task_wait(&rk_fb_pwr_task);
 	panel_info.real_freq = rkclk_lcdc_clk_set(panel_info.lcdc_id,
 						  panel_info.vl_freq);
 	rk_lcdc_init(panel_info.lcdc_id);
@@ -514,6 +537,13 @@ void lcd_enable(void)
 }
 
 void lcd_pandispaly(struct fb_dsp_info *info)
+{
+	lcd_sync();
+	rk_lcdc_set_par(info, &panel_info);
+}
+
+/* frame from lcd_decode_frame(), already flushed: only move the window */
+void lcd_show_frame(struct fb_dsp_info *info)
 {
 	rk_lcdc_set_par(info, &panel_info);
 }
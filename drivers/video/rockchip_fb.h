@@ -129,7 +129,6 @@ void lcd_standby(int enable);
 void rk_lcdc_standby(int enable);
 void lcd_pandispaly(struct fb_dsp_info *info);
 
-int rk_fb_pwr_enable(struct rockchip_fb *fb);
 int rk_fb_pwr_disable(struct rockchip_fb *fb);
 
 #endif /* __ROCKCHIP_H__ */
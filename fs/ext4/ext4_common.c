@@ -27,6 +27,7 @@
 #include <linux/stat.h>
 #include <linux/time.h>
 #include <asm/byteorder.h>
+#include <fs.h>
 #include "ext4_common.h"
 
 struct ext2_data *ext4fs_root;
@@ -44,6 +45,73 @@ int ext4fs_indir3_blkno = -1;
 struct ext2_inode *g_parent_inode;
 static int symlinknest;
 
+/*
+ * Extent leaf of the file being read, so a file read walks the extent
+ * tree once per leaf instead of once per block. Keyed by the extent root
+ * in the inode, dropped by ext4fs_reinit_global().
+ */
+static struct {
+	char root[sizeof(((struct ext2_inode *)0)->b)];
+	char *leaf;
+	int valid;
+} ext4fs_ext_cache;
+
+#ifdef CONFIG_FS_MOUNT_CACHE
+#define EXT4_LOOKUP_CACHE	8
+
+/*
+ * Inodes of the last files opened on the mounted fs, by path: opening
+ * one again skips the directory walk and the inode read. Dropped with
+ * the mount by ext4fs_close().
+ */
+static struct {
+	char name[64];
+	int ino;
+	struct ext2_inode inode;
+} ext4fs_lookup[EXT4_LOOKUP_CACHE];
+static int ext4fs_lookup_next;
+
+/* fs_media_gen when the fs was mounted */
+static unsigned int ext4fs_mount_gen;
+
+static struct ext2fs_node *ext4fs_lookup_find(const char *filename)
+{
+	struct ext2fs_node *node;
+	int i;
+
+	for (i = 0; i < EXT4_LOOKUP_CACHE; i++) {
+		if (ext4fs_lookup[i].name[0] != '\0' &&
+		    !strcmp(ext4fs_lookup[i].name, filename))
+			break;
+	}
+	if (i == EXT4_LOOKUP_CACHE)
+		return NULL;
+
+	node = zalloc(sizeof(struct ext2fs_node));
+	if (!node)
+		return NULL;
+	node->data = ext4fs_root;
+	node->ino = ext4fs_lookup[i].ino;
+	node->inode = ext4fs_lookup[i].inode;
+	node->inode_read = 1;
+
+	return node;
+}
+
+static void ext4fs_lookup_add(const char *filename, struct ext2fs_node *node)
+{
+	int i = ext4fs_lookup_next;
+
+	if (strlen(filename) >= sizeof(ext4fs_lookup[i].name))
+		return;
+
+	strcpy(ext4fs_lookup[i].name, filename);
+	ext4fs_lookup[i].ino = node->ino;
+	ext4fs_lookup[i].inode = node->inode;
+	ext4fs_lookup_next = (i + 1) % EXT4_LOOKUP_CACHE;
+}
+#endif
+
 #if defined(CONFIG_EXT4_WRITE)
 uint32_t ext4fs_div_roundup(uint32_t size, uint32_t n)
 {
@@ -1495,63 +1563,104 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
-long int read_allocated_block(struct ext2_inode *inode, int fileblock)
+/*
+ * Disk block of fileblock of an extent mapped inode, 0 in a hole. *count
+ * is set to the blocks that follow it on disk, or in the hole, from there.
+ */
+static long int ext4fs_map_extent(struct ext2_inode *inode, int fileblock,
+				  int *count)
 {
-	long int blknr;
-	int blksz;
-	int log2_blksz;
-	int status;
-	long int rblock;
-	long int perblock_parent;
-	long int perblock_child;
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
 	unsigned long long start;
-	/* get the blocksize of the filesystem */
-	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
-	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+	int blksz = EXT2_BLOCK_SIZE(ext4fs_root);
+	int log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
+	int entries;
+	int i = -1;
 
-	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		char *buf = zalloc(blksz);
-		if (!buf)
+	if (!ext4fs_ext_cache.leaf) {
+		ext4fs_ext_cache.leaf = zalloc(blksz);
+		if (!ext4fs_ext_cache.leaf)
 			return -ENOMEM;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i = -1;
+	}
+
+	ext_block = (struct ext4_extent_header *)ext4fs_ext_cache.leaf;
+	extent = (struct ext4_extent *)(ext_block + 1);
+	entries = le16_to_cpu(ext_block->eh_entries);
+	if (!ext4fs_ext_cache.valid ||
+	    memcmp(ext4fs_ext_cache.root, &inode->b, sizeof(inode->b)) ||
+	    !entries || fileblock < le32_to_cpu(extent[0].ee_block) ||
+	    fileblock >= le32_to_cpu(extent[entries - 1].ee_block) +
+			 le16_to_cpu(extent[entries - 1].ee_len)) {
+		/* not in the cached leaf, walk the tree down to its own */
+		ext4fs_ext_cache.valid = 0;
 		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, buf,
+			ext4fs_get_extent_block(ext4fs_root, ext4fs_ext_cache.leaf,
 						(struct ext4_extent_header *)
 						inode->b.blocks.dir_blocks,
 						fileblock, log2_blksz);
 		if (!ext_block) {
 			printf("invalid extent block\n");
-			free(buf);
 			return -EINVAL;
 		}
+		if ((char *)ext_block != ext4fs_ext_cache.leaf)
+			memcpy(ext4fs_ext_cache.leaf, ext_block, sizeof(inode->b));
+		memcpy(ext4fs_ext_cache.root, &inode->b, sizeof(inode->b));
+		ext4fs_ext_cache.valid = 1;
 
+		ext_block = (struct ext4_extent_header *)ext4fs_ext_cache.leaf;
 		extent = (struct ext4_extent *)(ext_block + 1);
+		entries = le16_to_cpu(ext_block->eh_entries);
+	}
 
-		do {
-			i++;
-			if (i >= le16_to_cpu(ext_block->eh_entries))
-				break;
-		} while (fileblock >= le32_to_cpu(extent[i].ee_block));
-		if (--i >= 0) {
-			fileblock -= le32_to_cpu(extent[i].ee_block);
-			if (fileblock >= le16_to_cpu(extent[i].ee_len)) {
-				free(buf);
-				return 0;
-			}
-
-			start = le16_to_cpu(extent[i].ee_start_hi);
-			start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-			free(buf);
-			return fileblock + start;
+	do {
+		i++;
+		if (i >= entries)
+			break;
+	} while (fileblock >= le32_to_cpu(extent[i].ee_block));
+	if (--i >= 0) {
+		fileblock -= le32_to_cpu(extent[i].ee_block);
+		if (fileblock >= le16_to_cpu(extent[i].ee_len)) {
+			/* hole up to the next extent */
+			if (i + 1 < entries)
+				*count = le32_to_cpu(extent[i + 1].ee_block) -
+					 le32_to_cpu(extent[i].ee_block) -
+					 fileblock;
+			else
+				*count = 1;
+			return 0;
 		}
 
-		printf("Extent Error\n");
-		free(buf);
-		return -1;
+		start = le16_to_cpu(extent[i].ee_start_hi);
+		start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+		*count = le16_to_cpu(extent[i].ee_len) - fileblock;
+		return fileblock + start;
+	}
+
+	printf("Extent Error\n");
+	return -1;
+}
+
+long int read_allocated_block(struct ext2_inode *inode, int fileblock)
+{
+	long int blknr;
+	int blksz;
+	int log2_blksz;
+	int status;
+	long int rblock;
+	long int perblock_parent;
+	long int perblock_child;
+	/* get the blocksize of the filesystem */
+	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+		- get_fs()->dev_desc->log2blksz;
+
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
+		int count;
+
+		return ext4fs_map_extent(inode, fileblock, &count);
 	}
 
 	/* Direct blocks. */
@@ -1839,6 +1948,21 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	return blknr;
 }
 
+/*
+ * read_allocated_block() of fileblock, with *count set to the blocks that
+ * follow it contiguously on disk (or in the hole) so a reader can take
+ * them in one go. Only extents map more than one block at a time.
+ */
+long int read_allocated_run(struct ext2_inode *inode, int fileblock,
+			    int *count)
+{
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)
+		return ext4fs_map_extent(inode, fileblock, count);
+
+	*count = 1;
+	return read_allocated_block(inode, fileblock);
+}
+
 /**
  * ext4fs_reinit_global() - Reinitialize values of ext4 write implementation's
  *			    global pointers
@@ -1871,6 +1995,11 @@ void ext4fs_reinit_global(void)
 		ext4fs_indir3_size = 0;
 		ext4fs_indir3_blkno = -1;
 	}
+	if (ext4fs_ext_cache.leaf != NULL) {
+		free(ext4fs_ext_cache.leaf);
+		ext4fs_ext_cache.leaf = NULL;
+		ext4fs_ext_cache.valid = 0;
+	}
 }
 void ext4fs_close(void)
 {
@@ -1882,6 +2011,10 @@ void ext4fs_close(void)
 		free(ext4fs_root);
 		ext4fs_root = NULL;
 	}
+#ifdef CONFIG_FS_MOUNT_CACHE
+	memset(ext4fs_lookup, 0, sizeof(ext4fs_lookup));
+	ext4fs_lookup_next = 0;
+#endif
 
 	ext4fs_reinit_global();
 }
@@ -2178,7 +2311,15 @@ int ext4fs_open(const char *filename)
 	if (ext4fs_root == NULL)
 		return -1;
 
+	/* the fs may stay mounted from one command to the next */
+	if (ext4fs_file != NULL)
+		ext4fs_free_node(ext4fs_file, &ext4fs_root->diropen);
 	ext4fs_file = NULL;
+#ifdef CONFIG_FS_MOUNT_CACHE
+	fdiro = ext4fs_lookup_find(filename);
+	if (fdiro != NULL)
+		goto found;
+#endif
 	status = ext4fs_find_file(filename, &ext4fs_root->diropen, &fdiro,
 				  FILETYPE_REG);
 	if (status == 0)
@@ -2190,6 +2331,10 @@ int ext4fs_open(const char *filename)
 		if (status == 0)
 			goto fail;
 	}
+#ifdef CONFIG_FS_MOUNT_CACHE
+	ext4fs_lookup_add(filename, fdiro);
+found:
+#endif
 	len = __le32_to_cpu(fdiro->inode.size);
 	ext4fs_file = fdiro;
 
@@ -2205,6 +2350,13 @@ int ext4fs_mount(unsigned part_length)
 	struct ext2_data *data;
 	int status;
 	struct ext_filesystem *fs = get_fs();
+
+	/* drop the mount a former command left */
+	ext4fs_close();
+#ifdef CONFIG_FS_MOUNT_CACHE
+	ext4fs_mount_gen = fs_media_gen;
+#endif
+
 	data = zalloc(SUPERBLOCK_SIZE);
 	if (!data)
 		return 0;
@@ -2246,3 +2398,35 @@ fail:
 
 	return 0;
 }
+
+#ifdef CONFIG_FS_MOUNT_CACHE
+/*
+ * Whether the fs a former command mounted is still the one on this
+ * partition: same device and offset, no raw write or rescan since and
+ * the same superblock on the disk.
+ */
+int ext4fs_mounted(block_dev_desc_t *dev_desc, disk_partition_t *info)
+{
+	struct ext_filesystem *fs = get_fs();
+	struct ext2_sblock *sblock;
+	int ret = 0;
+
+	if (ext4fs_root == NULL || ext4fs_mount_gen != fs_media_gen ||
+	    fs->dev_desc != dev_desc ||
+	    part_offset != info->start || fs->total_sect !=
+	    (((uint64_t)info->size * info->blksz) >> dev_desc->log2blksz))
+		return 0;
+
+	sblock = zalloc(SUPERBLOCK_SIZE);
+	if (!sblock)
+		return 0;
+
+	ext4fs_set_blk_dev(dev_desc, info);
+	if (ext4_read_superblock((char *)sblock))
+		ret = !memcmp(sblock, &ext4fs_root->sblock,
+			      sizeof(struct ext2_sblock));
+	free(sblock);
+
+	return ret;
+}
+#endif
@@ -49,7 +49,7 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 		unsigned int len, char *buf)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
+	int i, run;
 	lbaint_t blockcnt;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
@@ -69,24 +69,29 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 
 	blockcnt = ((len + pos) + blocksize - 1) / blocksize;
 
-	for (i = pos / blocksize; i < blockcnt; i++) {
+	/* a run of blocks contiguous on disk (or a hole) at a time */
+	for (i = pos / blocksize; i < blockcnt; i += run) {
 		lbaint_t blknr;
 		int blockoff = pos % blocksize;
-		int blockend = blocksize;
+		int blockend;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
+		blknr = read_allocated_run(&(node->inode), i, &run);
 		if (blknr < 0)
 			return -1;
+		/* a bad count maps one block, the next lookup goes on */
+		if (run < 1)
+			run = 1;
+		else if (run > blockcnt - i)
+			run = blockcnt - i;
+		blockend = run * blocksize;
 
 		blknr = blknr << log2_fs_blocksize;
 
 		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) % blocksize;
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
+		if (i + run == blockcnt) {
+			/* The last portion may be short of blocksize. */
+			if ((len + pos) % blocksize)
+				blockend -= blocksize - (len + pos) % blocksize;
 		}
 
 		/* First block. */
@@ -114,7 +119,7 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 					delayed_skipfirst = skipfirst;
 					delayed_buf = buf;
 					delayed_next = blknr +
-						(blockend >> log2blksz);
+						((skipfirst + blockend) >> log2blksz);
 				}
 			} else {
 				previous_block_number = blknr;
@@ -123,7 +128,7 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 				delayed_skipfirst = skipfirst;
 				delayed_buf = buf;
 				delayed_next = blknr +
-					(blockend >> log2blksz);
+					((skipfirst + blockend) >> log2blksz);
 			}
 		} else {
 			if (previous_block_number != -1) {
@@ -136,9 +141,9 @@ int ext4fs_read_file(struct ext2fs_node *node, int pos,
 					return -1;
 				previous_block_number = -1;
 			}
-			memset(buf, 0, blocksize - skipfirst);
+			memset(buf, 0, blockend);
 		}
-		buf += blocksize - skipfirst;
+		buf += blockend;
 	}
 	if (previous_block_number != -1) {
 		/* spill */
@@ -198,6 +203,11 @@ int ext4fs_read(char *buf, unsigned len)
 int ext4fs_probe(block_dev_desc_t *fs_dev_desc,
 		 disk_partition_t *fs_partition)
 {
+#ifdef CONFIG_FS_MOUNT_CACHE
+	/* still mounted from the last command on this partition */
+	if (ext4fs_mounted(fs_dev_desc, fs_partition))
+		return 0;
+#endif
 	ext4fs_set_blk_dev(fs_dev_desc, fs_partition);
 
 	if (!ext4fs_mount(fs_partition->size)) {
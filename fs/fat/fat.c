@@ -18,6 +18,7 @@
 #include <malloc.h>
 #include <linux/compiler.h>
 #include <linux/ctype.h>
+#include <fs.h>
 
 #ifdef CONFIG_SUPPORT_VFAT
 static const int vfat_enabled = 1;
@@ -43,6 +44,60 @@ static disk_partition_t cur_part_info;
 #define DOS_FS_TYPE_OFFSET	0x36
 #define DOS_FS32_TYPE_OFFSET	0x52
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+#define FAT_LOOKUP_CACHE	8
+
+/*
+ * Mount state kept from one command to the next on the same partition:
+ * the parsed boot sector with the FAT window in its fatbuf, and the
+ * directory entries of the last files looked up. fat_set_blk_dev()
+ * drops it when the partition or its boot sector changes, or the media
+ * was written or rescanned since (fs_media_gen), the FAT writer before
+ * it writes.
+ */
+struct fat_lookup {
+	char name[64];
+	dir_entry dent;
+};
+
+static struct {
+	int valid;
+	fsdata data;
+	__u32 root_cluster;
+	int rootdir_size;
+	__u8 bootsect[sizeof(boot_sector) + sizeof(volume_info)];
+	unsigned int media_gen;
+	struct fat_lookup lookup[FAT_LOOKUP_CACHE];
+	int lookup_next;
+} fat_mount;
+
+static dir_entry *fat_lookup_find(const char *name)
+{
+	int i;
+
+	for (i = 0; i < FAT_LOOKUP_CACHE; i++) {
+		if (fat_mount.lookup[i].name[0] != '\0' &&
+		    !strcmp(fat_mount.lookup[i].name, name))
+			return &fat_mount.lookup[i].dent;
+	}
+
+	return NULL;
+}
+
+static void fat_lookup_add(const char *name, dir_entry *dent)
+{
+	struct fat_lookup *l = &fat_mount.lookup[fat_mount.lookup_next];
+
+	if (strlen(name) >= sizeof(l->name))
+		return;
+
+	strcpy(l->name, name);
+	downcase(l->name);
+	l->dent = *dent;
+	fat_mount.lookup_next = (fat_mount.lookup_next + 1) % FAT_LOOKUP_CACHE;
+}
+#endif
+
 static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 {
 	if (!cur_dev || !cur_dev->block_read)
@@ -55,6 +110,11 @@ static int disk_read(__u32 block, __u32 nr_blocks, void *buf)
 int fat_set_blk_dev(block_dev_desc_t *dev_desc, disk_partition_t *info)
 {
 	ALLOC_CACHE_ALIGN_BUFFER(unsigned char, buffer, dev_desc->blksz);
+#ifdef CONFIG_FS_MOUNT_CACHE
+	int same = cur_dev == dev_desc &&
+		   cur_part_info.start == info->start &&
+		   cur_part_info.size == info->size;
+#endif
 
 	cur_dev = dev_desc;
 	cur_part_info = *info;
@@ -65,6 +125,16 @@ int fat_set_blk_dev(block_dev_desc_t *dev_desc, disk_partition_t *info)
 		return -1;
 	}
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+	/* the mount only holds for the same partition, boot sector and media */
+	if (!same || fat_mount.media_gen != fs_media_gen ||
+	    memcmp(buffer, fat_mount.bootsect, sizeof(fat_mount.bootsect))) {
+		fat_close();
+		memcpy(fat_mount.bootsect, buffer, sizeof(fat_mount.bootsect));
+		fat_mount.media_gen = fs_media_gen;
+	}
+#endif
+
 	/* Check if it's actually a DOS volume */
 	if (memcmp(buffer + DOS_BOOT_MAGIC_OFFSET, "\x55\xAA", 2)) {
 		cur_dev = NULL;
@@ -160,6 +230,7 @@ static void get_name(dir_entry *dirent, char *s_name)
  */
 static __u32 get_fatent(fsdata *mydata, __u32 entry)
 {
+	__u32 bufsize = mydata->fatbufblocks * mydata->sect_size;
 	__u32 bufnum;
 	__u32 off16, offset;
 	__u32 ret = 0x00;
@@ -167,16 +238,16 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 
 	switch (mydata->fatsize) {
 	case 32:
-		bufnum = entry / FAT32BUFSIZE;
-		offset = entry - bufnum * FAT32BUFSIZE;
+		bufnum = entry / (bufsize / 4);
+		offset = entry - bufnum * (bufsize / 4);
 		break;
 	case 16:
-		bufnum = entry / FAT16BUFSIZE;
-		offset = entry - bufnum * FAT16BUFSIZE;
+		bufnum = entry / (bufsize / 2);
+		offset = entry - bufnum * (bufsize / 2);
 		break;
 	case 12:
-		bufnum = entry / FAT12BUFSIZE;
-		offset = entry - bufnum * FAT12BUFSIZE;
+		bufnum = entry / ((bufsize * 2) / 3);
+		offset = entry - bufnum * ((bufsize * 2) / 3);
 		break;
 
 	default:
@@ -189,10 +260,10 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 
 	/* Read a new block of FAT entries into the cache. */
 	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
+		__u32 getsize = mydata->fatbufblocks;
 		__u8 *bufptr = mydata->fatbuf;
 		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
+		__u32 startblock = bufnum * mydata->fatbufblocks;
 
 		if (startblock + getsize > fatlength)
 			getsize = fatlength - startblock;
@@ -251,6 +322,9 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	return ret;
 }
 
+__u8 get_contents_vfatname_block[MAX_CLUSTSIZE]
+	__aligned(ARCH_DMA_MINALIGN);
+
 /*
  * Read at most 'size' bytes from the specified cluster into 'buffer'.
  * Return 0 on success, -1 otherwise.
@@ -272,20 +346,25 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	debug("gc - clustnum: %d, startsect: %d\n", clustnum, startsect);
 
 	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
-		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
 
 		printf("FAT: Misaligned buffer address (%p)\n", buffer);
 
+		/* bounce whole runs, the caller's buffer is never this one */
 		while (size >= mydata->sect_size) {
-			ret = disk_read(startsect++, 1, tmpbuf);
-			if (ret != 1) {
+			idx = min(size, (unsigned long)MAX_CLUSTSIZE) /
+			      mydata->sect_size;
+			ret = disk_read(startsect, idx,
+					get_contents_vfatname_block);
+			if (ret != idx) {
 				debug("Error reading data (got %d)\n", ret);
 				return -1;
 			}
 
-			memcpy(buffer, tmpbuf, mydata->sect_size);
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
+			startsect += idx;
+			idx *= mydata->sect_size;
+			memcpy(buffer, get_contents_vfatname_block, idx);
+			buffer += idx;
+			size -= idx;
 		}
 	} else {
 		idx = size / mydata->sect_size;
@@ -319,8 +398,6 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
  * into 'buffer'.
  * Return the number of bytes read or -1 on fatal errors.
  */
-__u8 get_contents_vfatname_block[MAX_CLUSTSIZE]
-	__aligned(ARCH_DMA_MINALIGN);
 
 static long
 get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
@@ -330,6 +407,7 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
 	__u32 endclust, newclust;
+	__u32 clustidx = 0;
 	unsigned long actsize;
 
 	debug("Filesize: %ld bytes\n", filesize);
@@ -344,21 +422,30 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 
 	debug("%ld bytes\n", filesize);
 
-	actsize = bytesperclust;
-
-	/* go to cluster at pos */
-	while (actsize <= pos) {
+	/*
+	 * go to cluster at pos, from where the last read of the file ended
+	 * when that is on the way: reading a big file in pieces then walks
+	 * its chain once
+	 */
+	if (curclust != 0 && mydata->run_start == curclust &&
+	    mydata->run_idx <= pos / bytesperclust) {
+		curclust = mydata->run_clust;
+		clustidx = mydata->run_idx;
+	}
+	while (clustidx < pos / bytesperclust) {
 		curclust = get_fatent(mydata, curclust);
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
 			debug("curclust: 0x%x\n", curclust);
 			debug("Invalid FAT entry\n");
 			return gotsize;
 		}
-		actsize += bytesperclust;
+		clustidx++;
 	}
+	mydata->run_start = START(dentptr);
+	mydata->run_clust = curclust;
+	mydata->run_idx = clustidx;
 
-	/* actsize > pos */
-	actsize -= bytesperclust;
+	actsize = (unsigned long)clustidx * bytesperclust;
 	filesize -= actsize;
 	pos -= actsize;
 
@@ -384,6 +471,7 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 			debug("Invalid FAT entry\n");
 			return gotsize;
 		}
+		clustidx++;
 	}
 
 	actsize = bytesperclust;
@@ -411,6 +499,8 @@ get_contents(fsdata *mydata, dir_entry *dentptr, unsigned long pos,
 			return -1;
 		}
 		gotsize += actsize;
+		mydata->run_clust = endclust;
+		mydata->run_idx = clustidx + (actsize - 1) / bytesperclust;
 		return gotsize;
 getit:
 		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
@@ -420,6 +510,9 @@ getit:
 		gotsize += (int)actsize;
 		filesize -= actsize;
 		buffer += actsize;
+		clustidx += actsize / bytesperclust;
+		mydata->run_clust = endclust;
+		mydata->run_idx = clustidx - 1;
 
 		curclust = get_fatent(mydata, endclust);
 		if (CHECK_CLUST(curclust, mydata->fatsize)) {
@@ -803,29 +896,14 @@ exit:
 	return ret;
 }
 
-__u8 do_fat_read_at_block[MAX_CLUSTSIZE]
-	__aligned(ARCH_DMA_MINALIGN);
-
-long
-do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
-	       unsigned long maxsize, int dols, int dogetsize)
+/*
+ * Parse the boot sector into mydata and get it a FAT window buffer
+ */
+static int
+fat_mount_fs(fsdata *mydata, __u32 *root_cluster, int *rootdir_size)
 {
-	char fnamecopy[2048];
 	boot_sector bs;
 	volume_info volinfo;
-	fsdata datablock;
-	fsdata *mydata = &datablock;
-	dir_entry *dentptr = NULL;
-	__u16 prevcksum = 0xffff;
-	char *subname = "";
-	__u32 cursect;
-	int idx, isdir = 0;
-	int files = 0, dirs = 0;
-	long ret = -1;
-	int firsttime;
-	__u32 root_cluster = 0;
-	int rootdir_size = 0;
-	int j;
 
 	if (read_bootsectandvi(&bs, &volinfo, &mydata->fatsize)) {
 		debug("Error: reading boot sector\n");
@@ -833,16 +911,16 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	}
 
 	if (mydata->fatsize == 32) {
-		root_cluster = bs.root_cluster;
+		*root_cluster = bs.root_cluster;
 		mydata->fatlength = bs.fat32_length;
 	} else {
+		*root_cluster = 0;
 		mydata->fatlength = bs.fat_length;
 	}
 
 	mydata->fat_sect = bs.reserved;
 
-	cursect = mydata->rootdir_sect
-		= mydata->fat_sect + mydata->fatlength * bs.fats;
+	mydata->rootdir_sect = mydata->fat_sect + mydata->fatlength * bs.fats;
 
 	mydata->sect_size = (bs.sector_size[1] << 8) + bs.sector_size[0];
 	mydata->clust_size = bs.cluster_size;
@@ -853,24 +931,83 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	}
 
 	if (mydata->fatsize == 32) {
+		*rootdir_size = 0;
 		mydata->data_begin = mydata->rootdir_sect -
 					(mydata->clust_size * 2);
 	} else {
-		rootdir_size = ((bs.dir_entries[1]  * (int)256 +
-				 bs.dir_entries[0]) *
-				 sizeof(dir_entry)) /
-				 mydata->sect_size;
+		*rootdir_size = ((bs.dir_entries[1]  * (int)256 +
+				  bs.dir_entries[0]) *
+				  sizeof(dir_entry)) /
+				  mydata->sect_size;
 		mydata->data_begin = mydata->rootdir_sect +
-					rootdir_size -
+					*rootdir_size -
 					(mydata->clust_size * 2);
 	}
 
+	/*
+	 * A large window keeps the FAT of a big or fragmented file in
+	 * memory, FAT12 entries straddle sectors so it takes the whole FAT.
+	 */
+	mydata->fatbufblocks = CONFIG_FS_FAT_WINDOW_SIZE / mydata->sect_size;
+	if (mydata->fatbufblocks < FATBUFBLOCKS)
+		mydata->fatbufblocks = FATBUFBLOCKS;
+	if (mydata->fatbufblocks > mydata->fatlength ||
+	    mydata->fatsize == 12)
+		mydata->fatbufblocks = mydata->fatlength;
+
 	mydata->fatbufnum = -1;
-	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
+	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN,
+				  mydata->fatbufblocks * mydata->sect_size);
+	if (mydata->fatbuf == NULL && mydata->fatbufblocks > FATBUFBLOCKS) {
+		mydata->fatbufblocks = FATBUFBLOCKS;
+		mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
+	}
 	if (mydata->fatbuf == NULL) {
 		debug("Error: allocating memory\n");
 		return -1;
 	}
+	mydata->run_start = 0;
+
+	return 0;
+}
+
+__u8 do_fat_read_at_block[MAX_CLUSTSIZE]
+	__aligned(ARCH_DMA_MINALIGN);
+
+long
+do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
+	       unsigned long maxsize, int dols, int dogetsize)
+{
+	char fnamecopy[2048];
+	fsdata datablock;
+	fsdata *mydata = &datablock;
+	dir_entry *dentptr = NULL;
+	__u16 prevcksum = 0xffff;
+	char *subname = "";
+	__u32 cursect;
+	int idx, isdir = 0;
+	int files = 0, dirs = 0;
+	long ret = -1;
+	int firsttime;
+	__u32 root_cluster = 0;
+	int rootdir_size = 0;
+	int j;
+
+#ifdef CONFIG_FS_MOUNT_CACHE
+	mydata = &fat_mount.data;
+	if (!fat_mount.valid) {
+		if (fat_mount_fs(mydata, &fat_mount.root_cluster,
+				 &fat_mount.rootdir_size))
+			return -1;
+		fat_mount.valid = 1;
+	}
+	root_cluster = fat_mount.root_cluster;
+	rootdir_size = fat_mount.rootdir_size;
+#else
+	if (fat_mount_fs(mydata, &root_cluster, &rootdir_size))
+		return -1;
+#endif
+	cursect = mydata->rootdir_sect;
 
 	if (vfat_enabled)
 		debug("VFAT Support enabled\n");
@@ -893,6 +1030,11 @@ do_fat_read_at(const char *filename, unsigned long pos, void *buffer,
 	strcpy(fnamecopy, filename);
 	downcase(fnamecopy);
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+	if (!dols && (dentptr = fat_lookup_find(fnamecopy)) != NULL)
+		goto found;
+#endif
+
 	if (*fnamecopy == '\0') {
 		if (!dols)
 			goto exit;
@@ -1152,6 +1294,11 @@ rootdir_done:
 			subname = nextname;
 	}
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+	if (!dols && !(dentptr->attr & ATTR_DIR))
+		fat_lookup_add(filename, dentptr);
+found:
+#endif
 	if (dogetsize)
 		ret = FAT2CPU32(dentptr->size);
 	else
@@ -1159,7 +1306,9 @@ rootdir_done:
 	debug("Size: %d, got: %ld\n", FAT2CPU32(dentptr->size), ret);
 
 exit:
+#ifndef CONFIG_FS_MOUNT_CACHE
 	free(mydata->fatbuf);
+#endif
 	return ret;
 }
 
@@ -1275,4 +1424,11 @@ int fat_read_file(const char *filename, void *buf, int offset, int len)
 
 void fat_close(void)
 {
+#ifdef CONFIG_FS_MOUNT_CACHE
+	if (fat_mount.valid)
+		free(fat_mount.data.fatbuf);
+	fat_mount.valid = 0;
+	memset(fat_mount.lookup, 0, sizeof(fat_mount.lookup));
+	fat_mount.lookup_next = 0;
+#endif
 }
@@ -979,6 +979,7 @@ static int do_fat_write(const char *filename, void *buffer,
 	}
 
 	mydata->fatbufnum = -1;
+	mydata->fatbufblocks = FATBUFBLOCKS;
 	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
 	if (mydata->fatbuf == NULL) {
 		debug("Error: allocating memory\n");
@@ -1102,5 +1103,9 @@ exit:
 int file_fat_write(const char *filename, void *buffer, unsigned long maxsize)
 {
 	printf("writing %s\n", filename);
+#ifdef CONFIG_FS_MOUNT_CACHE
+	/* the cached FAT window and lookups go stale with the write */
+	fat_close();
+#endif
 	return do_fat_write(filename, buffer, maxsize);
 }
@@ -155,6 +155,36 @@ static struct fstype_info *fs_get_info(int fstype)
 	return info;
 }
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+/*
+ * The fs of the last command stays mounted on its partition. The next
+ * command there probes that fs first, so a script loading several files
+ * pays for the mount once. The probe keeps the mount unless the fs sees
+ * another boot sector or superblock, or fs_media_gen moved on since the
+ * mount: a raw write, erase or rescan of a block device. A write through
+ * the fs or another partition unmounts it.
+ */
+unsigned int fs_media_gen;
+
+void fs_invalidate_mounts(void)
+{
+	fs_media_gen++;
+}
+
+static block_dev_desc_t *fs_mount_dev;
+static disk_partition_t fs_mount_part;
+static int fs_mount_type = FS_TYPE_ANY;
+
+static void fs_umount(void)
+{
+	struct fstype_info *info = fs_get_info(fs_mount_type);
+
+	info->close();
+
+	fs_mount_type = FS_TYPE_ANY;
+}
+#endif
+
 int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 {
 	struct fstype_info *info;
@@ -180,6 +210,21 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 	if (part < 0)
 		return -1;
 
+#ifdef CONFIG_FS_MOUNT_CACHE
+	if (fs_mount_type != FS_TYPE_ANY) {
+		info = fs_get_info(fs_mount_type);
+		if (fs_dev_desc == fs_mount_dev &&
+		    fs_partition.start == fs_mount_part.start &&
+		    fs_partition.size == fs_mount_part.size &&
+		    (fstype == FS_TYPE_ANY || fstype == fs_mount_type) &&
+		    !info->probe(fs_dev_desc, &fs_partition)) {
+			fs_type = fs_mount_type;
+			return 0;
+		}
+		fs_umount();
+	}
+#endif
+
 	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
 		if (fstype != FS_TYPE_ANY && info->fstype != FS_TYPE_ANY &&
 				fstype != info->fstype)
@@ -190,6 +235,11 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 
 		if (!info->probe(fs_dev_desc, &fs_partition)) {
 			fs_type = info->fstype;
+#ifdef CONFIG_FS_MOUNT_CACHE
+			fs_mount_dev = fs_dev_desc;
+			fs_mount_part = fs_partition;
+			fs_mount_type = fs_type;
+#endif
 			return 0;
 		}
 	}
@@ -199,9 +249,11 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 
 static void fs_close(void)
 {
+#ifndef CONFIG_FS_MOUNT_CACHE
 	struct fstype_info *info = fs_get_info(fs_type);
 
 	info->close();
+#endif
 
 	fs_type = FS_TYPE_ANY;
 }
@@ -285,6 +337,9 @@ int fs_write(const char *filename, ulong addr, int offset, int len)
 		ret = -1;
 	}
 	fs_close();
+#ifdef CONFIG_FS_MOUNT_CACHE
+	fs_umount();
+#endif
 
 	return ret;
 }
@@ -16,6 +16,9 @@
 #define CONFIG_BOOTSTAGE_USER_COUNT	20
 #endif
 
+/* Room for bootstage_summary() */
+#define BOOTSTAGE_SUMMARY_LEN	256
+
 /* Flags for each bootstage record */
 enum bootstage_flags {
 	BOOTSTAGEF_ERROR	= 1 << 0,	/* Error record */
@@ -191,6 +194,12 @@ enum bootstage_id {
 	BOOTSTAGE_ID_MAIN_CPU_READY,
 
 	BOOTSTAGE_ID_ACCUM_LCD,
+	BOOTSTAGE_ID_ACCUM_PMIC,
+	BOOTSTAGE_ID_ACCUM_FDT,
+	BOOTSTAGE_ID_ACCUM_PREBOOT,
+	BOOTSTAGE_ID_ACCUM_LOAD,
+	BOOTSTAGE_ID_ACCUM_LOGO,
+	BOOTSTAGE_ID_ACCUM_SECURE_CHECK,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -291,9 +300,32 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name);
  */
 uint32_t bootstage_accum(enum bootstage_id id);
 
+/**
+ * Count bytes moved by an activity timed with bootstage_start/accum()
+ *
+ * The report then shows the amount and the throughput of that activity.
+ *
+ * @param id	Bootstage id of the activity
+ * @param bytes	Number of bytes to add to its count
+ */
+void bootstage_add_bytes(enum bootstage_id id, ulong bytes);
+
 /* Print a report about boot time */
 void bootstage_report(void);
 
+/**
+ * Write a one line summary of boot time, for the kernel
+ *
+ * The summary is "total:<us>" at the time of the call, followed by
+ * ",<name>:<us>" for each accumulated activity, with ":<bytes>:<KiB/s>"
+ * added to activities which counted bytes. There are no spaces in it.
+ *
+ * @param buf	Buffer for the summary
+ * @param size	Size of buffer, BOOTSTAGE_SUMMARY_LEN is enough in general
+ * @return length of summary, or -1 if it did not fit
+ */
+int bootstage_summary(char *buf, int size);
+
 /**
  * Add bootstage information to the device tree
  *
@@ -373,6 +405,15 @@ static inline uint32_t bootstage_accum(enum bootstage_id id)
 	return 0;
 }
 
+static inline void bootstage_add_bytes(enum bootstage_id id, ulong bytes)
+{
+}
+
+static inline int bootstage_summary(char *buf, int size)
+{
+	return -1;
+}
+
 static inline int bootstage_stash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
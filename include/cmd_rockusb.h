@@ -46,6 +46,7 @@
 #define	K_FW_READ_FLASH_INFO		0x1A
 #define	K_FW_GET_CHIP_VER		0x1B
 #define	K_FW_LOW_FORMAT			0x1C
+#define	K_FW_GET_STATS			0x1D
 #define	K_FW_SET_RESET_FLAG		0x1E
 #define	K_FW_SPI_READ_10		0x21  
 #define	K_FW_SPI_WRITE_10		0x22  
@@ -95,6 +96,15 @@
  */
 #define RKUSB_BUFFER_BLOCK_MAX 0x80//0x20
 
+/*
+ * Download queue depth, in slots of RKUSB_RX_SLOT_SIZE. 528 byte pages
+ * go in 124 page transfers to fit a slot.
+ */
+#ifndef CONFIG_ROCKUSB_RX_QUEUE
+#define CONFIG_ROCKUSB_RX_QUEUE	2
+#endif
+#define RKUSB_RX_SLOT_SIZE	(RKUSB_BUFFER_BLOCK_MAX * 512)
+
 #define	USB_DEVICE_CLASS_VENDOR_SPECIFIC	0xFF
 #define	USB_SUBCLASS_CODE_SCSI			0x06
 
@@ -286,13 +296,49 @@ struct cmd_rockusb_preread {
 	uint32_t pre_lba;
 	uint32_t pre_blocks;
 };
+
+/* K_FW_GET_STATS reply, little endian words counted since the last query */
+struct cmd_rockusb_stats {
+	uint32_t usb_bytes;	/* received by the write commands */
+	uint32_t usb_us;	/* their data phases, stalls included */
+	uint32_t media_bytes;	/* programmed */
+	uint32_t media_us;	/* in the storage writes */
+	uint32_t stall_us;	/* usb held off on a full queue */
+	uint32_t media_writes;	/* storage requests */
+	uint32_t media_errors;	/* of them failed */
+};
+
+struct cmd_rockusb_rxslot {
+	uint32_t lba;
+	uint32_t len;
+	uint32_t cmnd;
+	uint32_t imgwr_mode;
+};
+
+/*
+ * Download queue: the udc irq queues each received transfer and starts
+ * the next one into a free slot, while the main loop programs the queued
+ * slots in order. The endpoint naks once every slot is full. Slots are
+ * counted by head and tail, slot n is slot[n % CONFIG_ROCKUSB_RX_QUEUE].
+ */
+struct cmd_rockusb_rxqueue {
+	struct cmd_rockusb_rxslot slot[CONFIG_ROCKUSB_RX_QUEUE];
+	volatile uint32_t head;		/* next slot the usb fills, irq */
+	volatile uint32_t tail;		/* next slot to program, main loop */
+	volatile int stalled;		/* set by the irq, the usb waits on a slot */
+	int failed;			/* a write of this download failed */
+	int usb_done;			/* all of the download is in the queue */
+	ulong stall_start;
+	ulong usb_start;
+	struct cmd_rockusb_stats stats;
+};
+
 struct cmd_rockusb_interface {
 	uint8_t cmd;
 	uint8_t status;
 	unsigned int configured;
-	uint8_t *rx_buffer[2];
+	uint8_t *rx_buffer;
 	uint8_t *tx_buffer[2];
-	uint8_t rxbuf_num;
 	uint8_t txbuf_num;
    
 	/* 
@@ -301,8 +347,8 @@ struct cmd_rockusb_interface {
 	 */
 	uint32_t d_size;
 
-	/* Data downloaded so far */
-	uint32_t d_bytes;
+	/* Data downloaded so far, counted by the usb irq */
+	volatile uint32_t d_bytes;
 
 	/* Download status, < 0 when error, > 0 when complete */
 	uint32_t d_status;
@@ -328,6 +374,7 @@ struct cmd_rockusb_interface {
 	struct bulk_cs_wrap csw __attribute__((aligned(ARCH_DMA_MINALIGN)));
 	struct fsg_bulk_cb_wrap cbw __attribute__((aligned(ARCH_DMA_MINALIGN)));
 	struct cmd_rockusb_preread pre_read __attribute__((aligned(ARCH_DMA_MINALIGN)));
+	struct cmd_rockusb_rxqueue rxq;
 };
 
 /* Declare functions */
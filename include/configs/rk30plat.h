@@ -54,6 +54,13 @@
 	#undef CONFIG_RK_UMS_BOOT_EN
 #endif /* CONFIG_RKCHIP_RK3128 */
 
+/* sha1/sha256 of the hash_algo table on the crypto engine, software when it can't */
+#ifdef CONFIG_SECUREBOOT_CRYPTO
+	#define CONFIG_SHA_HW_ACCEL
+	#define CONFIG_SHA1
+	#define CONFIG_SHA256
+#endif
+
 
 /* mod it to enable console commands.	*/
 #define CONFIG_BOOTDELAY		1
@@ -43,6 +43,16 @@
 	#undef CONFIG_RK_UMS_BOOT_EN
 	#undef CONFIG_RK_PL330
 	#undef CONFIG_RK_DMAC
+	#undef CONFIG_RK_DMA_MEMCPY
+	/* cores are brought up through the pmu power domains here */
+	#undef CONFIG_RK_SMP
+#endif
+
+/* sha1/sha256 of the hash_algo table on the crypto engine, software when it can't */
+#ifdef CONFIG_SECUREBOOT_CRYPTO
+	#define CONFIG_SHA_HW_ACCEL
+	#define CONFIG_SHA1
+	#define CONFIG_SHA256
 #endif
 
 /* mod it to enable console commands.	*/
@@ -52,6 +62,16 @@
 #define CONFIG_RK_MMC_DMA
 #define CONFIG_RK_MMC_IDMAC	/* internal dmac */
 
+/*
+ * emmc bus timing above high speed on rk3288: HS200 with tuned sample phase,
+ * else DDR52. HS200 needs the emmc io at 1.8V, boards that wire vccq so
+ * define CONFIG_RK_EMMC_IO_1V8.
+ */
+#if defined(CONFIG_RKCHIP_RK3288)
+#define CONFIG_RK_EMMC_HS200
+#define CONFIG_RK_EMMC_DDR52
+#endif
+
 
 /* more config for rockusb */
 #ifdef CONFIG_CMD_ROCKUSB
@@ -88,8 +88,13 @@
 	#undef CONFIG_RK_UMS_BOOT_EN
 	#undef CONFIG_RK_PL330
 	#undef CONFIG_RK_DMAC
+	#undef CONFIG_RK_DMA_MEMCPY
 #endif
 
+/* the task scheduler and smp workers live in the armv7 rk32xx code */
+#undef CONFIG_RK_TASK
+#undef CONFIG_RK_SMP
+
 /* fpga board configure */
 #ifdef CONFIG_FPGA_BOARD
 	#define CONFIG_BOARD_DEMO
@@ -129,6 +134,13 @@
 #define CONFIG_SECURE_RSA_KEY_ADDR	(CONFIG_RKNAND_API_ADDR + SZ_2K)
 #endif /* CONFIG_SECUREBOOT_CRYPTO */
 
+/* sha1/sha256 of the hash_algo table on the crypto engine, software when it can't */
+#ifdef CONFIG_SECUREBOOT_CRYPTO
+	#define CONFIG_SHA_HW_ACCEL
+	#define CONFIG_SHA1
+	#define CONFIG_SHA256
+#endif
+
 
 /* mod it to enable console commands.	*/
 #define CONFIG_BOOTDELAY		0
@@ -83,11 +83,26 @@
 
 /*
  * cache config
+ * write-back L1 and L2, the dma drivers do their own cache maintenance.
+ * CONFIG_RK_CACHE_WRITETHROUGH goes back to the write-through setup.
  */
 #undef CONFIG_SYS_ICACHE_OFF
 #undef CONFIG_SYS_DCACHE_OFF
-#define CONFIG_SYS_L2CACHE_OFF
-#define CONFIG_SYS_ARM_CACHE_WRITETHROUGH
+#undef CONFIG_RK_CACHE_WRITETHROUGH
+#ifdef CONFIG_RK_CACHE_WRITETHROUGH
+	#define CONFIG_SYS_L2CACHE_OFF
+	#define CONFIG_SYS_ARM_CACHE_WRITETHROUGH
+#endif
+
+/* arch string routines: ldm/stm with pld on armv7, ldp/stp with prfm on armv8 */
+#define CONFIG_USE_ARCH_MEMCPY
+#define CONFIG_USE_ARCH_MEMSET
+#define CONFIG_USE_ARCH_MEMMOVE
+
+/*
+ * rkbench command: string routine self-check, memcpy/inflate/sha throughput.
+ * Not in the product builds, rk3128_bench_defconfig turns it on.
+ */
 
 
 /* irq config, arch64 gic no using CONFIG_USE_IRQ */
@@ -95,9 +110,24 @@
 	#define CONFIG_USE_IRQ
 #endif
 
+/* cooperative tasks, delay-bound init overlaps the rest of the boot */
+#define CONFIG_RK_TASK
+
+/* secondary cores as boot workers, parked again before the kernel starts */
+#define CONFIG_RK_SMP
+
 /* enable imprecise aborts check, default disable */
 #undef CONFIG_IMPRECISE_ABORTS_CHECK
 
+/*
+ * boot time profiling: stage times and throughput go to the kernel as
+ * loader.bootstage= and /chosen/u-boot,bootstage, "bootstage report" prints them.
+ */
+#define CONFIG_BOOTSTAGE
+#define CONFIG_BOOTSTAGE_FDT
+#define CONFIG_CMD_BOOTSTAGE
+#undef CONFIG_BOOTSTAGE_REPORT
+
 
 /*
  * Enabling relocation of u-boot by default
@@ -247,6 +277,21 @@
  */
 #define CONFIG_FASTBOOT_TRANSFER_BUFFER_SIZE		CONFIG_RK_BOOT_BUFFER_SIZE
 #define CONFIG_FASTBOOT_TRANSFER_BUFFER_SIZE_EACH	(CONFIG_FASTBOOT_TRANSFER_BUFFER_SIZE >> 1)
+/* accelerated download: received data is written to storage once this much is pending */
+#define CONFIG_FASTBOOT_FLASH_COMMIT_SIZE		(SZ_512K)
+
+/* sparse image: small chunks are staged and fill chunks expanded in buffers of this size */
+#define CONFIG_RK_SPARSE_WRITE_BUF_SIZE			(SZ_256K)
+
+/* storage: lru cache of small lba reads, lines of sectors with sequential read-ahead */
+#define CONFIG_RK_STORAGE_CACHE
+#define CONFIG_RK_STORAGE_CACHE_LINES			32
+#define CONFIG_RK_STORAGE_CACHE_LINE_SECS		8
+#define CONFIG_RK_STORAGE_CACHE_READAHEAD		8	/* max lines fetched by one read */
+
+/* fs: fat/ext4 stay mounted between the fs commands on the same partition */
+#define CONFIG_FS_MOUNT_CACHE
+#define CONFIG_FS_FAT_WINDOW_SIZE		(256 << 10)	/* fat table cached by the reader */
 
 
 /*
@@ -279,6 +324,24 @@
 #undef CONFIG_BOOTRK_RK_IMAGE_CHECK
 #undef CONFIG_BOOTRK_OTA_IMAGE_CHECK
 
+/* software sha1/sha256 on neon or v8 crypto extension, probed at run time */
+#define CONFIG_RK_SHA_NEON
+
+/* boot image is read in chunks of this size, the image sha is updated per chunk */
+#define CONFIG_BOOTRK_LOAD_CHUNK_SIZE	SZ_2M
+
+/* inflate a gzip kernel chunk by chunk while it is read from boot image */
+#define CONFIG_BOOTRK_KERNEL_UNZIP
+#ifdef CONFIG_BOOTRK_KERNEL_UNZIP
+#define CONFIG_GZIP
+#define CONFIG_ZLIB
+#endif
+#ifdef CONFIG_CMD_RKBENCH
+#define CONFIG_GZIP
+#define CONFIG_ZLIB
+#define CONFIG_GZIP_COMPRESSED
+#endif
+
 
 /*
  * USB Host support, default no using
@@ -314,6 +377,7 @@
 
 /* rockusb */
 #define CONFIG_CMD_ROCKUSB
+#define CONFIG_ROCKUSB_RX_QUEUE		16	/* 64KB download slots the usb fills ahead of the media */
 
 
 /* fastboot */
@@ -391,6 +455,8 @@
 /* rk dma config */
 #define CONFIG_RK_PL330		/* rk dma pl330 */
 #define CONFIG_RK_DMAC		/* rk dmac */
+#define CONFIG_RK_DMA_MEMCPY	/* kernel/ramdisk moves at boot on the dmac */
+#define CONFIG_RK_DMA_MEMCPY_MIN	(256 << 10)	/* smaller copies stay on the cpu */
 
 /* rk display module */
 #ifdef CONFIG_LCD
@@ -412,6 +478,9 @@
 #undef CONFIG_COMPRESS_LOGO_RLE8
 #undef CONFIG_COMPRESS_LOGO_RLE16
 
+/* lz4 packed bmps in resource.img, see resource_tool --lz4 */
+#define CONFIG_LZ4
+
 #define CONFIG_BMP_16BPP
 #define CONFIG_BMP_24BPP
 #define CONFIG_BMP_32BPP
@@ -431,6 +500,9 @@
 /* rk lcd total size = fb size + kernel logo size */
 #define CONFIG_RK_LCD_SIZE		SZ_32M
 #define CONFIG_RK_FB_SIZE		SZ_16M
+
+/* charge animation frames decoded once into the kernel logo space */
+#define CONFIG_CHARGE_FRAME_CACHE
 #endif
 
 #define CONFIG_BRIGHTNESS_DIM		64
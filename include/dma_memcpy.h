@@ -0,0 +1,34 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef __DMA_MEMCPY_H__
+#define __DMA_MEMCPY_H__
+
+/*
+ * Large memory copies offloaded to a dma engine.
+ *
+ * dma_memcpy_async() queues the copy and returns, the cpu may go on with
+ * anything that touches neither buffer. dma_wait() returns once every
+ * queued copy has landed, with the destinations coherent for the cpu.
+ * Copies the engine can't take (small, misaligned, overlapping) are done
+ * with memmove before dma_memcpy_async() returns, so it is a drop-in for
+ * memmove as long as dma_wait() comes before the data is used.
+ */
+#ifdef CONFIG_RK_DMA_MEMCPY
+void dma_memcpy_async(void *dst, const void *src, size_t len);
+int dma_wait(void);
+#else
+static inline void dma_memcpy_async(void *dst, const void *src, size_t len)
+{
+	memmove(dst, src, len);
+}
+
+static inline int dma_wait(void)
+{
+	return 0;
+}
+#endif
+
+#endif /* __DMA_MEMCPY_H__ */
@@ -141,8 +141,11 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot);
 int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len, char *buf);
 void ext4fs_set_blk_dev(block_dev_desc_t *rbdd, disk_partition_t *info);
 long int read_allocated_block(struct ext2_inode *inode, int fileblock);
+long int read_allocated_run(struct ext2_inode *inode, int fileblock,
+			    int *count);
 int ext4fs_probe(block_dev_desc_t *fs_dev_desc,
 		 disk_partition_t *fs_partition);
 int ext4_read_file(const char *filename, void *buf, int offset, int len);
 int ext4_read_superblock(char *buffer);
+int ext4fs_mounted(block_dev_desc_t *dev_desc, disk_partition_t *info);
 #endif
@@ -116,9 +116,10 @@ typedef struct sparse_header {
 #define CHUNK_TYPE_RAW      0xCAC1
 #define CHUNK_TYPE_FILL     0xCAC2
 #define CHUNK_TYPE_DONT_CARE    0xCAC3
+#define CHUNK_TYPE_CRC32        0xCAC4
 
 typedef struct chunk_header {
-	__le16    chunk_type; /* 0xCAC1 -> raw; 0xCAC2 -> fill; 0xCAC3 -> don't care */
+	__le16    chunk_type; /* 0xCAC1 -> raw; 0xCAC2 -> fill; 0xCAC3 -> don't care; 0xCAC4 -> crc32 */
 	__le16    reserved1;
 	__le32    chunk_sz;   /* in blocks in output image */
 	__le32    total_sz;   /* in bytes of chunk input file including chunk header and data */
@@ -128,6 +129,7 @@ typedef struct chunk_header {
 
 /* Following a Raw or Fill chunk is data.  For a Raw chunk, it's the data in chunk_sz * blk_sz.
  *  For a Fill chunk, it's 4 bytes of the fill data.
+ *  For a Crc32 chunk, it's 4 bytes of the crc32 of all output data so far.
  */
 /* end sparse things */
 
@@ -179,9 +181,9 @@ struct cmd_fastboot_interface {
 	/* Offset of storage, will download 'd_direct_size' data to this offset */
 	u64 d_direct_offset;
 
-	/* May cache some data here. */
-	unsigned char d_cache[USB_MAX_TRANS_SIZE + RK_BLK_SIZE];
-	int d_cache_pos;
+	/* Received data not written to storage yet, kept in place in the receive ring. */
+	unsigned char *d_pending;
+	int d_pending_len;
 
 	/* Upload size, if download has to be done */
 	u64 u_size;
@@ -33,6 +33,11 @@
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
 
+/* FAT window of the reader, the whole FAT when it fits */
+#ifndef CONFIG_FS_FAT_WINDOW_SIZE
+#define CONFIG_FS_FAT_WINDOW_SIZE	(FATBUFBLOCKS * 512)
+#endif
+
 
 /* Filesystem identifiers */
 #define FAT12_SIGN	"FAT12   "
@@ -174,6 +179,10 @@ typedef struct {
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
 	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	__u32	fatbufblocks;	/* Size of fatbuf in sectors */
+	__u32	run_start;	/* get_contents: first cluster of the last file */
+	__u32	run_clust;	/* read, the last cluster read of it */
+	__u32	run_idx;	/* and its index in the chain */
 } fsdata;
 
 typedef int	(file_detectfs_func)(void);
@@ -93,4 +93,20 @@ int file_exists(const char *dev_type, const char *dev_part, const char *file,
 int do_save(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 		int fstype);
 
+/*
+ * Tell the filesystems kept mounted by CONFIG_FS_MOUNT_CACHE that the
+ * media may have changed under them: block drivers call it on raw writes,
+ * erases and device (re)scans. A mount made before fs_media_gen moved on
+ * is dropped by the next probe, nothing is freed from in here.
+ */
+#if defined(CONFIG_FS_MOUNT_CACHE) && !defined(CONFIG_SPL_BUILD)
+extern unsigned int fs_media_gen;
+void fs_invalidate_mounts(void);
+#else
+#define fs_media_gen	0
+static inline void fs_invalidate_mounts(void)
+{
+}
+#endif
+
 #endif /* _FS_H */
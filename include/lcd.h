@@ -380,6 +380,11 @@ int	lcd_display_bitmap(ulong bmp_image, int x, int y);
 int lcd_display_bitmap_center(ulong bmp_image);
 void lcd_enable_logo(bool enable);
 void lcd_enable_flip(bool enable);
+#ifdef CONFIG_RK_FB
+int lcd_decode_frame(ulong bmp_image, void *buf, size_t len,
+		struct fb_dsp_info *info);
+void lcd_show_frame(struct fb_dsp_info *info);
+#endif
 #endif
 
 /**
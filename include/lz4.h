@@ -0,0 +1,18 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef __LZ4_H__
+#define __LZ4_H__
+
+#define LZ4_MIN_MATCH		4
+
+/*
+ * Decode one lz4 block (no frame header) from src into dst.
+ * Returns the decoded size, or -1 if the block is corrupt or doesn't fit.
+ */
+int lz4_decompress_block(const void *src, size_t srclen,
+			 void *dst, size_t dstlen);
+
+#endif /* __LZ4_H__ */
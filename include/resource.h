@@ -36,16 +36,30 @@ typedef struct {
 	void*    load_addr;
 } resource_content;
 
+//sync with tools/resource_tool/resource_tool.h
+#define RESOURCE_LZ4_MAGIC          "RKLZ"
+typedef struct {
+	char     magic[4];//tag, "RKLZ"
+	uint32_t raw_size;//bytes, size of decoded content.
+	uint32_t data_size;//bytes, size of lz4 block following this header.
+	uint32_t reserved;
+} resource_lz4_header;
+
 
 bool get_content(int base_offset, resource_content* content);
 void free_content(resource_content* content);
 bool load_content(resource_content* content);
 bool load_content_data(resource_content* content,
         int offset_block, void* data, int blocks);
+bool load_contents(int base_offset, resource_content* contents, int num,
+		void* buf, size_t len);
 
 bool get_content_ram(void *buf, size_t len,
 		resource_content* content);
 
+bool is_content_packed(const void* data);
+void* unpack_content(void* data, size_t size, void* buf, size_t len);
+
 bool show_resource_image(const char* image_path);
 
 #endif //RESOURCE_H
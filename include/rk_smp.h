@@ -0,0 +1,71 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef __RK_SMP_H__
+#define __RK_SMP_H__
+
+/*
+ * Boot work on the secondary cores.
+ *
+ * rk_smp_init() releases the secondary cores into a worker loop, each on
+ * its own stack and coherent with cpu0. It needs the caches and malloc up
+ * and only does its work once; the first rk_smp_submit() calls it, so a
+ * boot that never submits a job leaves the cores in reset.
+ * rk_smp_submit() hands a job to an idle core, or runs it right there when no core is free, so callers
+ * don't care how many cores came up. rk_smp_wait() returns once the job
+ * has run, with its results visible to cpu0.
+ *
+ * A job runs beside cpu0: it may only compute on memory cpu0 leaves alone
+ * meanwhile. No printf, malloc, timer, storage or other driver calls.
+ *
+ * rk_smp_park() puts the cores back in reset before the kernel starts,
+ * the kernel brings them up through the bootrom mailbox as after a reset.
+ */
+/*
+ * Section attribute the dram mapping needs while the workers can run: the
+ * a7 only keeps shareable memory coherent between the cores. OR it into
+ * any dcache option dram is remapped with.
+ */
+#ifdef CONFIG_RK_SMP
+#define RK_SMP_SECT_SHARED	(1 << 16)	/* TTB section S bit */
+#else
+#define RK_SMP_SECT_SHARED	0
+#endif
+
+struct rk_smp_job {
+	void (*fn)(void *arg);
+	void *arg;
+
+	/* set by rk_smp_submit(), cleared once fn has returned */
+	volatile int busy;
+};
+
+#ifdef CONFIG_RK_SMP
+int rk_smp_init(void);
+void rk_smp_submit(struct rk_smp_job *job);
+void rk_smp_wait(struct rk_smp_job *job);
+void rk_smp_park(void);
+#else
+static inline int rk_smp_init(void)
+{
+	return 0;
+}
+
+static inline void rk_smp_submit(struct rk_smp_job *job)
+{
+	job->fn(job->arg);
+	job->busy = 0;
+}
+
+static inline void rk_smp_wait(struct rk_smp_job *job)
+{
+}
+
+static inline void rk_smp_park(void)
+{
+}
+#endif
+
+#endif /* __RK_SMP_H__ */
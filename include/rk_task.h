@@ -0,0 +1,80 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+#ifndef __RK_TASK_H__
+#define __RK_TASK_H__
+
+#include <linux/list.h>
+
+/*
+ * Cooperative tasks for delay-bound init.
+ *
+ * A task is a step() function called again and again until it is done:
+ * each call does one piece of the init and returns the usecs to wait
+ * before the next call, or 0 once the task is finished. task->state is
+ * 0 on the first call, step() keeps its progress there.
+ *
+ * Steps only run from rk_task_yield(), rk_task_mdelay() and rk_task_wait(),
+ * never from an interrupt or from inside another driver's udelay(), so a
+ * step may use any driver that is not half way through a transfer at
+ * those points. Hardware wait loops call them so the waits of the other
+ * inits overlap with theirs.
+ *
+ * Without CONFIG_RK_TASK rk_task_start() runs the task to completion.
+ */
+struct rk_task {
+	const char *name;
+	ulong (*step)(struct rk_task *task);
+	int state;
+	void *priv;
+
+	/* scheduler private */
+	ulong wake_us;
+	struct list_head list;
+};
+
+#ifdef CONFIG_RK_TASK
+/* run the first step now, queue the task if it is not done by then */
+void rk_task_start(struct rk_task *task);
+/* run the steps that are due */
+void rk_task_yield(void);
+/* wait msec, running the steps that come due meanwhile */
+void rk_task_mdelay(ulong msec);
+/*
+ * run steps until the task is done, returns at once if it is not queued.
+ * Not for use in a step, steps don't nest.
+ */
+void rk_task_wait(struct rk_task *task);
+/* run steps until no task is left */
+void rk_task_wait_all(void);
+#else
+static inline void rk_task_start(struct rk_task *task)
+{
+	ulong us;
+
+	task->state = 0;
+	while ((us = task->step(task)) != 0)
+		udelay(us);
+}
+
+static inline void rk_task_yield(void)
+{
+}
+
+static inline void rk_task_mdelay(ulong msec)
+{
+	mdelay(msec);
+}
+
+static inline void rk_task_wait(struct rk_task *task)
+{
+}
+
+static inline void rk_task_wait_all(void)
+{
+}
+#endif
+
+#endif /* __RK_TASK_H__ */
@@ -70,6 +70,19 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
  */
 void sha1_finish( sha1_context *ctx, unsigned char output[20] );
 
+/**
+ * \brief	   Hash whole blocks with a cpu accelerated implementation
+ *
+ * \param state    SHA-1 intermediate digest state
+ * \param data     input blocks, 64 bytes each
+ * \param blocks   number of blocks
+ *
+ * \return	   number of blocks hashed, 0 if no accelerator is present.
+ *		   The default does nothing, platforms override it.
+ */
+int sha1_accel_blocks(uint32_t state[5], const unsigned char *data,
+		      unsigned int blocks);
+
 /**
  * \brief	   Output = SHA-1( input buffer )
  *
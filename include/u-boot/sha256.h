@@ -16,6 +16,14 @@ void sha256_starts(sha256_context * ctx);
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length);
 void sha256_finish(sha256_context * ctx, uint8_t digest[SHA256_SUM_LEN]);
 
+/*
+ * Hash whole 64 bytes blocks with a cpu accelerated implementation, returns
+ * the number of blocks hashed, 0 if no accelerator is present. The default
+ * does nothing, platforms override it.
+ */
+int sha256_accel_blocks(uint32_t state[8], const uint8_t *data,
+			unsigned int blocks);
+
 void sha256_csum_wd(const unsigned char *input, unsigned int ilen,
 		unsigned char *output, unsigned int chunk_sz);
 
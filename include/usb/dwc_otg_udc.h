@@ -41,6 +41,7 @@ void udc_connect(void);
 void udc_disconnect(void);
 void udc_startup_events(struct usb_device_instance *device);
 void resume_usb(struct usb_endpoint_instance *endpoint, int max_size);
+void udc_set_rx_refill(int (*refill)(struct urb *urb));
 int is_usbd_high_speed(void);
 
 uint32_t GetVbus(void);
@@ -0,0 +1,90 @@
+/*
+ * (C) Copyright 2008-2015 Rockchip Electronics
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <lz4.h>
+
+/*
+ * LZ4 block format decoder, for the images resource_tool packs with
+ * --lz4. Literal runs and matches go through memcpy (the arch one on
+ * rockchip), a match closer than its length is copied one period at a
+ * time; only periods under 8 bytes fall back to a byte loop. No access
+ * outside [src, src + srclen) or [dst, dst + dstlen) is made, so a
+ * corrupt block fails instead of scribbling over memory.
+ */
+static inline int lz4_get_len(const u8 **ip, const u8 *iend, size_t *len)
+{
+	u8 b;
+
+	do {
+		if (*ip >= iend)
+			return -1;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+
+	return 0;
+}
+
+int lz4_decompress_block(const void *src, size_t srclen,
+			 void *dst, size_t dstlen)
+{
+	const u8 *ip = src, *iend = ip + srclen;
+	u8 *op = dst, *oend = op + dstlen;
+	const u8 *match;
+	size_t len, off;
+	u8 token;
+
+	while (ip < iend) {
+		token = *ip++;
+
+		/* literals */
+		len = token >> 4;
+		if (len == 15 && lz4_get_len(&ip, iend, &len))
+			return -1;
+		if (len > (size_t)(iend - ip) || len > (size_t)(oend - op))
+			return -1;
+		memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		/* the last sequence has no match */
+		if (ip == iend)
+			break;
+
+		/* match */
+		if (iend - ip < 2)
+			return -1;
+		off = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (off == 0 || off > (size_t)(op - (u8 *)dst))
+			return -1;
+		match = op - off;
+
+		len = token & 15;
+		if (len == 15 && lz4_get_len(&ip, iend, &len))
+			return -1;
+		len += LZ4_MIN_MATCH;
+		if (len > (size_t)(oend - op))
+			return -1;
+
+		if (off < 8) {
+			while (len--)
+				*op++ = *match++;
+		} else {
+			while (len > off) {
+				memcpy(op, match, off);
+				op += off;
+				match += off;
+				len -= off;
+			}
+			memcpy(op, match, len);
+			op += len;
+		}
+	}
+
+	return op - (u8 *)dst;
+}
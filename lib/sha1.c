@@ -227,6 +227,37 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	ctx->state[4] += E;
 }
 
+#ifndef USE_HOSTCC
+__weak int sha1_accel_blocks(uint32_t state[5], const unsigned char *data,
+			     unsigned int blocks)
+{
+	return 0;
+}
+#endif
+
+static void sha1_blocks(sha1_context *ctx, const unsigned char *data,
+			unsigned int blocks)
+{
+#ifndef USE_HOSTCC
+	uint32_t state[5];
+	unsigned int i, done;
+
+	/* state is unsigned long, which is not 32 bits on every arch */
+	for (i = 0; i < 5; i++)
+		state[i] = ctx->state[i];
+	done = sha1_accel_blocks(state, data, blocks);
+	for (i = 0; i < 5; i++)
+		ctx->state[i] = state[i];
+
+	data += done * 64;
+	blocks -= done;
+#endif
+	while (blocks--) {
+		sha1_process(ctx, data);
+		data += 64;
+	}
+}
+
 /*
  * SHA-1 process buffer
  */
@@ -250,16 +281,16 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_blocks(ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sha1_blocks(ctx, input, ilen / 64);
+		input += ilen & ~0x3F;
+		ilen &= 0x3F;
 	}
 
 	if (ilen > 0) {
@@ -0,0 +1,152 @@
+#include "lz4.h"
+
+/*
+ * Plain lz4 block format (no frame header), greedy matching over a 64K
+ * window. Good enough for bmps, which are mostly flat color.
+ */
+#define HASH_LOG                    16
+#define LAST_LITERALS               5
+#define MF_LIMIT                    12
+#define MAX_OFFSET                  65535
+
+static inline uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t hash32(uint32_t v) {
+    return (v * 2654435761U) >> (32 - HASH_LOG);
+}
+
+static uint8_t* write_len(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+static uint8_t* write_literals(uint8_t* op, const uint8_t* anchor,
+        size_t len, size_t match_len) {
+    uint8_t* token = op++;
+    *token = (len >= 15 ? 15 : len) << 4;
+    *token |= match_len >= 15 ? 15 : match_len;
+    if (len >= 15)
+        op = write_len(op, len - 15);
+    memcpy(op, anchor, len);
+    return op + len;
+}
+
+size_t lz4_compress_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t lz4_compress_block(const void* src, size_t src_len, void* dst) {
+    const uint8_t* base = (const uint8_t*)src;
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    const uint8_t* iend = base + src_len;
+    uint8_t* op = (uint8_t*)dst;
+    uint32_t* table = NULL;
+
+    if (src_len > MF_LIMIT) {
+        const uint8_t* mflimit = iend - MF_LIMIT;
+        const uint8_t* matchlimit = iend - LAST_LITERALS;
+
+        table = (uint32_t*)calloc(1 << HASH_LOG, sizeof(uint32_t));
+        if (!table)
+            return 0;
+
+        while (ip < mflimit) {
+            uint32_t h = hash32(read32(ip));
+            const uint8_t* ref = base + table[h];
+            table[h] = ip - base;
+            if (ref >= ip || ip - ref > MAX_OFFSET
+                    || read32(ref) != read32(ip)) {
+                ip++;
+                continue;
+            }
+
+            //extend backward into the pending literals, then forward.
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t* p = ip + LZ4_MIN_MATCH;
+            const uint8_t* r = ref + LZ4_MIN_MATCH;
+            while (p < matchlimit && *p == *r) {
+                p++;
+                r++;
+            }
+
+            size_t match_len = p - ip - LZ4_MIN_MATCH;
+            size_t offset = ip - ref;
+            op = write_literals(op, anchor, ip - anchor, match_len);
+            *op++ = offset & 0xff;
+            *op++ = offset >> 8;
+            if (match_len >= 15)
+                op = write_len(op, match_len - 15);
+            ip = anchor = p;
+        }
+        free(table);
+    }
+
+    //last literals, token without match.
+    op = write_literals(op, anchor, iend - anchor, 0);
+    return op - (uint8_t*)dst;
+}
+
+//same checks as the u-boot decoder, for unpacking.
+int lz4_decompress_block(const void* src, size_t src_len,
+        void* dst, size_t dst_len) {
+    const uint8_t* ip = (const uint8_t*)src;
+    const uint8_t* iend = ip + src_len;
+    uint8_t* op = (uint8_t*)dst;
+    uint8_t* oend = op + dst_len;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t len = token >> 4;
+        uint8_t b;
+        if (len == 15) {
+            do {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        if (len > (size_t)(iend - ip) || len > (size_t)(oend - op))
+            return -1;
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (!offset || offset > (size_t)(op - (uint8_t*)dst))
+            return -1;
+        len = token & 15;
+        if (len == 15) {
+            do {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        len += LZ4_MIN_MATCH;
+        if (len > (size_t)(oend - op))
+            return -1;
+        const uint8_t* match = op - offset;
+        while (len--)
+            *op++ = *match++;
+    }
+    return op - (uint8_t*)dst;
+}
@@ -0,0 +1,14 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include "common.h"
+
+//sync with ./lib/lz4.c
+#define LZ4_MIN_MATCH               4
+
+size_t lz4_compress_bound(size_t size);
+size_t lz4_compress_block(const void* src, size_t src_len, void* dst);
+int lz4_decompress_block(const void* src, size_t src_len,
+        void* dst, size_t dst_len);
+
+#endif //LZ4_H
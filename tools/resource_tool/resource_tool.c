@@ -1,4 +1,5 @@
 #include "resource_tool.h"
+#include "lz4.h"
 #include <sys/stat.h>
 #include <time.h>
 #include <errno.h>
@@ -6,6 +7,7 @@
 static const char* PROG = NULL;
 static resource_ptn_header header;
 static bool just_print = false;
+static bool pack_lz4 = false;
 char image_path[MAX_INDEX_ENTRY_PATH_LEN] = "\0";
 char root_path[MAX_INDEX_ENTRY_PATH_LEN] = "\0";
 
@@ -26,6 +28,7 @@ static void usage() {
     printf("\t" OPT_HELP    "\t\t\tDisplay this information.\n");
     printf("\t" OPT_VERSION "\t\tDisplay version information.\n");
     printf("\t" OPT_ROOT "path" "\t\tSpecify resources' root dir.\n");
+    printf("\t" OPT_LZ4     "\t\t\tPack " LZ4_PACK_SUBFIX " files with lz4.\n");
 }
 
 static int pack_image(int file_num, const char** files);
@@ -70,6 +73,8 @@ int main(int argc, char** argv) {
             return 0;
         } else if (!strcmp(OPT_PRINT, arg)) {
             just_print = true;
+        } else if (!strcmp(OPT_LZ4, arg)) {
+            pack_lz4 = true;
         } else if (!strcmp(OPT_PACK, arg)) {
             action = ACTION_PACK;
         } else if (!strcmp(OPT_UNPACK, arg)) {
@@ -161,6 +166,12 @@ void fix_entry(index_tbl_entry* entry) {
     entry->content_size = switch_int(entry->content_size);
 }
 
+void fix_lz4_header(resource_lz4_header* header) {
+    //switch for be.
+    header->raw_size = switch_int(header->raw_size);
+    header->data_size = switch_int(header->data_size);
+}
+
 
 /************unpack code****************/
 static bool mkdirs(char* path) {
@@ -182,6 +193,41 @@ static bool mkdirs(char* path) {
     return ret;
 }
 
+//unpack lz4 packed content to its original file.
+static bool dump_lz4_data(FILE* file, FILE* out_file, index_tbl_entry entry) {
+    bool ret = false;
+    resource_lz4_header hdr;
+    char* data = NULL;
+    char* raw = NULL;
+
+    if (!fread(&hdr, sizeof(hdr), 1, file))
+        goto end;
+    fix_lz4_header(&hdr);
+    if (hdr.data_size > entry.content_size - sizeof(hdr))
+        goto end;
+    data = (char*)malloc(hdr.data_size);
+    raw = (char*)malloc(hdr.raw_size);
+    if (!data || !raw)
+        goto end;
+    if (hdr.data_size && !fread(data, hdr.data_size, 1, file))
+        goto end;
+    if (lz4_decompress_block(data, hdr.data_size, raw, hdr.raw_size)
+            != hdr.raw_size) {
+        LOGE("Corrupt lz4 content:%s", entry.path);
+        goto end;
+    }
+    if (hdr.raw_size && !fwrite(raw, hdr.raw_size, 1, out_file)) {
+        LOGE("Failed to write:%s", entry.path);
+        goto end;
+    }
+    LOGD("unpacked %s: %d -> %d", entry.path, entry.content_size, hdr.raw_size);
+    ret = true;
+end:
+    free(data);
+    free(raw);
+    return ret;
+}
+
 static bool dump_file(FILE* file, const char* unpack_dir,
         index_tbl_entry entry) {
     LOGD("try to dump entry:%s", entry.path);
@@ -211,6 +257,18 @@ static bool dump_file(FILE* file, const char* unpack_dir,
     char buf[BLOCK_SIZE];
     int n;
     int len = entry.content_size;
+    if (len >= sizeof(resource_lz4_header)) {
+        if (!fread(buf, sizeof(resource_lz4_header), 1, file)) {
+            LOGE("Failed to read content:%s", entry.path);
+            goto end;
+        }
+        fseek(file, offset, SEEK_SET);
+        if (!memcmp(buf, RESOURCE_LZ4_MAGIC, 4)) {
+            if (!dump_lz4_data(file, out_file, entry))
+                goto end;
+            len = 0;
+        }
+    }
     while (len > 0) {
         n = len > BLOCK_SIZE ? BLOCK_SIZE : len;
         if (!fread(buf, n, 1, file)) {
@@ -366,6 +424,53 @@ end:
     return ret;
 }
 
+//pack file with lz4 if that saves blocks, returns packed size or 0.
+static size_t write_lz4_file(int offset_block, const char* src_path,
+        size_t file_size) {
+    size_t ret = 0;
+    char* raw = NULL;
+    char* data = NULL;
+    resource_lz4_header hdr;
+    FILE* src_file = fopen(src_path, "rb");
+    if (!src_file) {
+        LOGE("Failed to open:%s", src_path);
+        goto end;
+    }
+    raw = (char*)malloc(file_size);
+    data = (char*)malloc(sizeof(hdr) + lz4_compress_bound(file_size));
+    if (!raw || !data)
+        goto end;
+    if (file_size && !fread(raw, file_size, 1, src_file)) {
+        LOGE("Failed to read:%s", src_path);
+        goto end;
+    }
+    if (!memcmp(raw, RESOURCE_LZ4_MAGIC, 4))
+        goto end;
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, RESOURCE_LZ4_MAGIC, sizeof(hdr.magic));
+    hdr.raw_size = file_size;
+    hdr.data_size = lz4_compress_block(raw, file_size, data + sizeof(hdr));
+    if (!hdr.data_size || fix_blocks(sizeof(hdr) + hdr.data_size)
+            >= fix_blocks(file_size))
+        goto end;
+
+    LOGD("lz4 packed %s: %d -> %d", src_path, (int)file_size,
+            (int)(sizeof(hdr) + hdr.data_size));
+    ret = sizeof(hdr) + hdr.data_size;
+    //switch for le.
+    fix_lz4_header(&hdr);
+    memcpy(data, &hdr, sizeof(hdr));
+    if (!write_data(offset_block, data, ret))
+        ret = 0;
+end:
+    if (src_file)
+        fclose(src_file);
+    free(raw);
+    free(data);
+    return ret;
+}
+
 static bool write_header(const int file_num) {
     LOGD("try to write header...");
     memcpy(header.magic, RESOURCE_PTN_HDR_MAGIC, sizeof(header.magic));
@@ -398,8 +503,18 @@ static bool write_index_tbl(const int file_num, const char** files) {
         entry.content_size = file_size;
         entry.content_offset = offset;
 
-        if (write_file(offset, files[i]) < 0)
+        size_t packed_size = 0;
+        if (pack_lz4 && strlen(files[i]) > strlen(LZ4_PACK_SUBFIX)
+                && !strcmp(files[i] + strlen(files[i]) - strlen(LZ4_PACK_SUBFIX),
+                    LZ4_PACK_SUBFIX)) {
+            packed_size = write_lz4_file(offset, files[i], file_size);
+        }
+        if (packed_size) {
+            file_size = packed_size;
+            entry.content_size = file_size;
+        } else if (write_file(offset, files[i]) < 0) {
             goto end;
+        }
 
         LOGD("try to write index entry(%s)...", files[i]);
 
@@ -37,6 +37,16 @@ typedef struct {
     uint32_t content_size;//bytes, size of resource content.
 } index_tbl_entry;
 
+//sync with ./include/resource.h
+#define RESOURCE_LZ4_MAGIC          "RKLZ"
+#define LZ4_PACK_SUBFIX             ".bmp"
+typedef struct {
+    char     magic[4];//tag, "RKLZ"
+    uint32_t raw_size;//bytes, size of decoded content.
+    uint32_t data_size;//bytes, size of lz4 block following this header.
+    uint32_t reserved;
+} resource_lz4_header;
+
 #define OPT_VERBOSE         "--verbose"
 #define OPT_HELP            "--help"
 #define OPT_VERSION         "--version"
@@ -47,6 +57,7 @@ typedef struct {
 #define OPT_TEST_CHARGE     "--test_charge"
 #define OPT_IMAGE           "--image="
 #define OPT_ROOT            "--root="
+#define OPT_LZ4             "--lz4"
 
 #define VERSION             "2014-5-31 14:43:42"
 